@@ -0,0 +1,425 @@
+// Microbenchmarks of the executor's hot paths, with heap allocations counted per operation:
+// signing, URL encoding, order query strings, response decoding (DOM against the typed SAX
+// decoders, on recorded responses), the CSV readers, parseDateTime and TimedEventQueue.
+//
+//   executioner_bench [--fixtures bench/fixtures] [--filter name] [--scale 1] [--json results.json]
+//
+// --filter runs the benchmarks whose name contains it, --scale multiplies the iterations.
+// --json writes {"benchmarks": [{"name", "iterations", "ns_per_op", "allocs_per_op",
+// "bytes_per_op", ...}]} for comparing two builds. queue/fire_lag reports the delay between
+// an event's timestamp and its callback instead of a per-operation cost.
+
+#include "../modules/Blackout/headers/blackout.h"
+#include "../modules/Decode/headers/decode.h"
+#include "../modules/Http/headers/signedrequest.h"
+#include "../modules/News/headers/news.h"
+#include "../modules/Order/models/OrderInput/OrderInput.h"
+#include "../modules/Signaling/headers/signaling.h"
+#include "../modules/TimedEventQueue/headers/TimedEventQueue.hpp"
+#include "../modules/Utils/headers/hmac.h"
+#include "../modules/Utils/headers/utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+    std::atomic<uint64_t> allocationCount{0};
+    std::atomic<uint64_t> allocationBytes{0};
+}
+
+// Every allocation of the process is counted, benchmarks read the difference
+void *operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+// Out of line, GCC takes an inlined free() for a mismatch with the new expression
+[[gnu::noinline]] void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept {
+    ::operator delete(memory);
+}
+
+namespace {
+    struct Options {
+        std::string fixtures = "bench/fixtures";
+        std::string filter;
+        double scale = 1;
+        std::string jsonPath;
+    };
+
+    struct Result {
+        std::string name;
+        long iterations = 0;
+        double nsPerOp = 0;
+        double allocsPerOp = 0;
+        double bytesPerOp = 0;
+        std::vector<std::pair<std::string, double>> extra;
+    };
+
+    Options options;
+    std::vector<Result> results;
+
+    // Keeps the optimizer from dropping the work
+    volatile double sink;
+
+    bool selected(const std::string &name) {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    long scaled(long iterations) {
+        return std::max(1L, static_cast<long>(static_cast<double>(iterations) * options.scale));
+    }
+
+    void report(const Result &result) {
+        std::cout << std::left << std::setw(34) << result.name << std::right
+                  << std::setw(10) << result.iterations
+                  << std::setw(12) << std::fixed << std::setprecision(1) << result.nsPerOp << " ns"
+                  << std::setw(9) << std::setprecision(2) << result.allocsPerOp << " allocs"
+                  << std::setw(10) << std::setprecision(0) << result.bytesPerOp << " B";
+        for (const auto &[key, value]: result.extra) {
+            std::cout << "  " << key << "=" << std::setprecision(0) << value;
+        }
+        std::cout << std::defaultfloat << std::endl;
+        results.push_back(result);
+    }
+
+    // `fn` returns something derived from its work, a tenth of the iterations warms up
+    template<typename Fn>
+    void measure(const std::string &name, long iterations, Fn &&fn) {
+        if (!selected(name)) {
+            return;
+        }
+        iterations = scaled(iterations);
+        for (long i = 0; i < iterations / 10 + 1; ++i) {
+            sink = static_cast<double>(fn());
+        }
+
+        uint64_t allocations = allocationCount.load();
+        uint64_t bytes = allocationBytes.load();
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; ++i) {
+            sink = static_cast<double>(fn());
+        }
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+        auto count = static_cast<double>(iterations);
+        report({name, iterations, elapsed.count() / count,
+                static_cast<double>(allocationCount.load() - allocations) / count,
+                static_cast<double>(allocationBytes.load() - bytes) / count, {}});
+    }
+
+    std::string readFixture(const std::string &name) {
+        std::ifstream file(options.fixtures + "/" + name, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Missing fixture " + options.fixtures + "/" + name);
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    std::string dateTime(std::chrono::system_clock::time_point time) {
+        std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+        std::tm tm{};
+        localtime_r(&seconds, &tm);
+        char text[32];
+        std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &tm);
+        return text;
+    }
+
+    // Hourly rows cycling through `symbols`, like the signal export
+    std::string signalCsv(size_t rows, const std::vector<std::string> &symbols) {
+        std::string csv = "datetime,symbol,signal,lag\n";
+        auto time = std::chrono::system_clock::now() - std::chrono::hours(static_cast<long>(rows));
+        for (size_t i = 0; i < rows; ++i) {
+            csv += dateTime(time + std::chrono::hours(static_cast<long>(i))) + "," + symbols[i % symbols.size()] + "," +
+                   std::to_string(static_cast<int>(i % 3) - 1) + ",0.25\n";
+        }
+        return csv;
+    }
+
+    std::string deactivateCsv(size_t rows) {
+        std::string csv = "start,end\n";
+        auto time = std::chrono::system_clock::now() - std::chrono::hours(static_cast<long>(rows) * 24);
+        for (size_t i = 0; i < rows; ++i) {
+            auto start = time + std::chrono::hours(static_cast<long>(i) * 24);
+            csv += dateTime(start) + "," + dateTime(start + std::chrono::hours(2)) + "\n";
+        }
+        return csv;
+    }
+
+    class BenchQueue : public TimedEventQueue {
+    public:
+        using TimedEventQueue::TimedEventQueue;
+
+        ~BenchQueue() override { stop(); }
+
+    protected:
+        void onTimestampExpire(const TIMESTAMP &, const std::string &) override {}
+    };
+
+    void signing() {
+        const std::string secret = "NhqPtmdSJYdKjVHjA7PZj4Mge3R5YNiP1e3UZjInClVN65XAbvqqM6A7H5fATj0j";
+        const std::string query = "symbol=BTCUSDT&side=BUY&type=LIMIT&timeInForce=GTC&quantity=0.015&recvWindow=5000"
+                                  "&timestamp=1735689600000&price=64870.1&newClientOrderId=x-0123456789abcdef-entry";
+
+        measure("hmac/HMAC_SHA256", 200000, [&]() {
+            return Utils::HMAC_SHA256(secret, query).size();
+        });
+        measure("hmac/signHex", 200000, [&]() {
+            char signature[Utils::HmacSha256::HEX_SIZE];
+            Utils::HmacSha256::forThread(secret).signHex(query, signature);
+            return signature[0];
+        });
+
+        nlohmann::json legs = nlohmann::json::array();
+        for (const char *type: {"TAKE_PROFIT_MARKET", "STOP_MARKET"}) {
+            legs.push_back({{"symbol", "BTCUSDT"}, {"side", "SELL"}, {"type", type}, {"quantity", "0.015"},
+                            {"stopPrice", "65780.2"}, {"reduceOnly", "true"}, {"newClientOrderId", "x-0123456789abcdef-tp"}});
+        }
+        const std::string batch = legs.dump();
+        measure("urlEncode/urlEncode", 200000, [&]() {
+            return Utils::urlEncode(batch).size();
+        });
+        std::string buffer;
+        measure("urlEncode/appendUrlEncoded", 200000, [&]() {
+            buffer.clear();
+            Utils::appendUrlEncoded(buffer, batch);
+            return buffer.size();
+        });
+
+        // The query OrderService::createOrder builds and signs for every attempt
+        OrderInput order("BTCUSDT", "BUY", "LIMIT", "GTC", Qty::fromDouble(0.015), Price::fromDouble(64870.1));
+        order.clientOrderId = "x-0123456789abcdef-entry";
+        measure("order/createOrder_query", 200000, [&]() {
+            auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/order");
+            request.param("symbol", order.symbol).param("side", order.side).param("type", order.type)
+                    .param("timeInForce", order.timeInForce).param("quantity", order.quantity)
+                    .param("recvWindow", 5000L).timestamp();
+            request.param("price", order.price);
+            request.param("newClientOrderId", order.clientOrderId);
+            return request.sign(secret).size();
+        });
+    }
+
+    void decoding() {
+        std::string account = readFixture("account.json");
+        std::string positions = readFixture("position_risk.json");
+        std::string ticker = readFixture("ticker_price.json");
+        std::string ack = readFixture("order_ack.json");
+
+        measure("json/account/dom", 2000, [&]() {
+            auto json = nlohmann::json::parse(account);
+            for (const auto &balance: json["assets"]) {
+                if (balance["asset"] == "USDT") {
+                    return std::stod(balance["availableBalance"].get<std::string>());
+                }
+            }
+            return 0.0;
+        });
+        measure("json/account/sax", 2000, [&]() {
+            auto balance = Decode::accountAsset(account, "USDT");
+            return balance ? balance->availableBalance : 0.0;
+        });
+
+        measure("json/positionRisk/dom", 40000, [&]() {
+            auto json = nlohmann::json::parse(positions);
+            return std::stod(json[0]["notional"].get<std::string>());
+        });
+        measure("json/positionRisk/sax", 40000, [&]() {
+            auto decoded = Decode::positionRisk(positions);
+            return decoded && !decoded->empty() ? (*decoded)[0].notional : 0.0;
+        });
+
+        measure("json/tickerPrice/dom", 40000, [&]() {
+            return std::stod(nlohmann::json::parse(ticker)["price"].get<std::string>());
+        });
+        measure("json/tickerPrice/sax", 40000, [&]() {
+            auto decoded = Decode::tickerPrice(ticker);
+            return decoded ? decoded->price : 0.0;
+        });
+
+        measure("json/orderAck/dom", 40000, [&]() {
+            auto json = nlohmann::json::parse(ack);
+            return std::stod(json["origQty"].get<std::string>()) + static_cast<double>(json["orderId"].get<long>());
+        });
+        measure("json/orderAck/sax", 40000, [&]() {
+            auto decoded = Decode::orderAck(ack);
+            return decoded.origQty.toDouble() + static_cast<double>(decoded.orderId);
+        });
+    }
+
+    void csv() {
+        std::string signals = signalCsv(2000, {"BTCUSDT", "ETHUSDT", "SOLUSDT", "BNBUSDT"});
+        std::string deactivate = deactivateCsv(500);
+        BlackoutPaddings paddings;
+
+        measure("csv/readSignals_2000_rows", 200, [&]() {
+            return Signaling::readSignals(signals, "BTCUSDT").size();
+        });
+        // A poll that finds one row appended to the 2000, parsed from where the last one stopped
+        Signaling::SignalReader primed("BTCUSDT");
+        primed.consume(signals);
+        std::string grown = signals + signalCsv(1, {"ETHUSDT"}).substr(std::string_view("datetime,symbol,signal,lag\n").size());
+        measure("csv/SignalReader_1_appended_row", 20000, [&]() {
+            Signaling::SignalReader reader = primed;
+            return reader.consume(grown).size();
+        });
+        measure("csv/fromDeactivateCsv_500_rows", 200, [&]() {
+            return BlackoutIndex::fromDeactivateCsv(deactivate, paddings).windows().size();
+        });
+        const std::string text = "2025-01-01 12:34:56";
+        measure("csv/parseDateTime", 100000, [&]() {
+            return parseDateTime(text).time_since_epoch().count();
+        });
+    }
+
+    void queue() {
+        auto far = TIME::now() + std::chrono::hours(1);
+        const std::string label = "Signal";
+        {
+            BenchQueue queue;
+            measure("queue/add_cancel", 200000, [&]() {
+                return queue.cancel(queue.addEvent(far, label, []() {}));
+            });
+        }
+
+        // Every thread adds and cancels on the same queue, ns per operation of all of them together
+        const std::string contended = "queue/add_cancel_8_threads";
+        if (selected(contended)) {
+            BenchQueue queue;
+            const int threads = 8;
+            long perThread = scaled(50000);
+            uint64_t allocations = allocationCount.load();
+            uint64_t bytes = allocationBytes.load();
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; ++t) {
+                workers.emplace_back([&]() {
+                    for (long i = 0; i < perThread; ++i) {
+                        queue.cancel(queue.addEvent(far, label, []() {}));
+                    }
+                });
+            }
+            for (auto &worker: workers) {
+                worker.join();
+            }
+            auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+            auto count = static_cast<double>(perThread * threads);
+            report({contended, perThread * threads, elapsed.count() / count,
+                    static_cast<double>(allocationCount.load() - allocations) / count,
+                    static_cast<double>(allocationBytes.load() - bytes) / count, {}});
+        }
+
+        // Events spread over a second fire on a 2 thread executor while 4 threads keep adding
+        // and canceling, the lag is timestamp to callback
+        const std::string lagName = "queue/fire_lag";
+        if (selected(lagName)) {
+            BenchQueue queue(std::make_shared<ThreadPoolExecutor>(2));
+            std::mutex samplesMutex;
+            std::vector<int64_t> samples;
+            queue.setLagObserver([&](std::chrono::nanoseconds lag) {
+                std::scoped_lock lock(samplesMutex);
+                samples.push_back(lag.count());
+            });
+
+            std::atomic<bool> churn = true;
+            std::vector<std::thread> producers;
+            for (int t = 0; t < 4; ++t) {
+                producers.emplace_back([&]() {
+                    while (churn) {
+                        queue.cancel(queue.addEvent(far, label, []() {}));
+                    }
+                });
+            }
+
+            long events = scaled(2000);
+            auto first = TIME::now() + std::chrono::milliseconds(20);
+            for (long i = 0; i < events; ++i) {
+                queue.addEvent(first + std::chrono::microseconds(1000000 * i / events), label, []() {});
+            }
+            while (queue.lagStats().count < static_cast<uint64_t>(events) && TIME::now() < first + std::chrono::seconds(10)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            churn = false;
+            for (auto &producer: producers) {
+                producer.join();
+            }
+
+            std::scoped_lock lock(samplesMutex);
+            std::sort(samples.begin(), samples.end());
+            auto percentile = [&samples](double p) {
+                return samples.empty() ? 0.0 : static_cast<double>(samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1))]);
+            };
+            auto stats = queue.lagStats();
+            report({lagName, static_cast<long>(samples.size()), static_cast<double>(stats.mean().count()), 0, 0,
+                    {{"p50_ns", percentile(0.5)}, {"p99_ns", percentile(0.99)}, {"max_ns", static_cast<double>(stats.max.count())}}});
+        }
+    }
+
+    void writeJson(const std::string &path) {
+        nlohmann::json benchmarks = nlohmann::json::array();
+        for (const auto &result: results) {
+            nlohmann::json entry = {
+                    {"name", result.name},
+                    {"iterations", result.iterations},
+                    {"ns_per_op", result.nsPerOp},
+                    {"allocs_per_op", result.allocsPerOp},
+                    {"bytes_per_op", result.bytesPerOp}
+            };
+            for (const auto &[key, value]: result.extra) {
+                entry[key] = value;
+            }
+            benchmarks.push_back(entry);
+        }
+        std::ofstream file(path, std::ios::trunc);
+        file << nlohmann::json{{"benchmarks", benchmarks}}.dump(2) << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+        if (arg == "--fixtures") {
+            options.fixtures = next();
+        } else if (arg == "--filter") {
+            options.filter = next();
+        } else if (arg == "--scale") {
+            options.scale = std::stod(next());
+        } else if (arg == "--json") {
+            options.jsonPath = next();
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    signing();
+    decoding();
+    csv();
+    queue();
+
+    if (!options.jsonPath.empty()) {
+        writeJson(options.jsonPath);
+    }
+    return 0;
+}
@@ -1,32 +1,160 @@
+#include <algorithm>
 #include <iostream>
+#include <csignal>
 #include <cpr/cpr.h>
 
 #include "utils.h"
+#include "log.h"
+#include "metrics.h"
+#include "http.h"
+#include "ratelimit.h"
+#include "scheduler.h"
 #include "margin.h"
+#include "clocksync.h"
+#include "marketdata.h"
+#include "exchangeinfo.h"
 #include "signaling.h"
+#include "signalsource.h"
 #include "APIParams.h"
 
 int main() {
+    // Writes to a socket the peer already closed must surface as errors, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
     std::string exePath = Utils::getExecutablePath();
     std::string exeDir = exePath.substr(0, exePath.find_last_of('/'));
     std::string envFilePath = exeDir + "/../.env";
     std::map<std::string, std::string> env = Utils::loadEnvFile(envFilePath);
 
+    Log::Config logConfig;
+    logConfig.level = Log::parseLevel(env["LOG_LEVEL"]);
+    logConfig.whenFull = env["LOG_WHEN_FULL"] == "block" ? Log::WhenFull::Block : Log::WhenFull::Drop;
+    logConfig.path = env["LOG_FILE"];
+    Log::configure(logConfig);
+
     std::cout << "ENV VARIABLES:" << std::endl;
     std::cout << "________________________" << std::endl;
     Utils::printMapElements(env);
     std::cout << "________________________" << std::endl << std::endl;
 
     bool useTestnet = (env["TESTNET"] == "TRUE");
-    std::string apiKey = useTestnet ? env["TESTNET_API_KEY"] : env["API_KEY"];
-    std::string apiSecret = useTestnet ? env["TESTNET_API_SECRET"] : env["API_SECRET"];
-
-    APIParams apiParams(
-            apiKey,
-            apiSecret,
-            5000,
-            env["TESTNET"] == "TRUE"
-    );
-    Margin::setLeverage(apiParams, "BTCUSDT", 1);
-    Signaling::init(apiParams);
+    long recvWindow = env["RECV_WINDOW_MS"].empty() ? 5000 : std::stol(env["RECV_WINDOW_MS"]);
+
+    // ACCOUNTS=main,sub1 reads <NAME>_API_KEY / <NAME>_API_SECRET (<NAME>_TESTNET_API_KEY...
+    // on testnet) for each name. Without it the single account in API_KEY is traded.
+    std::vector<std::string> accountNames = Utils::splitList(env["ACCOUNTS"]);
+    std::vector<APIParams> accounts;
+    if (accountNames.empty()) {
+        accounts.emplace_back(
+                useTestnet ? env["TESTNET_API_KEY"] : env["API_KEY"],
+                useTestnet ? env["TESTNET_API_SECRET"] : env["API_SECRET"],
+                recvWindow,
+                useTestnet
+        );
+    }
+    for (const auto &name: accountNames) {
+        std::string prefix = name + (useTestnet ? "_TESTNET_" : "_");
+        if (env[prefix + "API_KEY"].empty() || env[prefix + "API_SECRET"].empty()) {
+            std::cerr << "No credentials for account " << name << ", skipping it" << std::endl;
+            continue;
+        }
+        accounts.emplace_back(env[prefix + "API_KEY"], env[prefix + "API_SECRET"], recvWindow, useTestnet).name = name;
+    }
+    if (accounts.empty()) {
+        std::cerr << "No account to trade with" << std::endl;
+        return 1;
+    }
+
+    // REST_BASE_URL=http://127.0.0.1:8480 trades against tools/MockExchange, which allows
+    // another REQUEST_WEIGHT_PER_MIN than the exchange's 2400 for load tests
+    if (!env["REQUEST_WEIGHT_PER_MIN"].empty()) {
+        Http::RequestScheduler::setSharedLimit(std::stod(env["REQUEST_WEIGHT_PER_MIN"]));
+    }
+
+    // Every account gets its own connections and new-order budget. 100 orders burst and 18
+    // per second keep an account under the exchange's 300 per 10s and 1200 per minute.
+    for (auto &account: accounts) {
+        account.restUrl = env["REST_BASE_URL"];
+        account.sessions = std::make_shared<Http::SessionPool>();
+        account.orderBudget = std::make_shared<Http::TokenBucket>(
+                env["ORDER_BURST"].empty() ? 100 : std::stod(env["ORDER_BURST"]),
+                env["ORDER_RATE_PER_S"].empty() ? 18 : std::stod(env["ORDER_RATE_PER_S"]));
+    }
+
+    // Public data, clock and exchange rules come through the first account
+    const APIParams &apiParams = accounts.front();
+
+    // Comma separated, every symbol is traded with an equal share of the balance
+    std::vector<std::string> symbols = Utils::splitList(env["SYMBOLS"]);
+    if (symbols.empty()) {
+        symbols.emplace_back("BTCUSDT");
+    }
+    size_t shards = env["SHARDS"].empty() ? 4 : std::stoul(env["SHARDS"]);
+
+    std::string marketDataUrl = env["MARKET_DATA_WS_URL"].empty() ? MarketData::defaultStreamUrl(useTestnet) : env["MARKET_DATA_WS_URL"];
+    MarketData::start(symbols, marketDataUrl);
+
+    // Both signal queues of every shard may hit the exchange at the same time, keep a
+    // connection ready for each
+    for (const auto &account: accounts) {
+        account.sessionPool().warmUp(account.baseUrl(), 2 * std::clamp<size_t>(shards, 1, symbols.size()));
+    }
+
+    // Signed requests carry exchange time from here on, resampled every CLOCK_SYNC_S seconds
+    if (ClockSync::sync(apiParams, 8)) {
+        auto localMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        std::cout << "Exchange clock " << ClockSync::nowMs() - localMs << " ms from local (rtt "
+                  << ClockSync::estimate().rttUs / 1000.0 << " ms)" << std::endl;
+    }
+    ClockSync::start(apiParams, std::chrono::seconds(env["CLOCK_SYNC_S"].empty() ? 60 : std::stol(env["CLOCK_SYNC_S"])));
+
+    // Filters and leverage from the last run, the exchange is only asked when there is no snapshot
+    std::string snapshotPath = env["EXCHANGE_SNAPSHOT"].empty() ? exeDir + "/../exchange.snapshot" : env["EXCHANGE_SNAPSHOT"];
+    if (!ExchangeInfo::loadSnapshot(snapshotPath, apiParams)) {
+        // Tick/step sizes for rounding orders, loaded again on first use if this fails
+        ExchangeInfo::refresh(apiParams);
+    }
+    for (const auto &symbol: symbols) {
+        ExchangeInfo::ensureLeverage(apiParams, symbol, 1);
+    }
+    // The cache only knows the first account's leverage, the others are set every start
+    for (size_t i = 1; i < accounts.size(); ++i) {
+        for (const auto &symbol: symbols) {
+            auto response = Margin::setLeverage(accounts[i], symbol, 1);
+            if (!response.contains("leverage")) {
+                std::cerr << accounts[i].name << ": setLeverage " << symbol << " failed: " << response.dump() << std::endl;
+            }
+        }
+    }
+    auto refreshInterval = std::chrono::minutes(env["EXCHANGE_REFRESH_MIN"].empty() ? 60 : std::stol(env["EXCHANGE_REFRESH_MIN"]));
+    ExchangeInfo::startBackgroundRefresh(apiParams, snapshotPath, refreshInterval);
+
+    Metrics::ExporterConfig metricsConfig;
+    metricsConfig.path = env["METRICS_FILE"].empty() ? exeDir + "/../metrics.prom" : env["METRICS_FILE"];
+    metricsConfig.interval = std::chrono::seconds(env["METRICS_INTERVAL_S"].empty() ? 15 : std::stol(env["METRICS_INTERVAL_S"]));
+    metricsConfig.port = static_cast<uint16_t>(env["METRICS_PORT"].empty() ? 0 : std::stoul(env["METRICS_PORT"]));
+    Metrics::startExporter(metricsConfig);
+
+    auto signalSource = createSignalSource(env, {SIGNAL_FILE, NEWS_FILE, DEACTIVATE_FILE});
+    Signaling::Config config;
+    config.pollInterval = std::chrono::milliseconds(env["SIGNAL_POLL_MS"].empty() ? 1000 : std::stol(env["SIGNAL_POLL_MS"]));
+    config.blackoutPaddings = BlackoutPaddings::fromEnv(env);
+    config.symbols = symbols;
+    config.shards = shards;
+    config.executorThreads = env["EXECUTOR_THREADS"].empty() ? 2 : std::stoul(env["EXECUTOR_THREADS"]);
+    config.dispatchWait = std::chrono::milliseconds(env["DISPATCH_WAIT_MS"].empty() ? 250 : std::stol(env["DISPATCH_WAIT_MS"]));
+    // Strategy parameters, e.g. the best row of a backtest sweep
+    if (!env["ENTRY_OFFSET"].empty()) {
+        config.strategy.entryOffset = std::stod(env["ENTRY_OFFSET"]);
+    }
+    if (!env["TAKE_PROFIT"].empty()) {
+        config.strategy.takeProfit = std::stod(env["TAKE_PROFIT"]);
+    }
+    if (!env["STOP_LOSS"].empty()) {
+        config.strategy.stopLoss = std::stod(env["STOP_LOSS"]);
+    }
+    if (!env["CANCEL_DELAY_S"].empty()) {
+        config.strategy.cancelDelay = std::chrono::seconds(std::stol(env["CANCEL_DELAY_S"]));
+    }
+    Signaling::init(accounts, *signalSource, config);
 }
@@ -0,0 +1,77 @@
+#ifndef BACKTEST_H
+#define BACKTEST_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../../Blackout/headers/blackout.h"
+#include "../../Decode/headers/decode.h"
+#include "../../Strategy/headers/strategy.h"
+
+// Replays historical signals against a recorded price series through the strategy's own
+// decisions (Strategy::prepareEntry, entryOrder, brackets, cancelLeftovers) on a simulated
+// exchange and a virtual clock. Nothing sleeps, a day of ticks replays in milliseconds.
+// Signals are filtered like the live loop does, news and deactivate blackouts included.
+//
+//     auto signals = Backtest::readSignals(signalCsv, "BTCUSDT");
+//     auto prices = Backtest::readPrices(priceCsv);
+//     auto results = Backtest::sweep(grid, signals, prices, config);
+namespace Backtest {
+    struct Tick {
+        std::chrono::system_clock::time_point time;
+        double price = 0;
+    };
+
+    struct Signal {
+        std::chrono::system_clock::time_point time;
+        std::string datetime;
+        int signal = 0;
+    };
+
+    // Every row of `symbol` in a signal.csv (read by Signaling::SignalReader), oldest first.
+    // Rows without a `symbol` column belong to every symbol.
+    std::vector<Signal> readSignals(const std::string &csv, const std::string &symbol);
+
+    // `time,price` rows (header optional), time in epoch milliseconds or
+    // "YYYY-mm-dd HH:MM:SS". Sorted by time.
+    std::vector<Tick> readPrices(const std::string &csv);
+
+    struct Config {
+        std::string symbol = "BTCUSDT";
+        // Starting USDT balance, entries are sized off balance + realized PnL
+        double balance = 1000;
+        // Exchange grid of the symbol, prices and quantities are not rounded when zero
+        Decode::SymbolFilters filters;
+        // Resting limit fills pay maker, triggered and marketable orders pay taker
+        double makerFee = 0.0002;
+        double takerFee = 0.0004;
+        // A signal inside a news window is dropped. Of the signals inside a deactivate
+        // window only the last one is executed, once the window is over.
+        BlackoutIndex newsBlackout;
+        BlackoutIndex deactivateWindows;
+    };
+
+    struct Result {
+        Strategy::Params params;
+        size_t signals = 0;
+        size_t entries = 0;
+        size_t fills = 0;
+        size_t takeProfits = 0;
+        size_t stopLosses = 0;
+        size_t canceled = 0;
+        // Realized plus the open position marked at the last price, fees included
+        double pnl = 0;
+        double fees = 0;
+        double maxDrawdown = 0;
+    };
+
+    Result run(const Strategy::Params &params, const std::vector<Signal> &signals, const std::vector<Tick> &prices,
+               const Config &config);
+
+    // Runs every parameter set on its own on `threads` workers (every core when 0).
+    // Results are in the order of `grid`.
+    std::vector<Result> sweep(const std::vector<Strategy::Params> &grid, const std::vector<Signal> &signals,
+                              const std::vector<Tick> &prices, const Config &config, size_t threads = 0);
+}
+
+#endif // BACKTEST_H
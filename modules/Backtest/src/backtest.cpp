@@ -0,0 +1,381 @@
+#include "../headers/backtest.h"
+#include "../../News/headers/news.h"
+#include "../../Signaling/headers/signalreader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <optional>
+#include <queue>
+#include <sstream>
+#include <thread>
+#include <tuple>
+
+namespace Backtest {
+    namespace {
+        std::vector<std::string> splitLine(const std::string &line) {
+            std::vector<std::string> columns;
+            std::istringstream stream(line);
+            std::string value;
+            while (std::getline(stream, value, ',')) {
+                if (!value.empty() && value.back() == '\r') {
+                    value.pop_back();
+                }
+                columns.push_back(std::move(value));
+            }
+            return columns;
+        }
+
+        // Epoch seconds or milliseconds, or "YYYY-mm-dd HH:MM:SS"
+        std::optional<std::chrono::system_clock::time_point> parseTime(const std::string &text) {
+            if (text.empty()) {
+                return std::nullopt;
+            }
+            if (std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+                long long value = std::stoll(text);
+                auto since = text.size() >= 12 ? std::chrono::milliseconds(value) : std::chrono::seconds(value);
+                return std::chrono::system_clock::time_point(since);
+            }
+            return tryParseDateTime(text);
+        }
+
+        class SimClock {
+        public:
+            std::chrono::system_clock::time_point now() const { return _now; }
+
+            void set(std::chrono::system_clock::time_point now) { _now = now; }
+
+        private:
+            std::chrono::system_clock::time_point _now;
+        };
+
+        struct SimOrder {
+            long long orderId = 0;
+            std::string side;
+            std::string type;
+            double price = 0;
+            double stopPrice = 0;
+            double quantity = 0;
+            bool reduceOnly = false;
+        };
+
+        // One symbol in one-way mode: resting limits fill when the price trades through
+        // them, trigger orders fill at the first price past their stop.
+        class SimExchange : public Strategy::Exchange {
+        public:
+            SimExchange(const Config &config, const SimClock &clock, Result &result) :
+                    _config(config), _clock(clock), _result(result) {}
+
+            std::optional<double> position(const std::string &) override {
+                return _position;
+            }
+
+            std::optional<std::vector<Strategy::OpenOrder>> openOrders(const std::string &) override {
+                std::vector<Strategy::OpenOrder> open;
+                for (const auto &order: _orders) {
+                    open.push_back({order.orderId, order.type});
+                }
+                return open;
+            }
+
+            void cancelAll(const std::string &) override {
+                _result.canceled += static_cast<size_t>(std::count_if(_orders.begin(), _orders.end(), [](const SimOrder &order) {
+                    return order.type == "LIMIT";
+                }));
+                _orders.clear();
+            }
+
+            Decode::OrderAck placeOrder(const OrderInput &input) override {
+                SimOrder order{++_lastOrderId, input.side, input.type, input.price.toDouble(), 0, input.quantity.toDouble(), false};
+
+                Decode::OrderAck ack;
+                ack.orderId = order.orderId;
+                ack.clientOrderId = input.clientOrderId;
+                ack.symbol = input.symbol;
+                ack.side = input.side;
+                ack.type = input.type;
+                ack.price = input.price;
+                ack.origQty = input.quantity;
+                ack.updateTime = std::chrono::duration_cast<std::chrono::milliseconds>(_clock.now().time_since_epoch()).count();
+
+                bool marketable = order.type == "MARKET" || (order.side == "BUY" ? order.price >= _price : order.price <= _price);
+                if (marketable) {
+                    fill(order, _price, _config.takerFee);
+                    ack.status = "FILLED";
+                    ack.executedQty = input.quantity;
+                    ack.avgPrice = Price::fromDouble(_price);
+                } else {
+                    _orders.push_back(order);
+                    ack.status = "NEW";
+                }
+                return ack;
+            }
+
+            size_t placeBrackets(const std::vector<TriggerOrderInput> &legs) override {
+                for (const auto &leg: legs) {
+                    _orders.push_back({++_lastOrderId, leg.side, leg.type, leg.price.toDouble(), leg.stopPrice.toDouble(),
+                                       leg.quantity.toDouble(), leg.reduceOnly});
+                }
+                return legs.size();
+            }
+
+            // Moves the market to `price`, returns the entry (LIMIT) orders that filled
+            std::vector<SimOrder> onTick(double price) {
+                _price = price;
+                std::vector<SimOrder> filled;
+                for (size_t i = 0; i < _orders.size();) {
+                    const SimOrder &order = _orders[i];
+                    bool buy = order.side == "BUY";
+                    bool done = false;
+                    if (order.type == "LIMIT") {
+                        done = buy ? price <= order.price : price >= order.price;
+                        if (done) {
+                            fill(order, order.price, _config.makerFee);
+                            ++_result.fills;
+                            filled.push_back(order);
+                        }
+                    } else {
+                        // A take profit sits on the far side of the position, a stop on the near side
+                        bool takeProfit = order.type.starts_with("TAKE_PROFIT");
+                        done = (buy != takeProfit) ? price >= order.stopPrice : price <= order.stopPrice;
+                        if (done && fill(order, price, _config.takerFee)) {
+                            ++(takeProfit ? _result.takeProfits : _result.stopLosses);
+                        }
+                    }
+
+                    if (done) {
+                        _orders.erase(_orders.begin() + static_cast<std::ptrdiff_t>(i));
+                    } else {
+                        ++i;
+                    }
+                }
+                return filled;
+            }
+
+            double price() const { return _price; }
+
+            double realized() const { return _realized; }
+
+            double unrealized() const { return _position * (_price - _entryPrice); }
+
+        private:
+            // False when a reduce-only order had nothing left to reduce
+            bool fill(const SimOrder &order, double price, double feeRate) {
+                double quantity = order.side == "BUY" ? order.quantity : -order.quantity;
+                if (order.reduceOnly) {
+                    if (_position == 0 || (quantity > 0) == (_position > 0)) {
+                        return false;
+                    }
+                    quantity = std::copysign(std::min(std::abs(quantity), std::abs(_position)), quantity);
+                }
+
+                double fee = std::abs(quantity) * price * feeRate;
+                _realized -= fee;
+                _result.fees += fee;
+
+                if (_position == 0 || (quantity > 0) == (_position > 0)) {
+                    _entryPrice = (_entryPrice * std::abs(_position) + price * std::abs(quantity)) / (std::abs(_position) + std::abs(quantity));
+                    _position += quantity;
+                    return true;
+                }
+
+                double closed = std::min(std::abs(quantity), std::abs(_position));
+                _realized += closed * (price - _entryPrice) * (_position > 0 ? 1 : -1);
+                _position += quantity;
+                if (std::abs(_position) < 1e-12) {
+                    _position = 0;
+                    _entryPrice = 0;
+                } else if ((_position > 0) == (quantity > 0)) {
+                    // Flipped, the rest opened a position of its own
+                    _entryPrice = price;
+                }
+                return true;
+            }
+
+            const Config &_config;
+            const SimClock &_clock;
+            Result &_result;
+            std::vector<SimOrder> _orders;
+            long long _lastOrderId = 0;
+            double _price = 0;
+            double _position = 0;
+            double _entryPrice = 0;
+            double _realized = 0;
+        };
+
+        struct Event {
+            enum class Kind {
+                Entry,
+                Cleanup
+            };
+
+            std::chrono::system_clock::time_point time;
+            uint64_t sequence = 0;
+            Kind kind = Kind::Entry;
+            int signal = 0;
+
+            bool operator>(const Event &other) const {
+                return std::tie(time, sequence) > std::tie(other.time, other.sequence);
+            }
+        };
+    }
+
+    std::vector<Signal> readSignals(const std::string &csv, const std::string &symbol) {
+        std::vector<Signal> signals;
+        for (auto &row: Signaling::SignalReader(symbol, true).consume(csv, true)) {
+            if (row.symbol != symbol || row.datetime.empty()) {
+                continue;
+            }
+            signals.push_back({row.time, std::move(row.datetime), row.signal});
+        }
+
+        std::stable_sort(signals.begin(), signals.end(), [](const Signal &a, const Signal &b) {
+            return a.time < b.time;
+        });
+        return signals;
+    }
+
+    std::vector<Tick> readPrices(const std::string &csv) {
+        std::istringstream iss(csv);
+        std::string line;
+        std::vector<Tick> prices;
+        while (std::getline(iss, line)) {
+            auto columns = splitLine(line);
+            if (columns.size() < 2) {
+                continue;
+            }
+            auto time = parseTime(columns[0]);
+            if (!time) {
+                continue;
+            }
+            try {
+                prices.push_back({*time, std::stod(columns[1])});
+            } catch (const std::exception &) {
+            }
+        }
+
+        std::stable_sort(prices.begin(), prices.end(), [](const Tick &a, const Tick &b) {
+            return a.time < b.time;
+        });
+        return prices;
+    }
+
+    Result run(const Strategy::Params &params, const std::vector<Signal> &signals, const std::vector<Tick> &prices,
+               const Config &config) {
+        Result result;
+        result.params = params;
+        if (prices.empty()) {
+            return result;
+        }
+
+        SimClock clock;
+        SimExchange exchange(config, clock, result);
+        exchange.onTick(prices.front().price);
+
+        // Same filtering as the live loop: nothing inside a news window, the latest signal of
+        // a deactivate window once it is over, only buy/sell and each datetime once
+        std::priority_queue<Event, std::vector<Event>, std::greater<>> events;
+        uint64_t sequence = 0;
+        std::string prevDatetime;
+        auto execute = [&](const Signal &signal, std::chrono::system_clock::time_point at) {
+            if (config.newsBlackout.contains(signal.time) || (signal.signal != 1 && signal.signal != -1) ||
+                signal.datetime == prevDatetime) {
+                return;
+            }
+            prevDatetime = signal.datetime;
+            ++result.signals;
+            events.push({at + params.execDelay, sequence++, Event::Kind::Entry, signal.signal});
+            events.push({at + params.cancelDelay, sequence++, Event::Kind::Cleanup, signal.signal});
+        };
+
+        const Signal *held = nullptr;
+        const BlackoutIndex::Window *heldBy = nullptr;
+        for (const auto &signal: signals) {
+            if (held && signal.time > heldBy->end) {
+                execute(*held, heldBy->end);
+                held = nullptr;
+            }
+            if (auto window = config.deactivateWindows.windowAt(signal.time)) {
+                held = &signal;
+                heldBy = window;
+                continue;
+            }
+            execute(signal, signal.time);
+        }
+        if (held) {
+            execute(*held, heldBy->end);
+        }
+
+        auto protect = [&](const std::string &entrySide, Qty quantity) {
+            exchange.placeBrackets(Strategy::brackets(params, config.symbol, entrySide, quantity, exchange.price(), config.filters));
+        };
+
+        auto handle = [&](const Event &event) {
+            if (event.kind == Event::Kind::Cleanup) {
+                Strategy::cancelLeftovers(exchange, config.symbol);
+                return;
+            }
+            if (Strategy::prepareEntry(exchange, config.symbol) != Strategy::Readiness::Ready) {
+                return;
+            }
+            auto order = Strategy::entryOrder(params, config.symbol, event.signal, exchange.price(),
+                                              config.balance + exchange.realized(), config.filters);
+            if (!order) {
+                return;
+            }
+            ++result.entries;
+            auto ack = exchange.placeOrder(*order);
+            if (ack.status == "FILLED") {
+                ++result.fills;
+                protect(order->side, order->quantity);
+            }
+        };
+
+        double peak = config.balance;
+        for (const auto &tick: prices) {
+            // Timers due before this tick see the previous price
+            while (!events.empty() && events.top().time <= tick.time) {
+                Event event = events.top();
+                events.pop();
+                clock.set(event.time);
+                handle(event);
+            }
+
+            clock.set(tick.time);
+            for (const auto &entry: exchange.onTick(tick.price)) {
+                protect(entry.side, Qty::fromDouble(entry.quantity));
+            }
+
+            double equity = config.balance + exchange.realized() + exchange.unrealized();
+            peak = std::max(peak, equity);
+            result.maxDrawdown = std::max(result.maxDrawdown, peak - equity);
+        }
+
+        result.pnl = exchange.realized() + exchange.unrealized();
+        return result;
+    }
+
+    std::vector<Result> sweep(const std::vector<Strategy::Params> &grid, const std::vector<Signal> &signals,
+                              const std::vector<Tick> &prices, const Config &config, size_t threads) {
+        std::vector<Result> results(grid.size());
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, grid.size());
+
+        // Runs share nothing but the read-only inputs
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([&]() {
+                for (size_t index = next++; index < grid.size(); index = next++) {
+                    results[index] = run(grid[index], signals, prices, config);
+                }
+            });
+        }
+        for (auto &worker: workers) {
+            worker.join();
+        }
+        return results;
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef BLACKOUT_H
+#define BLACKOUT_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+struct BlackoutPadding {
+    std::chrono::minutes before{0};
+    std::chrono::minutes after{0};
+};
+
+// Padding per event type, keyed by the upper-cased value of the CSV "type" column.
+// BLACKOUT_PADDING_<TYPE>=<before minutes>,<after minutes> overrides an entry,
+// NEWS is used for rows without a type and DEACTIVATE for the deactivate windows.
+struct BlackoutPaddings {
+    std::map<std::string, BlackoutPadding> byType = {
+            {"NEWS",       {std::chrono::hours(13), std::chrono::hours(1)}},
+            {"DEACTIVATE", {}}
+    };
+
+    const BlackoutPadding &forType(const std::string &type) const;
+
+    static BlackoutPaddings fromEnv(const std::map<std::string, std::string> &env);
+};
+
+// Sorted, non-overlapping blackout windows. Overlapping and touching windows are merged
+// when the index is built, so a lookup is a single binary search without allocations.
+class BlackoutIndex {
+public:
+    using TimePoint = std::chrono::system_clock::time_point;
+
+    struct Window {
+        TimePoint start;
+        TimePoint end;
+    };
+
+    BlackoutIndex() = default;
+
+    explicit BlackoutIndex(std::vector<Window> windows);
+
+    bool contains(TimePoint time) const { return windowAt(time) != nullptr; }
+
+    // The window containing time, nullptr outside of every window
+    const Window *windowAt(TimePoint time) const;
+
+    bool containsNow() const { return contains(std::chrono::system_clock::now()); }
+
+    const std::vector<Window> &windows() const { return _windows; }
+
+    // One window per row of news.csv: [datetime - before, datetime + after]
+    static BlackoutIndex fromNewsCsv(const std::string &csv, const BlackoutPaddings &paddings);
+
+    // One window per row of deactivate.csv: [start - before, end + after]
+    static BlackoutIndex fromDeactivateCsv(const std::string &csv, const BlackoutPaddings &paddings);
+
+private:
+    std::vector<Window> _windows;
+};
+
+#endif // BLACKOUT_H
@@ -0,0 +1,154 @@
+#include "../headers/blackout.h"
+#include "../../News/headers/news.h"
+#include "../../Log/headers/log.h"
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <sstream>
+
+namespace {
+    std::vector<std::string> splitRow(const std::string &line) {
+        std::vector<std::string> columns;
+        std::istringstream stream(line);
+        std::string column;
+        while (std::getline(stream, column, ',')) {
+            if (!column.empty() && column.back() == '\r') {
+                column.pop_back();
+            }
+            columns.push_back(column);
+        }
+        return columns;
+    }
+
+    std::string upper(std::string value) {
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::toupper(c); });
+        return value;
+    }
+
+    // Whole number of minutes, nullopt on anything else
+    std::optional<std::chrono::minutes> parseMinutes(std::string_view text) {
+        long minutes = 0;
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), minutes);
+        if (ec != std::errc() || end != text.data() + text.size()) {
+            return std::nullopt;
+        }
+        return std::chrono::minutes(minutes);
+    }
+
+    long columnIndex(const std::vector<std::string> &header, std::initializer_list<const char *> names) {
+        for (size_t i = 0; i < header.size(); ++i) {
+            for (const char *name: names) {
+                if (header[i] == name) {
+                    return static_cast<long>(i);
+                }
+            }
+        }
+        return -1;
+    }
+}
+
+const BlackoutPadding &BlackoutPaddings::forType(const std::string &type) const {
+    auto itr = byType.find(type.empty() ? "NEWS" : upper(type));
+    if (itr == byType.end()) {
+        itr = byType.find("NEWS");
+    }
+    static const BlackoutPadding none;
+    return itr == byType.end() ? none : itr->second;
+}
+
+BlackoutPaddings BlackoutPaddings::fromEnv(const std::map<std::string, std::string> &env) {
+    const std::string prefix = "BLACKOUT_PADDING_";
+    BlackoutPaddings paddings;
+    for (const auto &[key, value]: env) {
+        if (key.rfind(prefix, 0) != 0) {
+            continue;
+        }
+        size_t comma = value.find(',');
+        std::string_view text = value;
+        auto before = comma == std::string::npos ? std::nullopt : parseMinutes(text.substr(0, comma));
+        auto after = comma == std::string::npos ? std::nullopt : parseMinutes(text.substr(comma + 1));
+        if (!before || !after) {
+            Log::error("Invalid ", key, "=", value, ", expected <before minutes>,<after minutes>, keeping the default padding");
+            continue;
+        }
+        paddings.byType[upper(key.substr(prefix.size()))] = {*before, *after};
+    }
+    return paddings;
+}
+
+BlackoutIndex::BlackoutIndex(std::vector<Window> windows) {
+    std::sort(windows.begin(), windows.end(), [](const Window &a, const Window &b) { return a.start < b.start; });
+    for (const auto &window: windows) {
+        if (window.end < window.start) {
+            continue;
+        }
+        if (!_windows.empty() && window.start <= _windows.back().end) {
+            _windows.back().end = std::max(_windows.back().end, window.end);
+        } else {
+            _windows.push_back(window);
+        }
+    }
+}
+
+const BlackoutIndex::Window *BlackoutIndex::windowAt(TimePoint time) const {
+    // First window starting after time, the candidate is the one before it
+    auto itr = std::upper_bound(_windows.begin(), _windows.end(), time,
+                                [](const TimePoint &t, const Window &w) { return t < w.start; });
+    if (itr == _windows.begin() || time > std::prev(itr)->end) {
+        return nullptr;
+    }
+    return &*std::prev(itr);
+}
+
+BlackoutIndex BlackoutIndex::fromNewsCsv(const std::string &csv, const BlackoutPaddings &paddings) {
+    std::istringstream iss(csv);
+    std::string line;
+    std::vector<Window> windows;
+
+    std::getline(iss, line);
+    auto header = splitRow(line);
+    long dateColumn = std::max(0L, columnIndex(header, {"datetime", "date"}));
+    long typeColumn = columnIndex(header, {"type", "event_type"});
+
+    while (std::getline(iss, line)) {
+        auto columns = splitRow(line);
+        if (columns.size() <= static_cast<size_t>(dateColumn) || columns[dateColumn].size() < 19) {
+            continue;
+        }
+
+        std::string type = typeColumn >= 0 && columns.size() > static_cast<size_t>(typeColumn) ? columns[typeColumn] : "";
+        const auto &padding = paddings.forType(type);
+        auto time = parseDateTime(columns[dateColumn]);
+        windows.push_back({time - padding.before, time + padding.after});
+    }
+
+    return BlackoutIndex(std::move(windows));
+}
+
+BlackoutIndex BlackoutIndex::fromDeactivateCsv(const std::string &csv, const BlackoutPaddings &paddings) {
+    std::istringstream iss(csv);
+    std::string line;
+    std::vector<Window> windows;
+
+    std::getline(iss, line);
+    auto header = splitRow(line);
+    long startColumn = columnIndex(header, {"start"});
+    long endColumn = columnIndex(header, {"end"});
+    if (startColumn < 0 || endColumn < 0) {
+        return {};
+    }
+
+    const auto &padding = paddings.forType("DEACTIVATE");
+    while (std::getline(iss, line)) {
+        auto columns = splitRow(line);
+        if (columns.size() <= static_cast<size_t>(std::max(startColumn, endColumn)) ||
+            columns[startColumn].size() < 19 || columns[endColumn].size() < 19) {
+            continue;
+        }
+        windows.push_back({parseDateTime(columns[startColumn]) - padding.before,
+                           parseDateTime(columns[endColumn]) + padding.after});
+    }
+
+    return BlackoutIndex(std::move(windows));
+}
@@ -0,0 +1,71 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include "../../Order/models/APIParams/APIParams.h"
+
+// Exchange-aligned time for the timestamp of signed requests.
+//
+// fapi/v1/time is sampled like an NTP client does: the server time is taken to be read at
+// the midpoint of the round trip, so each sample gives an offset that is off by at most
+// half its RTT. The sample with the smallest RTT among the recent ones wins. The offset is
+// kept against steady_clock, so steps of the local wall clock do not move it.
+namespace ClockSync {
+    // Binance: "Timestamp for this request is outside of the recvWindow"
+    constexpr int INVALID_TIMESTAMP = -1021;
+
+    struct Sample {
+        // Server epoch us minus local steady_clock us
+        int64_t offsetUs = 0;
+        int64_t rttUs = 0;
+        // steady_clock us when the response arrived
+        int64_t takenAtUs = 0;
+    };
+
+    // The last WINDOW samples, best() is the one with the smallest RTT that is not older
+    // than maxAge
+    class OffsetFilter {
+    public:
+        static constexpr size_t WINDOW = 8;
+
+        explicit OffsetFilter(std::chrono::microseconds maxAge = std::chrono::minutes(15));
+
+        void add(const Sample &sample);
+
+        std::optional<Sample> best(int64_t nowUs) const;
+
+    private:
+        std::array<Sample, WINDOW> _samples{};
+        size_t _count = 0;
+        size_t _next = 0;
+        int64_t _maxAgeUs;
+    };
+
+    struct Estimate {
+        bool synced = false;
+        int64_t offsetUs = 0;
+        // RTT of the chosen sample, the offset is within half of it
+        int64_t rttUs = 0;
+    };
+
+    // Takes `samples` samples back to back and updates the estimate. False when none succeeded.
+    bool sync(const APIParams &apiParams, int samples = 4);
+
+    Estimate estimate();
+
+    // Server time in epoch ms, the local wall clock until the first successful sync
+    int64_t nowMs();
+
+    // Samples again every `interval`, or right away after requestResync()
+    void start(const APIParams &apiParams, std::chrono::seconds interval);
+
+    void stop();
+
+    // For callers that got INVALID_TIMESTAMP back
+    void requestResync();
+}
+
+#endif // CLOCK_SYNC_H
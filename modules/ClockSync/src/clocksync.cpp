@@ -0,0 +1,159 @@
+#include "../headers/clocksync.h"
+#include "../../Http/headers/http.h"
+#include "../../Decode/headers/decode.h"
+#include "../../Log/headers/log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace ClockSync {
+    namespace {
+        int64_t steadyUs() {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        std::mutex filterMutex;
+        OffsetFilter filter;
+
+        // Published estimate, read on every signed request
+        std::atomic<bool> synced{false};
+        std::atomic<int64_t> offsetUs{0};
+        std::atomic<int64_t> rttUs{0};
+
+        std::thread syncer;
+        std::mutex syncerMutex;
+        std::condition_variable syncerCv;
+        bool syncerExit = false;
+        bool resyncRequested = false;
+
+        std::optional<Sample> sample(const APIParams &apiParams) {
+            int64_t sent = steadyUs();
+            cpr::Response r = Http::get(apiParams.baseUrl(), "fapi/v1/time", cpr::Header{});
+            int64_t received = steadyUs();
+
+            auto serverTime = Decode::serverTime(r.text);
+            if (!serverTime) {
+                Log::error("fapi/v1/time failed (", r.status_code, "): ", r.text);
+                return std::nullopt;
+            }
+
+            // serverTime is truncated to the ms, take the middle of that ms
+            int64_t serverUs = *serverTime * 1000 + 500;
+            return Sample{serverUs - (sent + received) / 2, received - sent, received};
+        }
+    }
+
+    OffsetFilter::OffsetFilter(std::chrono::microseconds maxAge) : _maxAgeUs(maxAge.count()) {}
+
+    void OffsetFilter::add(const Sample &sample) {
+        _samples[_next] = sample;
+        _next = (_next + 1) % WINDOW;
+        _count = std::min(_count + 1, WINDOW);
+    }
+
+    std::optional<Sample> OffsetFilter::best(int64_t nowUs) const {
+        std::optional<Sample> best;
+        for (size_t i = 0; i < _count; ++i) {
+            const Sample &candidate = _samples[i];
+            if (nowUs - candidate.takenAtUs > _maxAgeUs) {
+                continue;
+            }
+            if (!best || candidate.rttUs < best->rttUs) {
+                best = candidate;
+            }
+        }
+        return best;
+    }
+
+    bool sync(const APIParams &apiParams, int samples) {
+        int taken = 0;
+        for (int i = 0; i < samples; ++i) {
+            if (auto result = sample(apiParams)) {
+                std::scoped_lock lock(filterMutex);
+                filter.add(*result);
+                ++taken;
+            }
+        }
+        if (taken == 0) {
+            return false;
+        }
+
+        std::scoped_lock lock(filterMutex);
+        auto best = filter.best(steadyUs());
+        if (!best) {
+            return false;
+        }
+        offsetUs.store(best->offsetUs, std::memory_order_relaxed);
+        rttUs.store(best->rttUs, std::memory_order_relaxed);
+        synced.store(true, std::memory_order_release);
+        return true;
+    }
+
+    Estimate estimate() {
+        bool isSynced = synced.load(std::memory_order_acquire);
+        return {isSynced, offsetUs.load(std::memory_order_relaxed), rttUs.load(std::memory_order_relaxed)};
+    }
+
+    int64_t nowMs() {
+        if (!synced.load(std::memory_order_acquire)) {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+        return (steadyUs() + offsetUs.load(std::memory_order_relaxed)) / 1000;
+    }
+
+    void start(const APIParams &apiParams, std::chrono::seconds interval) {
+        stop();
+        {
+            std::scoped_lock lock(syncerMutex);
+            syncerExit = false;
+            resyncRequested = false;
+        }
+
+        syncer = std::thread([apiParams, interval]() {
+            while (true) {
+                {
+                    std::unique_lock lock(syncerMutex);
+                    syncerCv.wait_for(lock, interval, []() { return syncerExit || resyncRequested; });
+                    if (syncerExit) {
+                        return;
+                    }
+                    resyncRequested = false;
+                }
+
+                if (!sync(apiParams)) {
+                    Log::warn("Clock sync failed, keeping the previous offset");
+                }
+
+                // A burst of rejected requests should not turn into a burst of syncs
+                std::unique_lock lock(syncerMutex);
+                if (syncerCv.wait_for(lock, std::chrono::seconds(1), []() { return syncerExit; })) {
+                    return;
+                }
+            }
+        });
+    }
+
+    void stop() {
+        if (syncer.joinable()) {
+            {
+                std::scoped_lock lock(syncerMutex);
+                syncerExit = true;
+            }
+            syncerCv.notify_all();
+            syncer.join();
+        }
+    }
+
+    void requestResync() {
+        {
+            std::scoped_lock lock(syncerMutex);
+            resyncRequested = true;
+        }
+        syncerCv.notify_all();
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef DECODE_H
+#define DECODE_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../../Utils/headers/decimal.h"
+
+// Typed views of the REST responses we read. The decoders run a SAX pass over the body
+// and only copy the fields listed here, no DOM is built and everything else (the other
+// assets, the positions in fapi/v2/account, ...) is skipped as it is lexed.
+// Numbers sent as strings ("price": "65000.10") are converted.
+namespace Decode {
+    // {"code": -1021, "msg": "..."} that Binance returns instead of the expected payload
+    struct ApiError {
+        int code = 0;
+        std::string msg;
+    };
+
+    struct TickerPrice {
+        std::string symbol;
+        double price = 0;
+        long long time = 0;
+    };
+
+    struct PositionRisk {
+        std::string symbol;
+        std::string positionSide;
+        double positionAmt = 0;
+        double entryPrice = 0;
+        double markPrice = 0;
+        double notional = 0;
+        double unRealizedProfit = 0;
+        int leverage = 0;
+    };
+
+    struct OrderAck {
+        long long orderId = 0;
+        std::string clientOrderId;
+        std::string symbol;
+        std::string status;
+        std::string side;
+        std::string type;
+        Price price;
+        Price stopPrice;
+        Qty origQty;
+        Qty executedQty;
+        Price avgPrice;
+        long long updateTime = 0;
+        // Set when the exchange rejected the request, orderId stays 0
+        std::optional<ApiError> error;
+
+        bool ok() const { return !error && orderId != 0; }
+    };
+
+    struct AccountAsset {
+        std::string asset;
+        double walletBalance = 0;
+        double availableBalance = 0;
+        double marginBalance = 0;
+    };
+
+    // Trading rules of one symbol from fapi/v1/exchangeInfo (PRICE_FILTER, LOT_SIZE,
+    // MARKET_LOT_SIZE and MIN_NOTIONAL)
+    struct SymbolFilters {
+        std::string symbol;
+        std::string status;
+        Price tickSize;
+        Price minPrice;
+        Price maxPrice;
+        Qty stepSize;
+        Qty minQty;
+        Qty maxQty;
+        Qty marketStepSize;
+        Qty marketMinQty;
+        Qty marketMaxQty;
+        Price minNotional;
+    };
+
+    // One notional tier of fapi/v1/leverageBracket, the first tier allows the highest leverage
+    struct LeverageBracket {
+        int bracket = 0;
+        int initialLeverage = 0;
+        Price notionalFloor;
+        Price notionalCap;
+        double maintMarginRatio = 0;
+    };
+
+    struct SymbolBrackets {
+        std::string symbol;
+        std::vector<LeverageBracket> brackets;
+    };
+
+    // nullopt when the body is malformed or an error object (reported through `error`)
+    std::optional<TickerPrice> tickerPrice(std::string_view body, ApiError *error = nullptr);
+
+    std::optional<std::vector<PositionRisk>> positionRisk(std::string_view body, ApiError *error = nullptr);
+
+    OrderAck orderAck(std::string_view body);
+
+    std::optional<std::vector<SymbolFilters>> exchangeInfo(std::string_view body, ApiError *error = nullptr);
+
+    std::optional<std::vector<SymbolBrackets>> leverageBrackets(std::string_view body, ApiError *error = nullptr);
+
+    // serverTime of fapi/v1/time, epoch ms
+    std::optional<long long> serverTime(std::string_view body, ApiError *error = nullptr);
+
+    // Only the entry of `asset` from fapi/v2/account, parsing stops as soon as it is found
+    std::optional<AccountAsset> accountAsset(std::string_view body, std::string_view asset, ApiError *error = nullptr);
+}
+
+#endif // DECODE_H
@@ -0,0 +1,585 @@
+#include "../headers/decode.h"
+
+#include <charconv>
+#include <nlohmann/json.hpp>
+
+namespace {
+    // A scalar as the SAX parser reports it. `text` points into the lexer's buffer and is
+    // only valid during the callback.
+    struct Scalar {
+        enum class Kind { Null, Bool, Integer, Float, String } kind = Kind::Null;
+        std::string_view text;
+        long long integer = 0;
+        double number = 0;
+
+        double toDouble() const {
+            switch (kind) {
+                case Kind::Integer:
+                    return static_cast<double>(integer);
+                case Kind::Float:
+                    return number;
+                case Kind::String: {
+                    double value = 0;
+                    std::from_chars(text.data(), text.data() + text.size(), value);
+                    return value;
+                }
+                default:
+                    return 0;
+            }
+        }
+
+        long long toInteger() const {
+            switch (kind) {
+                case Kind::Integer:
+                case Kind::Bool:
+                    return integer;
+                case Kind::Float:
+                    return static_cast<long long>(number);
+                case Kind::String: {
+                    long long value = 0;
+                    std::from_chars(text.data(), text.data() + text.size(), value);
+                    return value;
+                }
+                default:
+                    return 0;
+            }
+        }
+
+        std::string_view toString() const { return kind == Kind::String ? text : std::string_view(); }
+
+        template<typename Tag>
+        Decimal<Tag> toDecimal() const {
+            if (kind == Kind::String) {
+                return Decimal<Tag>::parse(text).value_or(Decimal<Tag>());
+            }
+            return Decimal<Tag>::fromDouble(toDouble());
+        }
+    };
+
+    class Handler;
+
+    // What a decoder implements. Returning false stops the parse early, which is not an
+    // error (e.g. the asset we were looking for has been read).
+    class Sink {
+    public:
+        virtual ~Sink() = default;
+
+        virtual bool beginObject(const Handler &) { return true; }
+
+        virtual bool endObject(const Handler &) { return true; }
+
+        virtual bool field(const Handler &path, std::string_view key, const Scalar &value) = 0;
+    };
+
+    // Tracks the current depth and, per level, the key being read. Keys are kept in
+    // strings that are reused between objects so a long response allocates nothing once
+    // the first object has been seen.
+    class Handler : public nlohmann::json_sax<nlohmann::json> {
+    public:
+        explicit Handler(Sink &sink) : _sink(sink) {}
+
+        // 1 inside the top-level container
+        size_t depth() const { return _depth; }
+
+        // Key currently being read inside the container at `depth`, empty for arrays
+        std::string_view keyAt(size_t depth) const {
+            return depth < _keys.size() ? std::string_view(_keys[depth]) : std::string_view();
+        }
+
+        bool topIsObject() const { return _topIsObject; }
+
+        bool failed() const { return _failed; }
+
+        bool null() override { return emit({}); }
+
+        bool boolean(bool value) override {
+            Scalar scalar;
+            scalar.kind = Scalar::Kind::Bool;
+            scalar.integer = value ? 1 : 0;
+            return emit(scalar);
+        }
+
+        bool number_integer(number_integer_t value) override {
+            Scalar scalar;
+            scalar.kind = Scalar::Kind::Integer;
+            scalar.integer = value;
+            return emit(scalar);
+        }
+
+        bool number_unsigned(number_unsigned_t value) override {
+            Scalar scalar;
+            scalar.kind = Scalar::Kind::Integer;
+            scalar.integer = static_cast<long long>(value);
+            return emit(scalar);
+        }
+
+        bool number_float(number_float_t value, const string_t &) override {
+            Scalar scalar;
+            scalar.kind = Scalar::Kind::Float;
+            scalar.number = value;
+            return emit(scalar);
+        }
+
+        bool string(string_t &value) override {
+            Scalar scalar;
+            scalar.kind = Scalar::Kind::String;
+            scalar.text = value;
+            return emit(scalar);
+        }
+
+        bool binary(binary_t &) override { return true; }
+
+        bool start_object(std::size_t) override {
+            if (_depth == 0) {
+                _topIsObject = true;
+            }
+            push();
+            return _sink.beginObject(*this);
+        }
+
+        bool key(string_t &key) override {
+            _keys[_depth].assign(key);
+            return true;
+        }
+
+        bool end_object() override {
+            bool more = _sink.endObject(*this);
+            pop();
+            return more;
+        }
+
+        bool start_array(std::size_t) override {
+            push();
+            return true;
+        }
+
+        bool end_array() override {
+            pop();
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &) override {
+            _failed = true;
+            return false;
+        }
+
+    private:
+        Sink &_sink;
+        std::vector<std::string> _keys{1};
+        size_t _depth = 0;
+        bool _topIsObject = false;
+        bool _failed = false;
+
+        void push() {
+            if (++_depth >= _keys.size()) {
+                _keys.emplace_back();
+            }
+            _keys[_depth].clear();
+        }
+
+        void pop() { --_depth; }
+
+        bool emit(const Scalar &scalar) { return _sink.field(*this, _keys[_depth], scalar); }
+    };
+
+    // Parses body into sink. False when the body is not valid JSON.
+    bool run(std::string_view body, Sink &sink) {
+        if (body.empty()) {
+            return false;
+        }
+        Handler handler(sink);
+        bool complete = nlohmann::json::sax_parse(body.data(), body.data() + body.size(), &handler);
+        return complete || !handler.failed();
+    }
+
+    // Picks up {"code", "msg"} of an error object at the top level
+    struct ErrorFields {
+        Decode::ApiError error;
+        bool seen = false;
+
+        void read(const Handler &path, std::string_view key, const Scalar &value) {
+            if (path.depth() != 1 || !path.topIsObject()) {
+                return;
+            }
+            if (key == "code") {
+                error.code = static_cast<int>(value.toInteger());
+                seen = seen || (error.code != 0 && error.code != 200);
+            } else if (key == "msg") {
+                error.msg.assign(value.toString());
+            }
+        }
+
+        bool report(Decode::ApiError *out) const {
+            if (seen && out != nullptr) {
+                *out = error;
+            }
+            return seen;
+        }
+    };
+
+    class TickerPriceSink : public Sink {
+    public:
+        Decode::TickerPrice ticker;
+        ErrorFields errors;
+        bool hasPrice = false;
+
+        bool field(const Handler &path, std::string_view key, const Scalar &value) override {
+            errors.read(path, key, value);
+            if (path.depth() != 1) {
+                return true;
+            }
+            if (key == "symbol") {
+                ticker.symbol.assign(value.toString());
+            } else if (key == "price") {
+                ticker.price = value.toDouble();
+                hasPrice = true;
+            } else if (key == "time") {
+                ticker.time = value.toInteger();
+            }
+            return true;
+        }
+    };
+
+    class ServerTimeSink : public Sink {
+    public:
+        ErrorFields errors;
+        std::optional<long long> time;
+
+        bool field(const Handler &path, std::string_view key, const Scalar &value) override {
+            errors.read(path, key, value);
+            if (path.depth() == 1 && key == "serverTime") {
+                time = value.toInteger();
+            }
+            return true;
+        }
+    };
+
+    class PositionRiskSink : public Sink {
+    public:
+        std::vector<Decode::PositionRisk> positions;
+        ErrorFields errors;
+
+        bool beginObject(const Handler &path) override {
+            if (path.depth() == 2 && !path.topIsObject()) {
+                positions.emplace_back();
+            }
+            return true;
+        }
+
+        bool field(const Handler &path, std::string_view key, const Scalar &value) override {
+            errors.read(path, key, value);
+            if (path.depth() != 2 || path.topIsObject() || positions.empty()) {
+                return true;
+            }
+
+            Decode::PositionRisk &position = positions.back();
+            if (key == "symbol") {
+                position.symbol.assign(value.toString());
+            } else if (key == "positionSide") {
+                position.positionSide.assign(value.toString());
+            } else if (key == "positionAmt") {
+                position.positionAmt = value.toDouble();
+            } else if (key == "entryPrice") {
+                position.entryPrice = value.toDouble();
+            } else if (key == "markPrice") {
+                position.markPrice = value.toDouble();
+            } else if (key == "notional") {
+                position.notional = value.toDouble();
+            } else if (key == "unRealizedProfit") {
+                position.unRealizedProfit = value.toDouble();
+            } else if (key == "leverage") {
+                position.leverage = static_cast<int>(value.toInteger());
+            }
+            return true;
+        }
+    };
+
+    class OrderAckSink : public Sink {
+    public:
+        Decode::OrderAck ack;
+        ErrorFields errors;
+
+        bool field(const Handler &path, std::string_view key, const Scalar &value) override {
+            errors.read(path, key, value);
+            if (path.depth() != 1) {
+                return true;
+            }
+            if (key == "orderId") {
+                ack.orderId = value.toInteger();
+            } else if (key == "clientOrderId") {
+                ack.clientOrderId.assign(value.toString());
+            } else if (key == "symbol") {
+                ack.symbol.assign(value.toString());
+            } else if (key == "status") {
+                ack.status.assign(value.toString());
+            } else if (key == "side") {
+                ack.side.assign(value.toString());
+            } else if (key == "type") {
+                ack.type.assign(value.toString());
+            } else if (key == "price") {
+                ack.price = value.toDecimal<PriceTag>();
+            } else if (key == "stopPrice") {
+                ack.stopPrice = value.toDecimal<PriceTag>();
+            } else if (key == "origQty") {
+                ack.origQty = value.toDecimal<QtyTag>();
+            } else if (key == "executedQty") {
+                ack.executedQty = value.toDecimal<QtyTag>();
+            } else if (key == "avgPrice") {
+                ack.avgPrice = value.toDecimal<PriceTag>();
+            } else if (key == "updateTime") {
+                ack.updateTime = value.toInteger();
+            }
+            return true;
+        }
+    };
+
+    // fapi/v1/exchangeInfo: {"symbols": [{"symbol": ..., "filters": [{"filterType": ...}]}]}
+    // Filter fields can come in any order, they are collected and applied when the filter
+    // object closes.
+    class ExchangeInfoSink : public Sink {
+    public:
+        std::vector<Decode::SymbolFilters> symbols;
+        ErrorFields errors;
+
+        bool beginObject(const Handler &path) override {
+            if (inSymbol(path)) {
+                symbols.emplace_back();
+            } else if (inFilter(path)) {
+                _filter = Filter{};
+            }
+            return true;
+        }
+
+        bool endObject(const Handler &path) override {
+            if (!inFilter(path) || symbols.empty()) {
+                return true;
+            }
+
+            Decode::SymbolFilters &symbol = symbols.back();
+            if (_filter.type == "PRICE_FILTER") {
+                symbol.tickSize = Price::fromUnits(_filter.step.units());
+                symbol.minPrice = Price::fromUnits(_filter.min.units());
+                symbol.maxPrice = Price::fromUnits(_filter.max.units());
+            } else if (_filter.type == "LOT_SIZE") {
+                symbol.stepSize = _filter.step;
+                symbol.minQty = _filter.min;
+                symbol.maxQty = _filter.max;
+            } else if (_filter.type == "MARKET_LOT_SIZE") {
+                symbol.marketStepSize = _filter.step;
+                symbol.marketMinQty = _filter.min;
+                symbol.marketMaxQty = _filter.max;
+            } else if (_filter.type == "MIN_NOTIONAL") {
+                symbol.minNotional = _filter.notional;
+            }
+            return true;
+        }
+
+        bool field(const Handler &path, std::string_view key, const Scalar &value) override {
+            errors.read(path, key, value);
+            if (inSymbol(path) && !symbols.empty()) {
+                if (key == "symbol") {
+                    symbols.back().symbol.assign(value.toString());
+                } else if (key == "status") {
+                    symbols.back().status.assign(value.toString());
+                }
+            } else if (inFilter(path)) {
+                if (key == "filterType") {
+                    _filter.type.assign(value.toString());
+                } else if (key == "tickSize" || key == "stepSize") {
+                    _filter.step = value.toDecimal<QtyTag>();
+                } else if (key == "minPrice" || key == "minQty") {
+                    _filter.min = value.toDecimal<QtyTag>();
+                } else if (key == "maxPrice" || key == "maxQty") {
+                    _filter.max = value.toDecimal<QtyTag>();
+                } else if (key == "notional") {
+                    _filter.notional = value.toDecimal<PriceTag>();
+                }
+            }
+            return true;
+        }
+
+    private:
+        struct Filter {
+            std::string type;
+            Qty step;
+            Qty min;
+            Qty max;
+            Price notional;
+        };
+
+        Filter _filter;
+
+        static bool inSymbol(const Handler &path) {
+            return path.depth() == 3 && path.topIsObject() && path.keyAt(1) == "symbols";
+        }
+
+        static bool inFilter(const Handler &path) {
+            return path.depth() == 5 && path.topIsObject() && path.keyAt(1) == "symbols" && path.keyAt(3) == "filters";
+        }
+    };
+
+    // fapi/v1/leverageBracket: [{"symbol": ..., "brackets": [{"bracket": 1, ...}]}], or just
+    // the object when a symbol was requested
+    class LeverageBracketSink : public Sink {
+    public:
+        std::vector<Decode::SymbolBrackets> symbols;
+        ErrorFields errors;
+
+        bool beginObject(const Handler &path) override {
+            if (inSymbol(path)) {
+                symbols.emplace_back();
+            } else if (inBracket(path) && !symbols.empty()) {
+                symbols.back().brackets.emplace_back();
+            }
+            return true;
+        }
+
+        bool field(const Handler &path, std::string_view key, const Scalar &value) override {
+            errors.read(path, key, value);
+            if (symbols.empty()) {
+                return true;
+            }
+            if (inSymbol(path)) {
+                if (key == "symbol") {
+                    symbols.back().symbol.assign(value.toString());
+                }
+            } else if (inBracket(path) && !symbols.back().brackets.empty()) {
+                Decode::LeverageBracket &bracket = symbols.back().brackets.back();
+                if (key == "bracket") {
+                    bracket.bracket = static_cast<int>(value.toInteger());
+                } else if (key == "initialLeverage") {
+                    bracket.initialLeverage = static_cast<int>(value.toInteger());
+                } else if (key == "notionalFloor") {
+                    bracket.notionalFloor = value.toDecimal<PriceTag>();
+                } else if (key == "notionalCap") {
+                    bracket.notionalCap = value.toDecimal<PriceTag>();
+                } else if (key == "maintMarginRatio") {
+                    bracket.maintMarginRatio = value.toDouble();
+                }
+            }
+            return true;
+        }
+
+    private:
+        static size_t symbolDepth(const Handler &path) {
+            return path.topIsObject() ? 1 : 2;
+        }
+
+        static bool inSymbol(const Handler &path) {
+            return path.depth() == symbolDepth(path);
+        }
+
+        static bool inBracket(const Handler &path) {
+            return path.depth() == symbolDepth(path) + 2 && path.keyAt(symbolDepth(path)) == "brackets";
+        }
+    };
+
+    // fapi/v2/account: {"assets": [{"asset": "USDT", ...}, ...], "positions": [...], ...}
+    class AccountAssetSink : public Sink {
+    public:
+        explicit AccountAssetSink(std::string_view wanted) : _wanted(wanted) {}
+
+        std::optional<Decode::AccountAsset> found;
+        ErrorFields errors;
+
+        bool beginObject(const Handler &path) override {
+            if (inAsset(path)) {
+                _current = Decode::AccountAsset{};
+            }
+            return true;
+        }
+
+        bool endObject(const Handler &path) override {
+            if (inAsset(path) && _current.asset == _wanted) {
+                found = _current;
+                return false;
+            }
+            return true;
+        }
+
+        bool field(const Handler &path, std::string_view key, const Scalar &value) override {
+            errors.read(path, key, value);
+            if (!inAsset(path)) {
+                return true;
+            }
+            if (key == "asset") {
+                _current.asset.assign(value.toString());
+            } else if (key == "walletBalance") {
+                _current.walletBalance = value.toDouble();
+            } else if (key == "availableBalance") {
+                _current.availableBalance = value.toDouble();
+            } else if (key == "marginBalance") {
+                _current.marginBalance = value.toDouble();
+            }
+            return true;
+        }
+
+    private:
+        std::string_view _wanted;
+        Decode::AccountAsset _current;
+
+        static bool inAsset(const Handler &path) {
+            return path.depth() == 3 && path.topIsObject() && path.keyAt(1) == "assets";
+        }
+    };
+}
+
+namespace Decode {
+    std::optional<TickerPrice> tickerPrice(std::string_view body, ApiError *error) {
+        TickerPriceSink sink;
+        if (!run(body, sink) || sink.errors.report(error) || !sink.hasPrice) {
+            return std::nullopt;
+        }
+        return std::move(sink.ticker);
+    }
+
+    std::optional<std::vector<PositionRisk>> positionRisk(std::string_view body, ApiError *error) {
+        PositionRiskSink sink;
+        if (!run(body, sink) || sink.errors.report(error)) {
+            return std::nullopt;
+        }
+        return std::move(sink.positions);
+    }
+
+    OrderAck orderAck(std::string_view body) {
+        OrderAckSink sink;
+        if (!run(body, sink)) {
+            sink.ack.error = ApiError{-1, "Malformed response: " + std::string(body.substr(0, 200))};
+        } else if (sink.errors.seen) {
+            sink.ack.error = sink.errors.error;
+        }
+        return std::move(sink.ack);
+    }
+
+    std::optional<std::vector<SymbolFilters>> exchangeInfo(std::string_view body, ApiError *error) {
+        ExchangeInfoSink sink;
+        if (!run(body, sink) || sink.errors.report(error)) {
+            return std::nullopt;
+        }
+        return std::move(sink.symbols);
+    }
+
+    std::optional<std::vector<SymbolBrackets>> leverageBrackets(std::string_view body, ApiError *error) {
+        LeverageBracketSink sink;
+        if (!run(body, sink) || sink.errors.report(error)) {
+            return std::nullopt;
+        }
+        return std::move(sink.symbols);
+    }
+
+    std::optional<long long> serverTime(std::string_view body, ApiError *error) {
+        ServerTimeSink sink;
+        if (!run(body, sink) || sink.errors.report(error)) {
+            return std::nullopt;
+        }
+        return sink.time;
+    }
+
+    std::optional<AccountAsset> accountAsset(std::string_view body, std::string_view asset, ApiError *error) {
+        AccountAssetSink sink(asset);
+        if (!run(body, sink) || sink.errors.report(error)) {
+            return std::nullopt;
+        }
+        return std::move(sink.found);
+    }
+}
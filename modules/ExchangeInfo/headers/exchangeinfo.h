@@ -0,0 +1,68 @@
+#ifndef EXCHANGE_INFO_H
+#define EXCHANGE_INFO_H
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../../Order/models/APIParams/APIParams.h"
+#include "../../Decode/headers/decode.h"
+#include "../../Utils/headers/decimal.h"
+
+// Per-symbol trading rules (fapi/v1/exchangeInfo), leverage brackets and the account's
+// leverage settings, kept in memory so orders can be put on the exchange grid and startup
+// does not have to ask the exchange for any of it.
+//
+// The whole set is written to a small binary snapshot file. On startup loadSnapshot()
+// maps it and the engine can trade right away; startBackgroundRefresh() then re-fetches
+// everything from the exchange and rewrites the file.
+namespace ExchangeInfo {
+    struct SymbolMetadata {
+        Decode::SymbolFilters filters;
+        // Highest leverage first
+        std::vector<Decode::LeverageBracket> brackets;
+        // Account setting, 0 when unknown
+        int leverage = 0;
+
+        int maxLeverage() const { return brackets.empty() ? 0 : brackets.front().initialLeverage; }
+    };
+
+    // Fetches exchangeInfo and replaces the cached rules. On failure the previous rules
+    // are kept and false is returned.
+    bool refresh(const APIParams &apiParams);
+
+    // Fetches leverage brackets and the current leverage of every symbol (signed calls)
+    bool refreshLeverage(const APIParams &apiParams);
+
+    // Cached rules of `symbol`, the first call loads them
+    std::optional<Decode::SymbolFilters> filters(const APIParams &apiParams, const std::string &symbol);
+
+    std::optional<SymbolMetadata> metadata(const std::string &symbol);
+
+    // Sets the leverage unless the cache says it already is `leverage`
+    bool ensureLeverage(const APIParams &apiParams, const std::string &symbol, int leverage);
+
+    // Loads the snapshot at `path`. Leverage settings are only taken when the snapshot was
+    // written for the same account and network. False when missing or unreadable.
+    bool loadSnapshot(const std::string &path, const APIParams &apiParams);
+
+    // Writes the cache to `path` atomically (temporary file + rename)
+    bool saveSnapshot(const std::string &path, const APIParams &apiParams);
+
+    // Refreshes rules and leverage every `interval` (the first time right away) and
+    // rewrites the snapshot after each successful pass.
+    void startBackgroundRefresh(const APIParams &apiParams, const std::string &path, std::chrono::minutes interval);
+
+    void stopBackgroundRefresh();
+
+    // Nearest valid price
+    Price roundPrice(const Decode::SymbolFilters &filters, double price);
+
+    // Largest valid quantity not above `quantity`
+    Qty floorQty(const Decode::SymbolFilters &filters, double quantity);
+
+    // Why a limit order at price x quantity would fail the filters, empty if it passes
+    std::string violation(const Decode::SymbolFilters &filters, Price price, Qty quantity);
+}
+
+#endif // EXCHANGE_INFO_H
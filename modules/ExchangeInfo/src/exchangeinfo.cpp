@@ -0,0 +1,378 @@
+#include "../headers/exchangeinfo.h"
+#include "../../Http/headers/http.h"
+#include "../../Margin/headers/margin.h"
+#include "../../Log/headers/log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ExchangeInfo {
+    namespace {
+        using Snapshot = std::unordered_map<std::string, SymbolMetadata>;
+
+        // Readers copy the pointer and keep using their snapshot, writers build a new map
+        std::mutex snapshotMutex;
+        std::mutex updateMutex;
+        std::shared_ptr<const Snapshot> snapshot;
+
+        // Leverage asked for through ensureLeverage, re-applied when a refresh finds
+        // something else (changed from the UI, stale snapshot)
+        std::mutex desiredMutex;
+        std::map<std::string, int> desiredLeverage;
+
+        std::thread refresher;
+        std::mutex refresherMutex;
+        std::condition_variable refresherCv;
+        bool refresherExit = false;
+
+        std::shared_ptr<const Snapshot> current() {
+            std::scoped_lock lock(snapshotMutex);
+            return snapshot;
+        }
+
+        template<typename Fn>
+        void update(Fn &&fn) {
+            std::scoped_lock writer(updateMutex);
+            auto base = current();
+            auto next = base ? std::make_shared<Snapshot>(*base) : std::make_shared<Snapshot>();
+            fn(*next);
+            std::scoped_lock lock(snapshotMutex);
+            snapshot = std::move(next);
+        }
+
+        // Snapshot file: a header followed by fixed-size records, read in place from the
+        // mapping. Decimals are stored as their 1e-8 units.
+        constexpr char MAGIC[8] = {'E', 'X', 'M', 'E', 'T', 'A', '0', '1'};
+        constexpr size_t MAX_BRACKETS = 16;
+
+        struct FileHeader {
+            char magic[8];
+            uint32_t count;
+            uint32_t testnet;
+            uint64_t account;
+            int64_t savedAtMs;
+        };
+
+        struct FileBracket {
+            int32_t bracket;
+            int32_t initialLeverage;
+            int64_t notionalFloor;
+            int64_t notionalCap;
+            double maintMarginRatio;
+        };
+
+        struct FileRecord {
+            char symbol[32];
+            char status[16];
+            int64_t tickSize;
+            int64_t minPrice;
+            int64_t maxPrice;
+            int64_t stepSize;
+            int64_t minQty;
+            int64_t maxQty;
+            int64_t marketStepSize;
+            int64_t marketMinQty;
+            int64_t marketMaxQty;
+            int64_t minNotional;
+            int32_t leverage;
+            int32_t bracketCount;
+            FileBracket brackets[MAX_BRACKETS];
+        };
+
+        static_assert(std::is_trivially_copyable_v<FileHeader> && std::is_trivially_copyable_v<FileRecord>);
+
+        // FNV-1a of the API key, ties the leverage settings to the account that read them
+        uint64_t accountFingerprint(const APIParams &apiParams) {
+            uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char c: apiParams.apiKey) {
+                hash = (hash ^ c) * 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        template<size_t N>
+        void copyString(char (&out)[N], const std::string &value) {
+            std::memset(out, 0, N);
+            std::memcpy(out, value.data(), std::min(value.size(), N - 1));
+        }
+
+        template<size_t N>
+        std::string readString(const char (&in)[N]) {
+            return {in, strnlen(in, N)};
+        }
+
+        FileRecord toRecord(const std::string &symbol, const SymbolMetadata &metadata) {
+            FileRecord record{};
+            const Decode::SymbolFilters &filters = metadata.filters;
+            copyString(record.symbol, symbol);
+            copyString(record.status, filters.status);
+            record.tickSize = filters.tickSize.units();
+            record.minPrice = filters.minPrice.units();
+            record.maxPrice = filters.maxPrice.units();
+            record.stepSize = filters.stepSize.units();
+            record.minQty = filters.minQty.units();
+            record.maxQty = filters.maxQty.units();
+            record.marketStepSize = filters.marketStepSize.units();
+            record.marketMinQty = filters.marketMinQty.units();
+            record.marketMaxQty = filters.marketMaxQty.units();
+            record.minNotional = filters.minNotional.units();
+            record.leverage = metadata.leverage;
+            record.bracketCount = static_cast<int32_t>(std::min(metadata.brackets.size(), MAX_BRACKETS));
+            for (int32_t i = 0; i < record.bracketCount; ++i) {
+                const Decode::LeverageBracket &bracket = metadata.brackets[i];
+                record.brackets[i] = {bracket.bracket, bracket.initialLeverage, bracket.notionalFloor.units(),
+                                      bracket.notionalCap.units(), bracket.maintMarginRatio};
+            }
+            return record;
+        }
+
+        SymbolMetadata fromRecord(const FileRecord &record, bool withLeverage) {
+            SymbolMetadata metadata;
+            Decode::SymbolFilters &filters = metadata.filters;
+            filters.symbol = readString(record.symbol);
+            filters.status = readString(record.status);
+            filters.tickSize = Price::fromUnits(record.tickSize);
+            filters.minPrice = Price::fromUnits(record.minPrice);
+            filters.maxPrice = Price::fromUnits(record.maxPrice);
+            filters.stepSize = Qty::fromUnits(record.stepSize);
+            filters.minQty = Qty::fromUnits(record.minQty);
+            filters.maxQty = Qty::fromUnits(record.maxQty);
+            filters.marketStepSize = Qty::fromUnits(record.marketStepSize);
+            filters.marketMinQty = Qty::fromUnits(record.marketMinQty);
+            filters.marketMaxQty = Qty::fromUnits(record.marketMaxQty);
+            filters.minNotional = Price::fromUnits(record.minNotional);
+            metadata.leverage = withLeverage ? record.leverage : 0;
+
+            int32_t count = std::clamp<int32_t>(record.bracketCount, 0, MAX_BRACKETS);
+            for (int32_t i = 0; i < count; ++i) {
+                const FileBracket &bracket = record.brackets[i];
+                metadata.brackets.push_back({bracket.bracket, bracket.initialLeverage, Price::fromUnits(bracket.notionalFloor),
+                                             Price::fromUnits(bracket.notionalCap), bracket.maintMarginRatio});
+            }
+            return metadata;
+        }
+    }
+
+    bool refresh(const APIParams &apiParams) {
+        cpr::Response r = Http::get(apiParams.baseUrl(), "fapi/v1/exchangeInfo", cpr::Header{});
+
+        Decode::ApiError error;
+        auto symbols = Decode::exchangeInfo(r.text, &error);
+        if (!symbols || symbols->empty()) {
+            Log::error("exchangeInfo failed (", r.status_code, ", ", error.code, "): ", error.msg);
+            return false;
+        }
+
+        update([&symbols](Snapshot &next) {
+            for (auto &symbol: *symbols) {
+                std::string name = symbol.symbol;
+                next[name].filters = std::move(symbol);
+            }
+        });
+        return true;
+    }
+
+    bool refreshLeverage(const APIParams &apiParams) {
+        auto brackets = Margin::getLeverageBrackets(apiParams, "");
+        auto positions = Margin::getPositions(apiParams, "");
+        if (brackets.empty() && positions.empty()) {
+            return false;
+        }
+
+        update([&brackets, &positions](Snapshot &next) {
+            for (auto &symbol: brackets) {
+                std::sort(symbol.brackets.begin(), symbol.brackets.end(), [](const auto &a, const auto &b) {
+                    return a.bracket < b.bracket;
+                });
+                next[symbol.symbol].brackets = std::move(symbol.brackets);
+            }
+            for (const auto &position: positions) {
+                next[position.symbol].leverage = position.leverage;
+            }
+        });
+
+        std::map<std::string, int> desired;
+        {
+            std::scoped_lock lock(desiredMutex);
+            desired = desiredLeverage;
+        }
+        for (const auto &[symbol, leverage]: desired) {
+            ensureLeverage(apiParams, symbol, leverage);
+        }
+        return true;
+    }
+
+    std::optional<Decode::SymbolFilters> filters(const APIParams &apiParams, const std::string &symbol) {
+        auto rules = current();
+        if (!rules && refresh(apiParams)) {
+            rules = current();
+        }
+        if (!rules) {
+            return std::nullopt;
+        }
+
+        // Entries created by refreshLeverage alone have no filters yet
+        auto itr = rules->find(symbol);
+        if (itr == rules->end() || itr->second.filters.symbol.empty()) {
+            return std::nullopt;
+        }
+        return itr->second.filters;
+    }
+
+    std::optional<SymbolMetadata> metadata(const std::string &symbol) {
+        auto rules = current();
+        if (!rules) {
+            return std::nullopt;
+        }
+        auto itr = rules->find(symbol);
+        if (itr == rules->end()) {
+            return std::nullopt;
+        }
+        return itr->second;
+    }
+
+    bool ensureLeverage(const APIParams &apiParams, const std::string &symbol, int leverage) {
+        {
+            std::scoped_lock lock(desiredMutex);
+            desiredLeverage[symbol] = leverage;
+        }
+
+        auto cached = metadata(symbol);
+        if (cached && cached->leverage == leverage) {
+            return true;
+        }
+
+        auto response = Margin::setLeverage(apiParams, symbol, leverage);
+        if (!response.contains("leverage")) {
+            Log::error("setLeverage ", symbol, " failed: ", response.dump());
+            return false;
+        }
+
+        int applied = response["leverage"].get<int>();
+        update([&symbol, applied](Snapshot &next) {
+            next[symbol].leverage = applied;
+        });
+        return applied == leverage;
+    }
+
+    bool loadSnapshot(const std::string &path, const APIParams &apiParams) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat info{};
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(FileHeader)) {
+            close(fd);
+            return false;
+        }
+
+        auto size = static_cast<size_t>(info.st_size);
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+
+        const auto *header = static_cast<const FileHeader *>(mapping);
+        bool valid = std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                     size == sizeof(FileHeader) + static_cast<size_t>(header->count) * sizeof(FileRecord);
+        if (valid) {
+            // Leverage belongs to one account on one network, filters are public
+            bool sameAccount = header->account == accountFingerprint(apiParams) &&
+                               header->testnet == static_cast<uint32_t>(apiParams.useTestnet);
+            const auto *records = reinterpret_cast<const FileRecord *>(static_cast<const char *>(mapping) + sizeof(FileHeader));
+
+            auto loaded = std::make_shared<Snapshot>();
+            loaded->reserve(header->count);
+            for (uint32_t i = 0; i < header->count; ++i) {
+                std::string symbol = readString(records[i].symbol);
+                loaded->emplace(std::move(symbol), fromRecord(records[i], sameAccount));
+            }
+
+            std::scoped_lock writer(updateMutex);
+            std::scoped_lock lock(snapshotMutex);
+            snapshot = std::move(loaded);
+        }
+
+        munmap(mapping, size);
+        return valid;
+    }
+
+    bool saveSnapshot(const std::string &path, const APIParams &apiParams) {
+        auto rules = current();
+        if (!rules) {
+            return false;
+        }
+
+        FileHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.count = static_cast<uint32_t>(rules->size());
+        header.testnet = apiParams.useTestnet ? 1 : 0;
+        header.account = accountFingerprint(apiParams);
+        header.savedAtMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            for (const auto &[symbol, metadata]: *rules) {
+                FileRecord record = toRecord(symbol, metadata);
+                file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+            }
+            if (!file) {
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+        return std::rename(temporary.c_str(), path.c_str()) == 0;
+    }
+
+    void startBackgroundRefresh(const APIParams &apiParams, const std::string &path, std::chrono::minutes interval) {
+        stopBackgroundRefresh();
+        {
+            std::scoped_lock lock(refresherMutex);
+            refresherExit = false;
+        }
+
+        refresher = std::thread([apiParams, path, interval]() {
+            while (true) {
+                bool rules = refresh(apiParams);
+                bool leverage = refreshLeverage(apiParams);
+                if ((rules || leverage) && !saveSnapshot(path, apiParams)) {
+                    Log::warn("Could not write exchange snapshot ", path);
+                }
+
+                std::unique_lock lock(refresherMutex);
+                if (refresherCv.wait_for(lock, interval, []() { return refresherExit; })) {
+                    return;
+                }
+            }
+        });
+    }
+
+    void stopBackgroundRefresh() {
+        if (refresher.joinable()) {
+            {
+                std::scoped_lock lock(refresherMutex);
+                refresherExit = true;
+            }
+            refresherCv.notify_all();
+            refresher.join();
+        }
+    }
+}
@@ -0,0 +1,33 @@
+#include "../headers/exchangeinfo.h"
+
+// Filter checks are plain arithmetic, kept apart from the cache so tools can link them alone
+namespace ExchangeInfo {
+    Price roundPrice(const Decode::SymbolFilters &filters, double price) {
+        return Price::fromDouble(price).roundTo(filters.tickSize);
+    }
+
+    Qty floorQty(const Decode::SymbolFilters &filters, double quantity) {
+        // fromDouble first so 0.0029999999 (really 0.003) is not floored a whole step down
+        return Qty::fromDouble(quantity).floorTo(filters.stepSize);
+    }
+
+    std::string violation(const Decode::SymbolFilters &filters, Price price, Qty quantity) {
+        if (!filters.minPrice.isZero() && price < filters.minPrice) {
+            return "price " + price.toString() + " below minPrice " + filters.minPrice.toString();
+        }
+        if (!filters.maxPrice.isZero() && price > filters.maxPrice) {
+            return "price " + price.toString() + " above maxPrice " + filters.maxPrice.toString();
+        }
+        if (quantity < filters.minQty || quantity.isZero()) {
+            return "quantity " + quantity.toString() + " below minQty " + filters.minQty.toString();
+        }
+        if (!filters.maxQty.isZero() && quantity > filters.maxQty) {
+            return "quantity " + quantity.toString() + " above maxQty " + filters.maxQty.toString();
+        }
+        Price value = notional(price, quantity);
+        if (value < filters.minNotional) {
+            return "notional " + value.toString() + " below minNotional " + filters.minNotional.toString();
+        }
+        return "";
+    }
+}
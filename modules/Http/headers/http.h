@@ -0,0 +1,98 @@
+#ifndef HTTP_H
+#define HTTP_H
+
+#include <array>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <curl/curl.h>
+#include <cpr/cpr.h>
+
+namespace Http {
+    enum class Method {
+        GET,
+        POST,
+        PUT,
+        DELETE
+    };
+
+    // Order of service when the request weight budget runs low, see RequestScheduler
+    enum class Priority : uint8_t {
+        // Placing and canceling orders
+        Trade,
+        // Answers something waits for right now
+        Query,
+        // Periodic checks, dropped rather than queued
+        Poll
+    };
+
+    // Keeps long-lived cpr sessions (one curl easy handle each) per base URL so that
+    // consecutive calls reuse the TCP connection and TLS session instead of
+    // re-resolving and re-handshaking on every request. Safe to use from any thread,
+    // each request leases a session exclusively for its duration.
+    class SessionPool {
+    public:
+        explicit SessionPool(size_t maxIdlePerHost = 8,
+                             std::chrono::seconds maxIdleTime = std::chrono::seconds(50));
+
+        ~SessionPool();
+
+        SessionPool(const SessionPool &) = delete;
+
+        SessionPool &operator=(const SessionPool &) = delete;
+
+        cpr::Response request(Method method,
+                              const std::string &baseUrl,
+                              const std::string &pathAndQuery,
+                              const cpr::Header &header);
+
+        // Opens `connections` sessions to baseUrl up front so the first real request
+        // does not pay for DNS, TCP connect and the TLS handshake.
+        void warmUp(const std::string &baseUrl, size_t connections);
+
+        static SessionPool &shared();
+
+    private:
+        struct IdleSession {
+            std::unique_ptr<cpr::Session> session;
+            std::chrono::steady_clock::time_point lastUsed;
+        };
+
+        std::unique_ptr<cpr::Session> acquire(const std::string &baseUrl);
+
+        void release(const std::string &baseUrl, std::unique_ptr<cpr::Session> session);
+
+        std::unique_ptr<cpr::Session> createSession();
+
+        static void lockShare(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr);
+
+        static void unlockShare(CURL *handle, curl_lock_data data, void *userptr);
+
+        const size_t _maxIdlePerHost;
+        const std::chrono::seconds _maxIdleTime;
+        std::mutex _mutex;
+        std::unordered_map<std::string, std::vector<IdleSession>> _idle;
+        CURLSH *_share;
+        std::array<std::mutex, CURL_LOCK_DATA_LAST> _shareLocks;
+    };
+
+    // Every request waits for its weight in RequestScheduler::shared() first. A shed poll
+    // comes back without being sent, error code REQUEST_CANCELLED.
+    cpr::Response get(const std::string &baseUrl, const std::string &pathAndQuery, const cpr::Header &header,
+                      SessionPool &pool = SessionPool::shared(), Priority priority = Priority::Query);
+
+    cpr::Response post(const std::string &baseUrl, const std::string &pathAndQuery, const cpr::Header &header,
+                      SessionPool &pool = SessionPool::shared(), Priority priority = Priority::Query);
+
+    cpr::Response put(const std::string &baseUrl, const std::string &pathAndQuery, const cpr::Header &header,
+                      SessionPool &pool = SessionPool::shared(), Priority priority = Priority::Query);
+
+    cpr::Response del(const std::string &baseUrl, const std::string &pathAndQuery, const cpr::Header &header,
+                      SessionPool &pool = SessionPool::shared(), Priority priority = Priority::Query);
+}
+
+#endif // HTTP_H
@@ -0,0 +1,41 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <chrono>
+#include <mutex>
+
+namespace Http {
+    // Holds up to `capacity` tokens and refills continuously at `perSecond`. Safe to use
+    // from any thread.
+    //
+    //     Http::TokenBucket orders(100, 18);
+    //     if (!orders.tryAcquire()) { /* over budget, do not send */ }
+    class TokenBucket {
+    public:
+        TokenBucket(double capacity, double perSecond);
+
+        // Takes `tokens` if that many are available with `reserve` still left, never blocks
+        bool tryAcquire(double tokens = 1, double reserve = 0);
+
+        double available();
+
+        // Time until `tokens` are available, zero when they already are
+        std::chrono::nanoseconds timeUntil(double tokens);
+
+        // Lowers the level to at most `tokens`, e.g. to what the server reports as left
+        void cap(double tokens);
+
+        double capacity() const { return _capacity; }
+
+    private:
+        void refill(std::chrono::steady_clock::time_point now);
+
+        std::mutex _mutex;
+        const double _capacity;
+        const double _perSecond;
+        double _tokens;
+        std::chrono::steady_clock::time_point _last;
+    };
+}
+
+#endif // RATE_LIMIT_H
@@ -0,0 +1,100 @@
+#ifndef REQUEST_SCHEDULER_H
+#define REQUEST_SCHEDULER_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "http.h"
+#include "ratelimit.h"
+
+namespace Http {
+    // Weight of a request against the exchange's per-IP limit (X-MBX-USED-WEIGHT-1M)
+    int weightOf(Method method, std::string_view pathAndQuery);
+
+    // Numeric response header, nullopt when missing or malformed
+    std::optional<long> headerNumber(const cpr::Response &r, const std::string &name);
+
+    // Spends the per-IP request weight of the whole process (every account shares the IP).
+    //
+    // The budget is a token bucket refilling at the exchange's per-minute limit and capped
+    // at what the used-weight header of every response says is left. Trades may spend all
+    // of it, queries leave a reserve for trades and wait while a higher priority is
+    // waiting, polls are dropped once half the budget is gone. After a 429/418 nothing but
+    // trades is sent until Retry-After has passed.
+    class RequestScheduler {
+    public:
+        explicit RequestScheduler(double weightPerMinute);
+
+        // Blocks until `weight` may be spent. False only for a poll that was shed.
+        bool acquire(Priority priority, int weight);
+
+        // Rate limit headers and status of a response
+        void observe(const cpr::Response &r);
+
+        static RequestScheduler &shared();
+
+        // Budget of shared() when the exchange (or a mock of it) allows another limit.
+        // Only has an effect before the first request.
+        static void setSharedLimit(double weightPerMinute);
+
+    private:
+        double reserveOf(Priority priority) const;
+
+        TokenBucket _weight;
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        std::array<size_t, 3> _waiting{};
+        std::chrono::steady_clock::time_point _pausedUntil;
+    };
+
+    // Callers asking for the same key while a call is in flight get its result instead of
+    // sending a request of their own.
+    template<typename T>
+    class Coalescer {
+    public:
+        template<typename Fn>
+        T run(const std::string &key, Fn &&fn) {
+            std::promise<T> promise;
+            std::shared_future<T> result;
+            bool owner = false;
+            {
+                std::scoped_lock lock(_mutex);
+                auto itr = _inFlight.find(key);
+                if (itr != _inFlight.end()) {
+                    result = itr->second;
+                } else {
+                    result = promise.get_future().share();
+                    _inFlight.emplace(key, result);
+                    owner = true;
+                }
+            }
+            if (!owner) {
+                return result.get();
+            }
+
+            try {
+                promise.set_value(fn());
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+            {
+                std::scoped_lock lock(_mutex);
+                _inFlight.erase(key);
+            }
+            return result.get();
+        }
+
+    private:
+        std::mutex _mutex;
+        std::unordered_map<std::string, std::shared_future<T>> _inFlight;
+    };
+}
+
+#endif // REQUEST_SCHEDULER_H
@@ -0,0 +1,71 @@
+#ifndef SIGNED_REQUEST_H
+#define SIGNED_REQUEST_H
+
+#include <string>
+#include <string_view>
+#include "../../Utils/headers/decimal.h"
+
+namespace Http {
+    // Builds "path?query&signature=..." for the signed endpoints in one buffer. Numbers are
+    // written with to_chars and the signature is hex encoded straight into the buffer, so
+    // once the buffer has grown nothing is allocated per request.
+    //
+    //     auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/order");
+    //     request.param("symbol", symbol).param("quantity", quantity).timestamp();
+    //     Http::post(baseUrl, request.sign(apiParams.apiSecret), header);
+    class SignedRequestBuilder {
+    public:
+        explicit SignedRequestBuilder(std::string_view path = "", size_t capacity = 512);
+
+        // Starts a new request, keeping the buffer
+        SignedRequestBuilder &reset(std::string_view path);
+
+        SignedRequestBuilder &param(std::string_view key, std::string_view value);
+
+        SignedRequestBuilder &param(std::string_view key, const char *value);
+
+        SignedRequestBuilder &param(std::string_view key, long long value);
+
+        SignedRequestBuilder &param(std::string_view key, long value);
+
+        SignedRequestBuilder &param(std::string_view key, int value);
+
+        // Fixed notation with 6 decimals, same as std::to_string
+        SignedRequestBuilder &param(std::string_view key, double value);
+
+        SignedRequestBuilder &param(std::string_view key, bool value);
+
+        // Shortest exact form, "0.001" or "64072.7"
+        template<typename Tag>
+        SignedRequestBuilder &param(std::string_view key, const Decimal<Tag> &value) {
+            this->key(key);
+            char digits[Decimal<Tag>::MAX_CHARS];
+            _buffer.append(digits, value.format(digits));
+            return *this;
+        }
+
+        // Percent-encodes the value, for JSON and other free-form parameters
+        SignedRequestBuilder &paramEncoded(std::string_view key, std::string_view value);
+
+        // Appends timestamp=<epoch ms> on the exchange clock (ClockSync)
+        SignedRequestBuilder &timestamp();
+
+        // Appends the signature of the query and returns the full path and query. The
+        // reference stays valid until the builder is reset.
+        const std::string &sign(std::string_view secret);
+
+        std::string_view query() const;
+
+        // Builder owned by the calling thread. The returned reference is reset on the next
+        // call from the same thread.
+        static SignedRequestBuilder &forThread(std::string_view path);
+
+    private:
+        std::string _buffer;
+        size_t _queryStart = 0;
+
+        void key(std::string_view key);
+    };
+}
+
+#endif // SIGNED_REQUEST_H
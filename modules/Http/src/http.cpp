@@ -0,0 +1,237 @@
+#include "../headers/http.h"
+#include "../headers/scheduler.h"
+#include "../../Metrics/headers/metrics.h"
+
+namespace Http {
+    namespace {
+        cpr::Response perform(cpr::Session &session, Method method) {
+            switch (method) {
+                case Method::POST:
+                    return session.Post();
+                case Method::PUT:
+                    return session.Put();
+                case Method::DELETE:
+                    return session.Delete();
+                case Method::GET:
+                default:
+                    return session.Get();
+            }
+        }
+
+        const char *methodName(Method method) {
+            switch (method) {
+                case Method::POST:
+                    return "POST";
+                case Method::PUT:
+                    return "PUT";
+                case Method::DELETE:
+                    return "DELETE";
+                case Method::GET:
+                default:
+                    return "GET";
+            }
+        }
+
+        // Total time per method/endpoint/status and where it went, from curl's timers (all
+        // of them count from the start of the transfer). DNS, connect and TLS are 0 on a
+        // reused connection.
+        void observe(Method method, const std::string &pathAndQuery, cpr::Session &session, const cpr::Response &r) {
+            CURL *handle = session.GetCurlHolder()->handle;
+            curl_off_t dns = 0, connect = 0, tls = 0, pretransfer = 0, firstByte = 0, total = 0;
+            curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+            curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connect);
+            curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &tls);
+            curl_easy_getinfo(handle, CURLINFO_PRETRANSFER_TIME_T, &pretransfer);
+            curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &firstByte);
+            curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &total);
+
+            std::string endpoint = "endpoint=\"" + pathAndQuery.substr(0, pathAndQuery.find('?')) + "\"";
+            std::string labels = std::string("method=\"") + methodName(method) + "\"," + endpoint +
+                                 ",status=\"" + std::to_string(r.status_code) + "\"";
+            Metrics::histogram("executioner_http_request_seconds", labels).record(static_cast<uint64_t>(total));
+
+            auto phase = [&endpoint](std::string_view name, curl_off_t from, curl_off_t to) {
+                std::string labels = endpoint + ",phase=\"" + std::string(name) + "\"";
+                Metrics::histogram("executioner_http_phase_seconds", labels).record(static_cast<uint64_t>(std::max<curl_off_t>(to - from, 0)));
+            };
+            phase("dns", 0, dns);
+            phase("connect", dns, connect);
+            phase("tls", connect, std::max(tls, connect));
+            phase("server", pretransfer, firstByte);
+            phase("transfer", firstByte, total);
+        }
+
+        cpr::Response scheduled(Method method, const std::string &baseUrl, const std::string &pathAndQuery,
+                                const cpr::Header &header, SessionPool &pool, Priority priority) {
+            RequestScheduler &scheduler = RequestScheduler::shared();
+            if (!scheduler.acquire(priority, weightOf(method, pathAndQuery))) {
+                cpr::Response shed;
+                shed.error.code = cpr::ErrorCode::REQUEST_CANCELLED;
+                shed.error.message = "Shed, request weight budget is low";
+                return shed;
+            }
+            cpr::Response r = pool.request(method, baseUrl, pathAndQuery, header);
+            scheduler.observe(r);
+            return r;
+        }
+
+        // Transport level failures mean the pooled connection can not be trusted anymore.
+        bool isBrokenConnection(const cpr::Error &error) {
+            switch (error.code) {
+                case cpr::ErrorCode::CONNECTION_FAILURE:
+                case cpr::ErrorCode::EMPTY_RESPONSE:
+                case cpr::ErrorCode::NETWORK_RECEIVE_ERROR:
+                case cpr::ErrorCode::NETWORK_SEND_FAILURE:
+                case cpr::ErrorCode::OPERATION_TIMEDOUT:
+                case cpr::ErrorCode::SSL_CONNECT_ERROR:
+                case cpr::ErrorCode::GENERIC_SSL_ERROR:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    SessionPool::SessionPool(size_t maxIdlePerHost, std::chrono::seconds maxIdleTime) :
+            _maxIdlePerHost(maxIdlePerHost),
+            _maxIdleTime(maxIdleTime),
+            _share(curl_share_init()) {
+        // DNS results and TLS sessions are shared between all handles of the pool, so a
+        // freshly created session resumes TLS instead of doing a full handshake.
+        // Connections themselves stay owned by their handle, curl does not support
+        // sharing the connection cache between concurrent threads.
+        curl_share_setopt(_share, CURLSHOPT_LOCKFUNC, &SessionPool::lockShare);
+        curl_share_setopt(_share, CURLSHOPT_UNLOCKFUNC, &SessionPool::unlockShare);
+        curl_share_setopt(_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    SessionPool::~SessionPool() {
+        {
+            std::scoped_lock lock(_mutex);
+            _idle.clear();
+        }
+        curl_share_cleanup(_share);
+    }
+
+    void SessionPool::lockShare(CURL *, curl_lock_data data, curl_lock_access, void *userptr) {
+        static_cast<SessionPool *>(userptr)->_shareLocks[data].lock();
+    }
+
+    void SessionPool::unlockShare(CURL *, curl_lock_data data, void *userptr) {
+        static_cast<SessionPool *>(userptr)->_shareLocks[data].unlock();
+    }
+
+    std::unique_ptr<cpr::Session> SessionPool::createSession() {
+        auto session = std::make_unique<cpr::Session>();
+        session->SetConnectTimeout(cpr::ConnectTimeout{std::chrono::seconds(5)});
+
+        CURL *handle = session->GetCurlHolder()->handle;
+        curl_easy_setopt(handle, CURLOPT_SHARE, _share);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, 15L);
+        curl_easy_setopt(handle, CURLOPT_TCP_KEEPINTVL, 5L);
+        curl_easy_setopt(handle, CURLOPT_TCP_NODELAY, 1L);
+        curl_easy_setopt(handle, CURLOPT_MAXAGE_CONN, static_cast<long>(_maxIdleTime.count()));
+        return session;
+    }
+
+    std::unique_ptr<cpr::Session> SessionPool::acquire(const std::string &baseUrl) {
+        {
+            std::scoped_lock lock(_mutex);
+            auto &idle = _idle[baseUrl];
+            auto now = std::chrono::steady_clock::now();
+            while (!idle.empty()) {
+                IdleSession entry = std::move(idle.back());
+                idle.pop_back();
+                // The exchange drops idle keep-alive connections, don't bet on stale ones.
+                if (now - entry.lastUsed < _maxIdleTime) {
+                    return std::move(entry.session);
+                }
+            }
+        }
+
+        return createSession();
+    }
+
+    void SessionPool::release(const std::string &baseUrl, std::unique_ptr<cpr::Session> session) {
+        std::scoped_lock lock(_mutex);
+        auto &idle = _idle[baseUrl];
+        if (idle.size() < _maxIdlePerHost) {
+            idle.push_back({std::move(session), std::chrono::steady_clock::now()});
+        }
+    }
+
+    cpr::Response SessionPool::request(Method method,
+                                       const std::string &baseUrl,
+                                       const std::string &pathAndQuery,
+                                       const cpr::Header &header) {
+        auto session = acquire(baseUrl);
+        session->SetUrl(cpr::Url{baseUrl + "/" + pathAndQuery});
+        session->SetHeader(header);
+        cpr::Response r = perform(*session, method);
+        observe(method, pathAndQuery, *session, r);
+
+        if (!isBrokenConnection(r.error)) {
+            release(baseUrl, std::move(session));
+            return r;
+        }
+
+        // Only GETs are replayed, a POST/DELETE may already have reached the exchange.
+        if (method != Method::GET) {
+            return r;
+        }
+
+        session = createSession();
+        session->SetUrl(cpr::Url{baseUrl + "/" + pathAndQuery});
+        session->SetHeader(header);
+        r = perform(*session, method);
+        observe(method, pathAndQuery, *session, r);
+        if (!isBrokenConnection(r.error)) {
+            release(baseUrl, std::move(session));
+        }
+        return r;
+    }
+
+    void SessionPool::warmUp(const std::string &baseUrl, size_t connections) {
+        std::vector<std::unique_ptr<cpr::Session>> sessions;
+        for (size_t i = 0; i < connections; ++i) {
+            auto session = acquire(baseUrl);
+            session->SetUrl(cpr::Url{baseUrl + "/fapi/v1/ping"});
+            cpr::Response r = session->Get();
+            if (!isBrokenConnection(r.error)) {
+                sessions.push_back(std::move(session));
+            }
+        }
+
+        for (auto &session: sessions) {
+            release(baseUrl, std::move(session));
+        }
+    }
+
+    SessionPool &SessionPool::shared() {
+        static SessionPool pool;
+        return pool;
+    }
+
+    cpr::Response get(const std::string &baseUrl, const std::string &pathAndQuery, const cpr::Header &header,
+                      SessionPool &pool, Priority priority) {
+        return scheduled(Method::GET, baseUrl, pathAndQuery, header, pool, priority);
+    }
+
+    cpr::Response post(const std::string &baseUrl, const std::string &pathAndQuery, const cpr::Header &header,
+                      SessionPool &pool, Priority priority) {
+        return scheduled(Method::POST, baseUrl, pathAndQuery, header, pool, priority);
+    }
+
+    cpr::Response put(const std::string &baseUrl, const std::string &pathAndQuery, const cpr::Header &header,
+                      SessionPool &pool, Priority priority) {
+        return scheduled(Method::PUT, baseUrl, pathAndQuery, header, pool, priority);
+    }
+
+    cpr::Response del(const std::string &baseUrl, const std::string &pathAndQuery, const cpr::Header &header,
+                      SessionPool &pool, Priority priority) {
+        return scheduled(Method::DELETE, baseUrl, pathAndQuery, header, pool, priority);
+    }
+}
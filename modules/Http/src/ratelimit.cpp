@@ -0,0 +1,51 @@
+#include "../headers/ratelimit.h"
+
+#include <algorithm>
+
+namespace Http {
+    TokenBucket::TokenBucket(double capacity, double perSecond) :
+            _capacity(capacity),
+            _perSecond(perSecond),
+            _tokens(capacity),
+            _last(std::chrono::steady_clock::now()) {}
+
+    void TokenBucket::refill(std::chrono::steady_clock::time_point now) {
+        std::chrono::duration<double> elapsed = now - _last;
+        _tokens = std::min(_capacity, _tokens + elapsed.count() * _perSecond);
+        _last = now;
+    }
+
+    bool TokenBucket::tryAcquire(double tokens, double reserve) {
+        std::scoped_lock lock(_mutex);
+        refill(std::chrono::steady_clock::now());
+        if (_tokens - tokens < reserve) {
+            return false;
+        }
+        _tokens -= tokens;
+        return true;
+    }
+
+    double TokenBucket::available() {
+        std::scoped_lock lock(_mutex);
+        refill(std::chrono::steady_clock::now());
+        return _tokens;
+    }
+
+    std::chrono::nanoseconds TokenBucket::timeUntil(double tokens) {
+        std::scoped_lock lock(_mutex);
+        refill(std::chrono::steady_clock::now());
+        if (_tokens >= tokens) {
+            return std::chrono::nanoseconds(0);
+        }
+        if (tokens > _capacity || _perSecond <= 0) {
+            return std::chrono::nanoseconds::max();
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>((tokens - _tokens) / _perSecond));
+    }
+
+    void TokenBucket::cap(double tokens) {
+        std::scoped_lock lock(_mutex);
+        refill(std::chrono::steady_clock::now());
+        _tokens = std::min(_tokens, std::max(tokens, 0.0));
+    }
+}
@@ -0,0 +1,155 @@
+#include "../headers/scheduler.h"
+#include "../../Log/headers/log.h"
+#include "../../Metrics/headers/metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+
+namespace Http {
+    namespace {
+        // Futures request weight per IP and minute
+        constexpr double WEIGHT_PER_MINUTE = 2400;
+        std::atomic<double> sharedWeightPerMinute{WEIGHT_PER_MINUTE};
+        // Share of the budget queries leave for trades
+        constexpr double TRADE_RESERVE = 0.1;
+        // Polls are shed once less than this share is left
+        constexpr double POLL_RESERVE = 0.5;
+        // Back-off after a 429/418 that came without Retry-After
+        constexpr std::chrono::seconds DEFAULT_RETRY_AFTER{60};
+        // Waiters re-check at least this often
+        constexpr std::chrono::milliseconds MAX_WAIT_SLICE{500};
+
+        const char *priorityName(Priority priority) {
+            switch (priority) {
+                case Priority::Trade:
+                    return "trade";
+                case Priority::Query:
+                    return "query";
+                case Priority::Poll:
+                default:
+                    return "poll";
+            }
+        }
+    }
+
+    int weightOf(Method method, std::string_view pathAndQuery) {
+        std::string_view path = pathAndQuery.substr(0, pathAndQuery.find('?'));
+        bool perSymbol = pathAndQuery.find("symbol=") != std::string_view::npos;
+
+        if (path == "fapi/v1/order") {
+            // New orders only count against the account's order limits
+            return method == Method::POST ? 0 : 1;
+        }
+        if (path == "fapi/v1/batchOrders") {
+            return method == Method::POST ? 5 : 1;
+        }
+        if (path == "fapi/v1/openOrders") {
+            return perSymbol ? 1 : 40;
+        }
+        if (path == "fapi/v1/ticker/price") {
+            return perSymbol ? 1 : 2;
+        }
+        if (path == "fapi/v2/positionRisk" || path == "fapi/v2/account") {
+            return 5;
+        }
+        return 1;
+    }
+
+    std::optional<long> headerNumber(const cpr::Response &r, const std::string &name) {
+        auto itr = r.header.find(name);
+        if (itr == r.header.end()) {
+            return std::nullopt;
+        }
+        long value = 0;
+        const std::string &text = itr->second;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    RequestScheduler::RequestScheduler(double weightPerMinute) :
+            _weight(weightPerMinute, weightPerMinute / 60) {}
+
+    double RequestScheduler::reserveOf(Priority priority) const {
+        switch (priority) {
+            case Priority::Trade:
+                return 0;
+            case Priority::Query:
+                return _weight.capacity() * TRADE_RESERVE;
+            case Priority::Poll:
+            default:
+                return _weight.capacity() * POLL_RESERVE;
+        }
+    }
+
+    bool RequestScheduler::acquire(Priority priority, int weight) {
+        auto start = std::chrono::steady_clock::now();
+        auto level = static_cast<size_t>(priority);
+        double reserve = reserveOf(priority);
+        bool waited = false;
+
+        std::unique_lock lock(_mutex);
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            // The exchange answers orders itself even while the IP is limited
+            bool paused = priority != Priority::Trade && now < _pausedUntil;
+            bool preempted = std::any_of(_waiting.begin(), _waiting.begin() + level, [](size_t waiting) {
+                return waiting > 0;
+            });
+
+            if (!paused && !preempted && _weight.tryAcquire(weight, reserve)) {
+                break;
+            }
+            if (priority == Priority::Poll) {
+                Log::debug("Shedding a poll of weight ", weight, ", ", _weight.available(), " left");
+                return false;
+            }
+
+            if (!waited) {
+                ++_waiting[level];
+                waited = true;
+            }
+            auto wait = paused ? _pausedUntil - now : _weight.timeUntil(weight + reserve);
+            _cv.wait_for(lock, std::clamp<std::chrono::steady_clock::duration>(wait, std::chrono::milliseconds(1), MAX_WAIT_SLICE));
+        }
+
+        if (waited) {
+            --_waiting[level];
+            lock.unlock();
+            _cv.notify_all();
+
+            std::string labels = std::string("priority=\"") + priorityName(priority) + "\"";
+            Metrics::histogram("executioner_http_scheduler_wait_seconds", labels).record(std::chrono::steady_clock::now() - start);
+        }
+        return true;
+    }
+
+    void RequestScheduler::observe(const cpr::Response &r) {
+        if (auto used = headerNumber(r, "X-MBX-USED-WEIGHT-1M")) {
+            _weight.cap(_weight.capacity() - static_cast<double>(*used));
+        }
+
+        if (r.status_code != 429 && r.status_code != 418) {
+            return;
+        }
+        auto retryAfter = headerNumber(r, "Retry-After");
+        auto pause = retryAfter ? std::chrono::seconds(*retryAfter) : DEFAULT_RETRY_AFTER;
+        Log::warn("Request weight limit hit (HTTP ", r.status_code, "), holding queries and polls for ", pause.count(), "s");
+
+        std::scoped_lock lock(_mutex);
+        _pausedUntil = std::max(_pausedUntil, std::chrono::steady_clock::now() + pause);
+        _weight.cap(0);
+    }
+
+    RequestScheduler &RequestScheduler::shared() {
+        static RequestScheduler scheduler(sharedWeightPerMinute.load());
+        return scheduler;
+    }
+
+    void RequestScheduler::setSharedLimit(double weightPerMinute) {
+        sharedWeightPerMinute = weightPerMinute;
+    }
+}
@@ -0,0 +1,98 @@
+#include "../headers/signedrequest.h"
+#include "../../Utils/headers/hmac.h"
+#include "../../Utils/headers/utils.h"
+#include "../../ClockSync/headers/clocksync.h"
+
+#include <charconv>
+
+namespace Http {
+    SignedRequestBuilder::SignedRequestBuilder(std::string_view path, size_t capacity) {
+        _buffer.reserve(capacity);
+        reset(path);
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::reset(std::string_view path) {
+        _buffer.assign(path);
+        _buffer.push_back('?');
+        _queryStart = _buffer.size();
+        return *this;
+    }
+
+    void SignedRequestBuilder::key(std::string_view key) {
+        if (_buffer.size() > _queryStart) {
+            _buffer.push_back('&');
+        }
+        _buffer.append(key);
+        _buffer.push_back('=');
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::param(std::string_view key, std::string_view value) {
+        this->key(key);
+        _buffer.append(value);
+        return *this;
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::param(std::string_view key, const char *value) {
+        return param(key, std::string_view(value));
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::param(std::string_view key, long long value) {
+        this->key(key);
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        _buffer.append(digits, result.ptr);
+        return *this;
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::param(std::string_view key, long value) {
+        return param(key, static_cast<long long>(value));
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::param(std::string_view key, int value) {
+        return param(key, static_cast<long long>(value));
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::param(std::string_view key, double value) {
+        this->key(key);
+        char digits[64];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 6);
+        _buffer.append(digits, result.ptr);
+        return *this;
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::param(std::string_view key, bool value) {
+        return param(key, value ? std::string_view("true") : std::string_view("false"));
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::paramEncoded(std::string_view key, std::string_view value) {
+        this->key(key);
+        Utils::appendUrlEncoded(_buffer, value);
+        return *this;
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::timestamp() {
+        return param("timestamp", static_cast<long long>(ClockSync::nowMs()));
+    }
+
+    const std::string &SignedRequestBuilder::sign(std::string_view secret) {
+        const Utils::HmacSha256 &hmac = Utils::HmacSha256::forThread(secret);
+
+        // Hex needs no escaping, the signature is written in place behind the query
+        size_t queryEnd = _buffer.size();
+        key("signature");
+        size_t signatureStart = _buffer.size();
+        _buffer.resize(signatureStart + Utils::HmacSha256::HEX_SIZE);
+        hmac.signHex(std::string_view(_buffer).substr(_queryStart, queryEnd - _queryStart),
+                     _buffer.data() + signatureStart);
+        return _buffer;
+    }
+
+    std::string_view SignedRequestBuilder::query() const {
+        return std::string_view(_buffer).substr(_queryStart);
+    }
+
+    SignedRequestBuilder &SignedRequestBuilder::forThread(std::string_view path) {
+        thread_local SignedRequestBuilder builder;
+        return builder.reset(path);
+    }
+}
@@ -0,0 +1,142 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Asynchronous logger for the execution threads.
+//
+//     Log::info("Order ", orderId, " ", status, " filled ", executedQty);
+//
+// The arguments are copied as typed binary fields into a ring buffer owned by the calling
+// thread (single producer, single consumer). A background thread drains every ring,
+// formats the records and writes them out, so a slow terminal or journald never stalls
+// the thread that sent the order. When a ring is full the record is dropped (and counted)
+// or the caller waits, depending on Config::whenFull.
+namespace Log {
+    enum class Level : uint8_t {
+        Debug,
+        Info,
+        Warn,
+        Error
+    };
+
+    enum class WhenFull : uint8_t {
+        Drop,
+        Block
+    };
+
+    struct Config {
+        Level level = Level::Info;
+        WhenFull whenFull = WhenFull::Drop;
+        // Appended to, stdout when empty
+        std::string path;
+        // Per thread, rings that already exist keep their size
+        size_t ringBytes = 256 * 1024;
+    };
+
+    void configure(const Config &config);
+
+    // "debug", "info", "warn" or "error", `fallback` for anything else
+    Level parseLevel(std::string_view name, Level fallback = Level::Info);
+
+    bool enabled(Level level);
+
+    // Returns once everything logged before the call has been written
+    void flush();
+
+    // Records dropped because a ring was full
+    uint64_t dropped();
+
+    namespace detail {
+        enum class Field : uint8_t {
+            Int,
+            UInt,
+            Double,
+            Bool,
+            Char,
+            String,
+            Decimal
+        };
+
+        // Longer strings are cut, a record has to fit in a ring
+        constexpr size_t MAX_STRING = 16 * 1024;
+
+        // The calling thread's record buffer, cleared with room for the header
+        std::string &begin();
+
+        void submit(Level level, std::string &record);
+
+        template<typename T>
+        void put(std::string &record, Field field, const T &value) {
+            record.push_back(static_cast<char>(field));
+            record.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        inline void putString(std::string &record, std::string_view value) {
+            auto length = static_cast<uint32_t>(std::min(value.size(), MAX_STRING));
+            put(record, Field::String, length);
+            record.append(value.data(), length);
+        }
+
+        template<typename T>
+        concept DecimalLike = requires(const T &value) {
+            { value.units() } -> std::same_as<int64_t>;
+            T::SCALE;
+        };
+
+        template<typename T>
+        void encode(std::string &record, const T &value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                put(record, Field::Bool, value);
+            } else if constexpr (std::is_same_v<T, char>) {
+                put(record, Field::Char, value);
+            } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+                put(record, Field::Int, static_cast<int64_t>(value));
+            } else if constexpr (std::is_integral_v<T>) {
+                put(record, Field::UInt, static_cast<uint64_t>(value));
+            } else if constexpr (std::is_floating_point_v<T>) {
+                put(record, Field::Double, static_cast<double>(value));
+            } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+                putString(record, std::string_view(value));
+            } else if constexpr (DecimalLike<T>) {
+                put(record, Field::Decimal, value.units());
+            } else {
+                // Anything else is formatted here, keep it off the hot path
+                std::ostringstream text;
+                text << value;
+                putString(record, text.str());
+            }
+        }
+    }
+
+    template<typename... Args>
+    void write(Level level, const Args &...args) {
+        if (!enabled(level)) {
+            return;
+        }
+        std::string &record = detail::begin();
+        (detail::encode(record, args), ...);
+        detail::submit(level, record);
+    }
+
+    template<typename... Args>
+    void debug(const Args &...args) { write(Level::Debug, args...); }
+
+    template<typename... Args>
+    void info(const Args &...args) { write(Level::Info, args...); }
+
+    template<typename... Args>
+    void warn(const Args &...args) { write(Level::Warn, args...); }
+
+    template<typename... Args>
+    void error(const Args &...args) { write(Level::Error, args...); }
+}
+
+#endif // LOG_H
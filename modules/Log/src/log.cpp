@@ -0,0 +1,419 @@
+#include "../headers/log.h"
+#include "../../Utils/headers/decimal.h"
+
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Log {
+    namespace {
+        // size (uint32), level (uint8), padding, wall clock ns (int64)
+        constexpr size_t HEADER = 16;
+
+        size_t roundUpToPowerOfTwo(size_t value) {
+            size_t result = 4096;
+            while (result < value) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        // Byte ring with one producer (the owning thread) and one consumer (the writer).
+        // Positions only grow, the index is position & mask.
+        class Ring {
+        public:
+            Ring(size_t capacity, uint32_t id) :
+                    _data(new char[roundUpToPowerOfTwo(capacity)]),
+                    _capacity(roundUpToPowerOfTwo(capacity)),
+                    _id(id) {}
+
+            bool push(const char *record, size_t size, bool block, const std::atomic<bool> &consumerRunning) {
+                if (size > _capacity) {
+                    return false;
+                }
+
+                uint64_t head = _head.load(std::memory_order_relaxed);
+                while (_capacity - (head - _cachedTail) < size) {
+                    _cachedTail = _tail.load(std::memory_order_acquire);
+                    if (_capacity - (head - _cachedTail) >= size) {
+                        break;
+                    }
+                    if (!block || !consumerRunning.load(std::memory_order_relaxed)) {
+                        return false;
+                    }
+                    std::this_thread::yield();
+                }
+
+                copyIn(head, record, size);
+                _head.store(head + size, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer side: moves the oldest record into `out`, false when empty
+            bool pop(std::string &out) {
+                uint64_t tail = _tail.load(std::memory_order_relaxed);
+                if (tail == _head.load(std::memory_order_acquire)) {
+                    return false;
+                }
+                uint32_t size;
+                copyOut(tail, reinterpret_cast<char *>(&size), sizeof(size));
+                out.resize(size);
+                copyOut(tail, out.data(), size);
+                _tail.store(tail + size, std::memory_order_release);
+                return true;
+            }
+
+            bool empty() const {
+                return _tail.load(std::memory_order_relaxed) == _head.load(std::memory_order_acquire);
+            }
+
+            uint32_t id() const { return _id; }
+
+            std::atomic<bool> retired{false};
+
+        private:
+            void copyIn(uint64_t position, const char *data, size_t size) {
+                size_t offset = position & (_capacity - 1);
+                size_t first = std::min(size, _capacity - offset);
+                std::memcpy(_data.get() + offset, data, first);
+                std::memcpy(_data.get(), data + first, size - first);
+            }
+
+            void copyOut(uint64_t position, char *data, size_t size) const {
+                size_t offset = position & (_capacity - 1);
+                size_t first = std::min(size, _capacity - offset);
+                std::memcpy(data, _data.get() + offset, first);
+                std::memcpy(data + first, _data.get(), size - first);
+            }
+
+            std::unique_ptr<char[]> _data;
+            const size_t _capacity;
+            const uint32_t _id;
+            alignas(64) std::atomic<uint64_t> _head{0};
+            uint64_t _cachedTail = 0;
+            alignas(64) std::atomic<uint64_t> _tail{0};
+        };
+
+        const char *levelName(Level level) {
+            switch (level) {
+                case Level::Debug:
+                    return "DEBUG";
+                case Level::Info:
+                    return "INFO ";
+                case Level::Warn:
+                    return "WARN ";
+                case Level::Error:
+                    return "ERROR";
+            }
+            return "?";
+        }
+
+        template<typename T>
+        T read(const char *&cursor) {
+            T value;
+            std::memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return value;
+        }
+
+        template<typename T>
+        void appendNumber(std::string &out, T value) {
+            char digits[32];
+            auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+            out.append(digits, end);
+        }
+
+        class Backend {
+        public:
+            static Backend &instance() {
+                static Backend backend;
+                return backend;
+            }
+
+            ~Backend() {
+                {
+                    std::scoped_lock lock(_mutex);
+                    _exit = true;
+                }
+                _wake.notify_all();
+                if (_writer.joinable()) {
+                    _writer.join();
+                }
+                _running.store(false);
+                if (_output != stdout) {
+                    std::fclose(_output);
+                }
+            }
+
+            void configure(const Config &config) {
+                level.store(config.level, std::memory_order_relaxed);
+                whenFull.store(config.whenFull, std::memory_order_relaxed);
+
+                FILE *output = stdout;
+                if (!config.path.empty()) {
+                    output = std::fopen(config.path.c_str(), "a");
+                    if (output == nullptr) {
+                        std::fprintf(stderr, "Cannot open log file %s, logging to stdout\n", config.path.c_str());
+                        output = stdout;
+                    }
+                }
+
+                std::scoped_lock lock(_outputMutex, _mutex);
+                if (_output != stdout) {
+                    std::fclose(_output);
+                }
+                _output = output;
+                _ringBytes = config.ringBytes;
+            }
+
+            Ring &ringForThread() {
+                // Marks the ring retired when the thread exits, the writer drops it once drained
+                struct Holder {
+                    std::shared_ptr<Ring> ring;
+
+                    ~Holder() {
+                        if (ring) {
+                            ring->retired.store(true, std::memory_order_release);
+                        }
+                    }
+                };
+                thread_local Holder holder;
+
+                if (!holder.ring) {
+                    std::scoped_lock lock(_mutex);
+                    holder.ring = std::make_shared<Ring>(_ringBytes, _nextRingId++);
+                    _rings.push_back(holder.ring);
+                    if (!_writer.joinable() && !_exit) {
+                        _running.store(true);
+                        _writer = std::thread(&Backend::run, this);
+                    }
+                }
+                return *holder.ring;
+            }
+
+            void submit(Level recordLevel, std::string &record) {
+                auto size = static_cast<uint32_t>(record.size());
+                int64_t wallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                std::memcpy(record.data(), &size, sizeof(size));
+                record[4] = static_cast<char>(recordLevel);
+                std::memcpy(record.data() + 8, &wallNs, sizeof(wallNs));
+
+                bool block = whenFull.load(std::memory_order_relaxed) == WhenFull::Block;
+                if (!ringForThread().push(record.data(), record.size(), block, _running)) {
+                    _dropped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            void flush() {
+                std::unique_lock lock(_mutex);
+                if (!_writer.joinable()) {
+                    return;
+                }
+                uint64_t ticket = ++_flushRequested;
+                _wake.notify_all();
+                _flushed.wait(lock, [this, ticket]() { return _flushCompleted >= ticket || _exit; });
+            }
+
+            uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+            std::atomic<Level> level{Level::Info};
+            std::atomic<WhenFull> whenFull{WhenFull::Drop};
+
+        private:
+            Backend() = default;
+
+            void run() {
+                while (true) {
+                    uint64_t flushTicket;
+                    std::vector<std::shared_ptr<Ring>> rings;
+                    {
+                        std::scoped_lock lock(_mutex);
+                        flushTicket = _flushRequested;
+                        rings = _rings;
+                    }
+
+                    bool wrote = drain(rings);
+
+                    std::unique_lock lock(_mutex);
+                    if (!wrote) {
+                        // Every ring was empty, all records older than the flush request are out
+                        if (_flushCompleted < flushTicket) {
+                            _flushCompleted = flushTicket;
+                            _flushed.notify_all();
+                        }
+                        std::erase_if(_rings, [](const auto &ring) {
+                            return ring->retired.load(std::memory_order_acquire) && ring->empty();
+                        });
+                        if (_exit) {
+                            _flushed.notify_all();
+                            return;
+                        }
+                        _wake.wait_for(lock, std::chrono::milliseconds(1), [this, flushTicket]() {
+                            return _exit || _flushRequested != flushTicket;
+                        });
+                    }
+                }
+            }
+
+            bool drain(const std::vector<std::shared_ptr<Ring>> &rings) {
+                std::scoped_lock lock(_outputMutex);
+                _text.clear();
+                bool any = false;
+                for (const auto &ring: rings) {
+                    while (ring->pop(_record)) {
+                        format(ring->id(), _record, _text);
+                        any = true;
+                    }
+                }
+
+                uint64_t dropped = _dropped.load(std::memory_order_relaxed);
+                if (dropped != _reportedDropped) {
+                    _text += "[log] ";
+                    appendNumber(_text, dropped - _reportedDropped);
+                    _text += " record(s) dropped, ring full\n";
+                    _reportedDropped = dropped;
+                }
+
+                if (!_text.empty()) {
+                    std::fwrite(_text.data(), 1, _text.size(), _output);
+                    std::fflush(_output);
+                }
+                return any;
+            }
+
+            void format(uint32_t thread, const std::string &record, std::string &out) {
+                auto recordLevel = static_cast<Level>(record[4]);
+                int64_t wallNs;
+                std::memcpy(&wallNs, record.data() + 8, sizeof(wallNs));
+
+                // 2026-10-17T09:30:00.123456Z
+                time_t seconds = wallNs / 1'000'000'000;
+                if (seconds != _stampSecond) {
+                    std::tm utc{};
+                    gmtime_r(&seconds, &utc);
+                    char stamp[32];
+                    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &utc);
+                    _stamp = stamp;
+                    _stampSecond = seconds;
+                }
+                out += _stamp;
+                char micros[16];
+                std::snprintf(micros, sizeof(micros), ".%06lldZ ", static_cast<long long>(wallNs % 1'000'000'000 / 1000));
+                out += micros;
+                out += levelName(recordLevel);
+                out += " [t";
+                appendNumber(out, thread);
+                out += "] ";
+
+                const char *cursor = record.data() + HEADER;
+                const char *end = record.data() + record.size();
+                while (cursor < end) {
+                    auto field = static_cast<detail::Field>(*cursor++);
+                    switch (field) {
+                        case detail::Field::Int:
+                            appendNumber(out, read<int64_t>(cursor));
+                            break;
+                        case detail::Field::UInt:
+                            appendNumber(out, read<uint64_t>(cursor));
+                            break;
+                        case detail::Field::Double:
+                            appendNumber(out, read<double>(cursor));
+                            break;
+                        case detail::Field::Bool:
+                            out += read<bool>(cursor) ? "true" : "false";
+                            break;
+                        case detail::Field::Char:
+                            out += read<char>(cursor);
+                            break;
+                        case detail::Field::String: {
+                            auto length = read<uint32_t>(cursor);
+                            out.append(cursor, length);
+                            cursor += length;
+                            break;
+                        }
+                        case detail::Field::Decimal: {
+                            char digits[Price::MAX_CHARS];
+                            out.append(digits, Price::fromUnits(read<int64_t>(cursor)).format(digits));
+                            break;
+                        }
+                    }
+                }
+                out += '\n';
+            }
+
+            std::mutex _mutex;
+            std::condition_variable _wake;
+            std::condition_variable _flushed;
+            std::vector<std::shared_ptr<Ring>> _rings;
+            uint32_t _nextRingId = 1;
+            size_t _ringBytes = Config{}.ringBytes;
+            uint64_t _flushRequested = 0;
+            uint64_t _flushCompleted = 0;
+            bool _exit = false;
+            std::atomic<bool> _running{false};
+            std::atomic<uint64_t> _dropped{0};
+            std::thread _writer;
+
+            // Writer only, the output is swapped under _outputMutex
+            std::mutex _outputMutex;
+            FILE *_output = stdout;
+            std::string _record;
+            std::string _text;
+            std::string _stamp;
+            time_t _stampSecond = -1;
+            uint64_t _reportedDropped = 0;
+        };
+    }
+
+    void configure(const Config &config) {
+        Backend::instance().configure(config);
+    }
+
+    Level parseLevel(std::string_view name, Level fallback) {
+        if (name == "debug" || name == "DEBUG") {
+            return Level::Debug;
+        }
+        if (name == "info" || name == "INFO") {
+            return Level::Info;
+        }
+        if (name == "warn" || name == "WARN") {
+            return Level::Warn;
+        }
+        if (name == "error" || name == "ERROR") {
+            return Level::Error;
+        }
+        return fallback;
+    }
+
+    bool enabled(Level level) {
+        return level >= Backend::instance().level.load(std::memory_order_relaxed);
+    }
+
+    void flush() {
+        Backend::instance().flush();
+    }
+
+    uint64_t dropped() {
+        return Backend::instance().dropped();
+    }
+
+    namespace detail {
+        std::string &begin() {
+            thread_local std::string record;
+            record.assign(HEADER, '\0');
+            return record;
+        }
+
+        void submit(Level level, std::string &record) {
+            Backend::instance().submit(level, record);
+        }
+    }
+}
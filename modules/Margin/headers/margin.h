@@ -1,36 +1,77 @@
 #ifndef MARGIN_H
 #define MARGIN_H
 
+#include <future>
+#include <optional>
 #include <string>
+#include <vector>
 #include <nlohmann/json.hpp>
 #include "../../Order/models/APIParams/APIParams.h"
+#include "../../Decode/headers/decode.h"
+#include "../../Http/headers/http.h"
 
 namespace Margin {
-    double getPrice(
+    // Empty when the price is unavailable (error logged)
+    std::optional<double> getPrice(
             const APIParams &apiParams,
             const std::string &symbol
     );
 
-    nlohmann::json getPositions(
+    // Empty when the request failed. Concurrent polls of the same account and symbol
+    // share one request (same for getOpenOrders).
+    std::vector<Decode::PositionRisk> getPositions(
             const APIParams &apiParams,
-            const std::string &symbol
+            const std::string &symbol,
+            Http::Priority priority = Http::Priority::Query
     );
 
     nlohmann::json getOpenOrders(
             const APIParams &apiParams,
-            const std::string &symbol
+            const std::string &symbol,
+            Http::Priority priority = Http::Priority::Query
     );
 
-    double getBalance(
+    // Available balance, empty when the request failed (error logged)
+    std::optional<double> getBalance(
             const APIParams &apiParams,
             const std::string &asset
     );
 
+    // Notional tiers per symbol, all symbols when `symbol` is empty. Empty on failure.
+    std::vector<Decode::SymbolBrackets> getLeverageBrackets(
+            const APIParams &apiParams,
+            const std::string &symbol
+    );
+
     nlohmann::json setLeverage(
             const APIParams &apiParams,
             const std::string &symbol,
             int leverage
     );
+
+    // Non-blocking variants, each call is put on the wire right away on its own pooled
+    // connection so independent queries can overlap. apiParams is copied into the task.
+    std::future<std::optional<double>> getPriceAsync(
+            const APIParams &apiParams,
+            const std::string &symbol
+    );
+
+    std::future<std::vector<Decode::PositionRisk>> getPositionsAsync(
+            const APIParams &apiParams,
+            const std::string &symbol,
+            Http::Priority priority = Http::Priority::Query
+    );
+
+    std::future<nlohmann::json> getOpenOrdersAsync(
+            const APIParams &apiParams,
+            const std::string &symbol,
+            Http::Priority priority = Http::Priority::Query
+    );
+
+    std::future<std::optional<double>> getBalanceAsync(
+            const APIParams &apiParams,
+            const std::string &asset
+    );
 }
 
 #endif // MARGIN_H
@@ -1,101 +1,149 @@
 #include "../headers/margin.h"
-#include "../../Utils/headers/utils.h"
+#include "../../Http/headers/http.h"
+#include "../../Http/headers/signedrequest.h"
+#include "../../Http/headers/scheduler.h"
+#include "../../MarketData/headers/marketdata.h"
+#include "../../Log/headers/log.h"
 #include "cpr/cpr.h"
-#include <iostream>
-#include <ctime>
 #include "nlohmann/json.hpp"
 
 namespace Margin {
-    double getPrice(
-            const APIParams &apiParams,
-            const std::string &symbol
-    ) {
-        std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-        std::string apiCall = "fapi/v1/ticker/price";
-        std::string url = baseUrl + "/" + apiCall + "?symbol=" + symbol;
+    namespace {
+        Http::Coalescer<std::vector<Decode::PositionRisk>> positionPolls;
+        Http::Coalescer<nlohmann::json> openOrderPolls;
+
+        std::vector<Decode::PositionRisk> fetchPositions(const APIParams &apiParams, const std::string &symbol, Http::Priority priority) {
+            std::string baseUrl = apiParams.baseUrl();
+            auto &request = Http::SignedRequestBuilder::forThread("fapi/v2/positionRisk");
+            request.timestamp();
+            if (!symbol.empty()) {
+                request.param("symbol", symbol);
+            }
+
+            cpr::Response r = Http::get(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool(), priority);
 
-        cpr::Response r = cpr::Get(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
-        // FIXME: use logs instead!
-        // std::cout << "Response Code: " << r.status_code << std::endl;
-        // std::cout << "Response Text: " << r.text << std::endl;
+            Decode::ApiError error;
+            auto positions = Decode::positionRisk(r.text, &error);
+            if (!positions) {
+                Log::error("positionRisk failed (", error.code, "): ", r.error ? r.error.message : error.msg);
+                return {};
+            }
+            return std::move(*positions);
+        }
 
-        return std::stod(nlohmann::json::parse(r.text)["price"].get<std::string>());
+        nlohmann::json fetchOpenOrders(const APIParams &apiParams, const std::string &symbol, Http::Priority priority) {
+            std::string baseUrl = apiParams.baseUrl();
+            auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/openOrders");
+            request.timestamp();
+            if (!symbol.empty()) {
+                request.param("symbol", symbol);
+            }
+            request.param("recvWindow", apiParams.recvWindow);
+
+            cpr::Response r = Http::get(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool(), priority);
+            Log::debug("GET fapi/v1/openOrders ", r.status_code, " ", r.text);
+
+            auto body = nlohmann::json::parse(r.text, nullptr, false);
+            if (body.is_discarded()) {
+                Log::error("openOrders failed (HTTP ", r.status_code, "): ", r.error ? r.error.message : r.text);
+                return {};
+            }
+            return body;
+        }
     }
 
-    nlohmann::json getPositions(
+    std::optional<double> getPrice(
             const APIParams &apiParams,
             const std::string &symbol
     ) {
-        std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-        std::string apiCall = "fapi/v2/positionRisk";
-
-        long timestamp = static_cast<long>(std::time(nullptr) * 1000);
-        std::string params = "timestamp=" + std::to_string(timestamp);
-        if (!symbol.empty()) {
-            params += "&symbol=" + symbol;
+        // Streamed quotes are fresher than anything a REST round trip can return
+        if (auto cached = MarketData::latestPrice(symbol, std::chrono::seconds(2))) {
+            return *cached;
         }
 
-        std::string signature = Utils::HMAC_SHA256(apiParams.apiSecret, params);
-        std::string url = baseUrl + "/" + apiCall + "?" + params + "&signature=" + Utils::urlEncode(signature);
+        std::string baseUrl = apiParams.baseUrl();
+        std::string apiCall = "fapi/v1/ticker/price";
+        std::string url = apiCall + "?symbol=" + symbol;
 
-        cpr::Response r = cpr::Get(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
+        cpr::Response r = Http::get(baseUrl, url, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool());
+        Log::debug("GET fapi/v1/ticker/price ", r.status_code, " ", r.text);
 
-        return nlohmann::json::parse(r.text);
+        Decode::ApiError error;
+        auto ticker = Decode::tickerPrice(r.text, &error);
+        if (!ticker) {
+            Log::error(apiParams.name, "/", symbol, ": ticker/price failed (", error.code, "): ", error.msg);
+            return std::nullopt;
+        }
+        return ticker->price;
     }
 
-    nlohmann::json getOpenOrders(
+    std::vector<Decode::PositionRisk> getPositions(
             const APIParams &apiParams,
-            const std::string &symbol
+            const std::string &symbol,
+            Http::Priority priority
     ) {
-        std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-        std::string apiCall = "fapi/v1/openOrders";
-
-        long timestamp = static_cast<long>(std::time(nullptr) * 1000);
-        std::string params = "timestamp=" + std::to_string(timestamp);
-        if (!symbol.empty()) {
-            params += "&symbol=" + symbol;
+        if (priority != Http::Priority::Poll) {
+            return fetchPositions(apiParams, symbol, priority);
         }
-        params += "&recvWindow=" + std::to_string(apiParams.recvWindow);
-
-        std::string signature = Utils::HMAC_SHA256(apiParams.apiSecret, params);
-        std::string url = baseUrl + "/" + apiCall + "?" + params + "&signature=" + Utils::urlEncode(signature);
-
-        cpr::Response r = cpr::Get(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
-        // FIXME: use logs instead!
-        // std::cout << "Response Code: " << r.status_code << std::endl;
-        // std::cout << "Response Text: " << r.text << std::endl;
+        return positionPolls.run(apiParams.apiKey + "/" + symbol, [&]() {
+            return fetchPositions(apiParams, symbol, priority);
+        });
+    }
 
-        return nlohmann::json::parse(r.text);
+    nlohmann::json getOpenOrders(
+            const APIParams &apiParams,
+            const std::string &symbol,
+            Http::Priority priority
+    ) {
+        if (priority != Http::Priority::Poll) {
+            return fetchOpenOrders(apiParams, symbol, priority);
+        }
+        return openOrderPolls.run(apiParams.apiKey + "/" + symbol, [&]() {
+            return fetchOpenOrders(apiParams, symbol, priority);
+        });
     }
 
-    double getBalance(
+    std::optional<double> getBalance(
             const APIParams &apiParams,
             const std::string &asset
     ) {
-        std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-        std::string apiCall = "fapi/v2/account";
-
-        long timestamp = static_cast<long>(std::time(nullptr) * 1000);
-        std::string params = "timestamp=" + std::to_string(timestamp);
-
-        std::string signature = Utils::HMAC_SHA256(apiParams.apiSecret, params);
-        std::string url = baseUrl + "/" + apiCall + "?" + params + "&signature=" + Utils::urlEncode(signature);
+        std::string baseUrl = apiParams.baseUrl();
+        auto &request = Http::SignedRequestBuilder::forThread("fapi/v2/account");
+        request.timestamp();
+
+        cpr::Response r = Http::get(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool());
+        Log::debug("GET fapi/v2/account ", r.status_code, " ", r.text);
+
+        // Only the requested asset is read out of the (large) account payload
+        Decode::ApiError error;
+        auto balance = Decode::accountAsset(r.text, asset, &error);
+        if (!balance) {
+            Log::error(apiParams.name, ": no ", asset, " balance (", error.code, "): ", error.msg);
+            return std::nullopt;
+        }
+        return balance->availableBalance;
+    }
 
-        cpr::Response r = cpr::Get(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
-        // FIXME: use logs instead!
-        // std::cout << "Response Code: " << r.status_code << std::endl;
-        // std::cout << "Response Text: " << r.text << std::endl;
+    std::vector<Decode::SymbolBrackets> getLeverageBrackets(
+            const APIParams &apiParams,
+            const std::string &symbol
+    ) {
+        std::string baseUrl = apiParams.baseUrl();
+        auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/leverageBracket");
+        if (!symbol.empty()) {
+            request.param("symbol", symbol);
+        }
+        request.timestamp();
 
-        nlohmann::json jsonResponse = nlohmann::json::parse(r.text);
+        cpr::Response r = Http::get(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool());
 
-        // Filter the response to get the balance of the specified asset
-        for (const auto &balance: jsonResponse["assets"]) {
-            if (balance["asset"] == asset) {
-                return std::stod(balance["availableBalance"].get<std::string>());
-            }
+        Decode::ApiError error;
+        auto brackets = Decode::leverageBrackets(r.text, &error);
+        if (!brackets) {
+            Log::error("leverageBracket failed (", error.code, "): ", error.msg);
+            return {};
         }
-
-        return 0;
+        return std::move(*brackets);
     }
 
     nlohmann::json setLeverage(
@@ -103,17 +151,55 @@ namespace Margin {
             const std::string &symbol,
             int leverage
     ) {
-        std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-        std::string apiCall = "fapi/v1/leverage";
+        std::string baseUrl = apiParams.baseUrl();
+        auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/leverage");
+        request.param("symbol", symbol).param("leverage", leverage).timestamp();
+
+        cpr::Response r = Http::post(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool());
+
+        auto body = nlohmann::json::parse(r.text, nullptr, false);
+        if (body.is_discarded()) {
+            Log::error("leverage failed (HTTP ", r.status_code, "): ", r.error ? r.error.message : r.text);
+            return {};
+        }
+        return body;
+    }
 
-        long timestamp = static_cast<long>(std::time(nullptr) * 1000);
-        std::string params = "symbol=" + symbol + "&leverage=" + std::to_string(leverage) + "&timestamp=" + std::to_string(timestamp);
+    std::future<std::optional<double>> getPriceAsync(
+            const APIParams &apiParams,
+            const std::string &symbol
+    ) {
+        return std::async(std::launch::async, [apiParams, symbol]() {
+            return getPrice(apiParams, symbol);
+        });
+    }
 
-        std::string signature = Utils::HMAC_SHA256(apiParams.apiSecret, params);
-        std::string url = baseUrl + "/" + apiCall + "?" + params + "&signature=" + Utils::urlEncode(signature);
+    std::future<std::vector<Decode::PositionRisk>> getPositionsAsync(
+            const APIParams &apiParams,
+            const std::string &symbol,
+            Http::Priority priority
+    ) {
+        return std::async(std::launch::async, [apiParams, symbol, priority]() {
+            return getPositions(apiParams, symbol, priority);
+        });
+    }
 
-        cpr::Response r = cpr::Post(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
+    std::future<nlohmann::json> getOpenOrdersAsync(
+            const APIParams &apiParams,
+            const std::string &symbol,
+            Http::Priority priority
+    ) {
+        return std::async(std::launch::async, [apiParams, symbol, priority]() {
+            return getOpenOrders(apiParams, symbol, priority);
+        });
+    }
 
-        return nlohmann::json::parse(r.text);
+    std::future<std::optional<double>> getBalanceAsync(
+            const APIParams &apiParams,
+            const std::string &asset
+    ) {
+        return std::async(std::launch::async, [apiParams, asset]() {
+            return getBalance(apiParams, asset);
+        });
     }
 }
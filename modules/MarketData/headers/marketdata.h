@@ -0,0 +1,107 @@
+#ifndef MARKET_DATA_H
+#define MARKET_DATA_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace MarketData {
+    struct Quote {
+        double bidPrice = 0;
+        double bidQty = 0;
+        double askPrice = 0;
+        double askQty = 0;
+        double markPrice = 0;
+        // steady_clock nanoseconds of the last book/mark update, 0 when never received
+        int64_t bookReceivedNs = 0;
+        int64_t markReceivedNs = 0;
+    };
+
+    // Latest quote per symbol, written by the stream thread and read by any thread.
+    // Every slot is a seqlock: readers never block the writer and retry when they
+    // raced with an update. The symbol set is fixed at construction so lookups do
+    // not need a lock either.
+    class QuoteCache {
+    public:
+        static constexpr size_t MAX_SYMBOLS = 64;
+
+        explicit QuoteCache(const std::vector<std::string> &symbols);
+
+        int slotOf(std::string_view symbol) const;
+
+        void updateBook(int slot, double bidPrice, double bidQty, double askPrice, double askQty);
+
+        void updateMark(int slot, double markPrice);
+
+        bool read(std::string_view symbol, Quote &quote) const;
+
+        const std::vector<std::string> &symbols() const { return _symbols; }
+
+    private:
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> sequence{0};
+            std::atomic<double> bidPrice{0};
+            std::atomic<double> bidQty{0};
+            std::atomic<double> askPrice{0};
+            std::atomic<double> askQty{0};
+            std::atomic<double> markPrice{0};
+            std::atomic<int64_t> bookReceivedNs{0};
+            std::atomic<int64_t> markReceivedNs{0};
+        };
+
+        std::vector<std::string> _symbols;
+        std::array<Slot, MAX_SYMBOLS> _slots;
+    };
+
+    // Keeps a combined bookTicker + markPrice stream open and feeds the cache.
+    // Reconnects with backoff and also when the stream goes silent.
+    class MarketDataStream {
+    public:
+        MarketDataStream(std::string streamBaseUrl, QuoteCache &cache,
+                         std::chrono::milliseconds staleAfter = std::chrono::seconds(10));
+
+        ~MarketDataStream();
+
+        MarketDataStream(const MarketDataStream &) = delete;
+
+        MarketDataStream &operator=(const MarketDataStream &) = delete;
+
+        void start();
+
+        void stop();
+
+        uint64_t reconnects() const { return _reconnects.load(std::memory_order_relaxed); }
+
+    private:
+        std::string _url;
+        QuoteCache &_cache;
+        std::chrono::milliseconds _staleAfter;
+        std::atomic<bool> _exit = false;
+        std::atomic<uint64_t> _reconnects = 0;
+        std::thread _thread;
+
+        void run();
+
+        void handleMessage(const std::string &message);
+    };
+
+    std::string defaultStreamUrl(bool useTestnet);
+
+    // Process wide cache used by Margin::getPrice. Without start() every lookup misses
+    // and callers fall back to REST.
+    void start(const std::vector<std::string> &symbols, const std::string &streamBaseUrl);
+
+    void stop();
+
+    // Mid price when the book is fresher than maxAge, otherwise the mark price when that
+    // is fresh, otherwise nothing.
+    std::optional<double> latestPrice(const std::string &symbol, std::chrono::milliseconds maxAge);
+}
+
+#endif // MARKET_DATA_H
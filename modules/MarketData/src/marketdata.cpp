@@ -0,0 +1,218 @@
+#include "../headers/marketdata.h"
+#include "../../WebSocket/headers/websocket.h"
+#include "../../Log/headers/log.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include "nlohmann/json.hpp"
+
+namespace MarketData {
+    namespace {
+        int64_t steadyNowNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        std::string lowercase(std::string value) {
+            std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+            return value;
+        }
+
+        double toDouble(const nlohmann::json &value) {
+            return value.is_string() ? std::stod(value.get<std::string>()) : value.get<double>();
+        }
+    }
+
+    QuoteCache::QuoteCache(const std::vector<std::string> &symbols) : _symbols(symbols) {
+        if (_symbols.size() > MAX_SYMBOLS) {
+            throw std::invalid_argument("Too many market data symbols");
+        }
+    }
+
+    int QuoteCache::slotOf(std::string_view symbol) const {
+        for (size_t i = 0; i < _symbols.size(); ++i) {
+            if (_symbols[i] == symbol) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void QuoteCache::updateBook(int slot, double bidPrice, double bidQty, double askPrice, double askQty) {
+        Slot &s = _slots[slot];
+        uint64_t sequence = s.sequence.load(std::memory_order_relaxed);
+        s.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.bidPrice.store(bidPrice, std::memory_order_relaxed);
+        s.bidQty.store(bidQty, std::memory_order_relaxed);
+        s.askPrice.store(askPrice, std::memory_order_relaxed);
+        s.askQty.store(askQty, std::memory_order_relaxed);
+        s.bookReceivedNs.store(steadyNowNs(), std::memory_order_relaxed);
+        s.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    void QuoteCache::updateMark(int slot, double markPrice) {
+        Slot &s = _slots[slot];
+        uint64_t sequence = s.sequence.load(std::memory_order_relaxed);
+        s.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.markPrice.store(markPrice, std::memory_order_relaxed);
+        s.markReceivedNs.store(steadyNowNs(), std::memory_order_relaxed);
+        s.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    bool QuoteCache::read(std::string_view symbol, Quote &quote) const {
+        int slot = slotOf(symbol);
+        if (slot < 0) {
+            return false;
+        }
+
+        const Slot &s = _slots[slot];
+        while (true) {
+            uint64_t before = s.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue;
+            }
+            quote.bidPrice = s.bidPrice.load(std::memory_order_relaxed);
+            quote.bidQty = s.bidQty.load(std::memory_order_relaxed);
+            quote.askPrice = s.askPrice.load(std::memory_order_relaxed);
+            quote.askQty = s.askQty.load(std::memory_order_relaxed);
+            quote.markPrice = s.markPrice.load(std::memory_order_relaxed);
+            quote.bookReceivedNs = s.bookReceivedNs.load(std::memory_order_relaxed);
+            quote.markReceivedNs = s.markReceivedNs.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.sequence.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+    }
+
+    MarketDataStream::MarketDataStream(std::string streamBaseUrl, QuoteCache &cache, std::chrono::milliseconds staleAfter) :
+            _cache(cache),
+            _staleAfter(staleAfter) {
+        std::string streams;
+        for (const auto &symbol: cache.symbols()) {
+            std::string name = lowercase(symbol);
+            streams += (streams.empty() ? "" : "/") + name + "@bookTicker/" + name + "@markPrice@1s";
+        }
+        _url = streamBaseUrl + "/stream?streams=" + streams;
+    }
+
+    MarketDataStream::~MarketDataStream() {
+        stop();
+    }
+
+    void MarketDataStream::start() {
+        if (!_thread.joinable()) {
+            _exit.store(false);
+            _thread = std::thread(&MarketDataStream::run, this);
+        }
+    }
+
+    void MarketDataStream::stop() {
+        if (_thread.joinable()) {
+            _exit.store(true);
+            _thread.join();
+        }
+    }
+
+    void MarketDataStream::run() {
+        WebSocketClient client;
+        std::string message;
+        auto backoff = std::chrono::milliseconds(250);
+
+        while (!_exit.load()) {
+            try {
+                client.connect(_url);
+                backoff = std::chrono::milliseconds(250);
+
+                auto lastMessage = std::chrono::steady_clock::now();
+                while (!_exit.load()) {
+                    // Short receive timeout so stop() is honoured quickly.
+                    if (client.receive(message, std::chrono::milliseconds(500))) {
+                        lastMessage = std::chrono::steady_clock::now();
+                        handleMessage(message);
+                    } else if (std::chrono::steady_clock::now() - lastMessage > _staleAfter) {
+                        throw std::runtime_error("Market data stream went stale");
+                    }
+                }
+            } catch (const std::exception &e) {
+                Log::error("Market data stream error: ", e.what());
+            }
+
+            client.close();
+            if (_exit.load()) {
+                break;
+            }
+
+            _reconnects.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min(backoff * 2, std::chrono::milliseconds(10000));
+        }
+    }
+
+    void MarketDataStream::handleMessage(const std::string &message) {
+        auto json = nlohmann::json::parse(message, nullptr, false);
+        if (json.is_discarded()) {
+            return;
+        }
+
+        const auto &data = json.contains("data") ? json["data"] : json;
+        if (!data.contains("s") || !data["s"].is_string()) {
+            return;
+        }
+        int slot = _cache.slotOf(data["s"].get<std::string>());
+        if (slot < 0) {
+            return;
+        }
+
+        // data is const, operator[] on a missing key would be undefined behaviour
+        if (data.contains("b") && data.contains("B") && data.contains("a") && data.contains("A")) {
+            _cache.updateBook(slot, toDouble(data["b"]), toDouble(data["B"]), toDouble(data["a"]), toDouble(data["A"]));
+        } else if (data.contains("p")) {
+            _cache.updateMark(slot, toDouble(data["p"]));
+        }
+    }
+
+    namespace {
+        std::unique_ptr<QuoteCache> sharedCache;
+        std::unique_ptr<MarketDataStream> sharedStream;
+        std::atomic<QuoteCache *> activeCache = nullptr;
+    }
+
+    std::string defaultStreamUrl(bool useTestnet) {
+        return useTestnet ? "wss://stream.binancefuture.com" : "wss://fstream.binance.com";
+    }
+
+    void start(const std::vector<std::string> &symbols, const std::string &streamBaseUrl) {
+        stop();
+        sharedCache = std::make_unique<QuoteCache>(symbols);
+        sharedStream = std::make_unique<MarketDataStream>(streamBaseUrl, *sharedCache);
+        sharedStream->start();
+        activeCache.store(sharedCache.get(), std::memory_order_release);
+    }
+
+    void stop() {
+        activeCache.store(nullptr, std::memory_order_release);
+        sharedStream.reset();
+        sharedCache.reset();
+    }
+
+    std::optional<double> latestPrice(const std::string &symbol, std::chrono::milliseconds maxAge) {
+        QuoteCache *cache = activeCache.load(std::memory_order_acquire);
+        Quote quote;
+        if (cache == nullptr || !cache->read(symbol, quote)) {
+            return std::nullopt;
+        }
+
+        int64_t oldest = steadyNowNs() - std::chrono::duration_cast<std::chrono::nanoseconds>(maxAge).count();
+        if (quote.bookReceivedNs != 0 && quote.bookReceivedNs >= oldest && quote.bidPrice > 0 && quote.askPrice > 0) {
+            return (quote.bidPrice + quote.askPrice) / 2;
+        }
+        if (quote.markReceivedNs != 0 && quote.markReceivedNs >= oldest && quote.markPrice > 0) {
+            return quote.markPrice;
+        }
+        return std::nullopt;
+    }
+}
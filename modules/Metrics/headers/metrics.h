@@ -0,0 +1,76 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Latency histograms for the request path, exported in the Prometheus text format.
+//
+//     Metrics::histogram("executioner_http_request_seconds", "endpoint=\"fapi/v1/order\"").record(elapsed);
+//
+// Recording and lookups never take a lock: buckets are atomic counters and histograms live
+// in a fixed open-addressing table that only grows. Values are kept in microseconds and
+// exported in seconds.
+namespace Metrics {
+    // HDR-style log-linear buckets: exact below 16us, then 16 buckets per power of two, so
+    // any value is off by at most 1/16 (~6%) of itself.
+    class Histogram {
+    public:
+        static constexpr int SUB_BUCKET_BITS = 4;
+        static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+        // Up to 2^40us (~12 days), larger values land in the last bucket
+        static constexpr int MAX_SHIFT = 40 - SUB_BUCKET_BITS;
+        static constexpr size_t BUCKETS = SUB_BUCKETS + (MAX_SHIFT + 1) * SUB_BUCKETS;
+
+        struct Snapshot {
+            uint64_t count = 0;
+            uint64_t sumUs = 0;
+            uint64_t maxUs = 0;
+            std::vector<uint64_t> counts;
+
+            // Highest value of the bucket holding the q-th value, capped at the maximum
+            uint64_t quantileUs(double q) const;
+        };
+
+        void record(uint64_t us);
+
+        void record(std::chrono::nanoseconds duration);
+
+        Snapshot snapshot() const;
+
+        static size_t bucketOf(uint64_t us);
+
+        static uint64_t highestOf(size_t bucket);
+
+    private:
+        std::array<std::atomic<uint64_t>, BUCKETS> _counts{};
+        std::atomic<uint64_t> _sumUs{0};
+        std::atomic<uint64_t> _maxUs{0};
+    };
+
+    // Histogram for name + labels (`key="value",...`), created on first use. Keep the
+    // returned reference when the labels are fixed.
+    Histogram &histogram(std::string_view name, std::string_view labels = "");
+
+    // Every histogram as Prometheus summaries (quantiles, _sum, _count) plus a _max gauge
+    std::string prometheusText();
+
+    struct ExporterConfig {
+        // Rewritten every interval, nothing is written when empty
+        std::string path;
+        std::chrono::seconds interval{15};
+        // Serves GET /metrics on 127.0.0.1, off when 0
+        uint16_t port = 0;
+    };
+
+    void startExporter(const ExporterConfig &config);
+
+    void stopExporter();
+}
+
+#endif // METRICS_H
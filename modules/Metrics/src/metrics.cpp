@@ -0,0 +1,314 @@
+#include "../headers/metrics.h"
+#include "../../Log/headers/log.h"
+
+#include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Metrics {
+    namespace {
+        struct Entry {
+            std::string name;
+            std::string labels;
+            Histogram histogram;
+        };
+
+        constexpr size_t TABLE_SIZE = 1024;
+        std::array<std::atomic<Entry *>, TABLE_SIZE> table{};
+
+        // Used when the table is full, recorded but never exported
+        Histogram overflow;
+
+        uint64_t hashOf(std::string_view name, std::string_view labels) {
+            uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char c: name) {
+                hash = (hash ^ c) * 1099511628211ULL;
+            }
+            hash = (hash ^ '{') * 1099511628211ULL;
+            for (unsigned char c: labels) {
+                hash = (hash ^ c) * 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        void appendSeconds(std::string &out, uint64_t us) {
+            char digits[32];
+            int length = std::snprintf(digits, sizeof(digits), "%.6f", static_cast<double>(us) / 1e6);
+            out.append(digits, length);
+        }
+
+        void appendSeries(std::string &out, const std::string &name, std::string_view suffix,
+                          const std::string &labels, std::string_view extra) {
+            out += name;
+            out += suffix;
+            if (!labels.empty() || !extra.empty()) {
+                out += '{';
+                out += labels;
+                if (!labels.empty() && !extra.empty()) {
+                    out += ',';
+                }
+                out += extra;
+                out += '}';
+            }
+            out += ' ';
+        }
+
+        std::thread fileWriter;
+        std::thread httpServer;
+        std::mutex exporterMutex;
+        std::condition_variable exporterCv;
+        std::atomic<bool> exporterExit{false};
+
+        bool writeFile(const std::string &path) {
+            std::string text = prometheusText();
+            std::string temporary = path + ".tmp";
+            FILE *file = std::fopen(temporary.c_str(), "w");
+            if (file == nullptr) {
+                return false;
+            }
+            bool written = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+            written = std::fclose(file) == 0 && written;
+            return written && std::rename(temporary.c_str(), path.c_str()) == 0;
+        }
+
+        void sendAll(int fd, std::string_view data) {
+            while (!data.empty()) {
+                ssize_t sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+                if (sent <= 0) {
+                    return;
+                }
+                data.remove_prefix(static_cast<size_t>(sent));
+            }
+        }
+
+        // One request per connection, enough for a scraper on the same host
+        void serve(int listener) {
+            while (!exporterExit.load()) {
+                pollfd ready{listener, POLLIN, 0};
+                if (poll(&ready, 1, 250) <= 0) {
+                    continue;
+                }
+                int client = accept(listener, nullptr, nullptr);
+                if (client < 0) {
+                    continue;
+                }
+
+                timeval timeout{1, 0};
+                setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                char request[1024];
+                ssize_t received = recv(client, request, sizeof(request), 0);
+                std::string_view line(request, received > 0 ? static_cast<size_t>(received) : 0);
+
+                std::string response;
+                if (line.starts_with("GET /metrics ") || line.starts_with("GET /metrics?")) {
+                    std::string body = prometheusText();
+                    response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " +
+                               std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+                } else {
+                    response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                }
+                sendAll(client, response);
+                close(client);
+            }
+            close(listener);
+        }
+
+        int listenLocal(uint16_t port) {
+            int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (listener < 0) {
+                return -1;
+            }
+            int reuse = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 8) != 0) {
+                close(listener);
+                return -1;
+            }
+            return listener;
+        }
+    }
+
+    size_t Histogram::bucketOf(uint64_t us) {
+        if (us < SUB_BUCKETS) {
+            return us;
+        }
+        int shift = std::bit_width(us) - SUB_BUCKET_BITS - 1;
+        if (shift > MAX_SHIFT) {
+            return BUCKETS - 1;
+        }
+        return SUB_BUCKETS + shift * SUB_BUCKETS + ((us >> shift) - SUB_BUCKETS);
+    }
+
+    uint64_t Histogram::highestOf(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        uint64_t shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+        uint64_t top = SUB_BUCKETS + (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+        return ((top + 1) << shift) - 1;
+    }
+
+    void Histogram::record(uint64_t us) {
+        _counts[bucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+        _sumUs.fetch_add(us, std::memory_order_relaxed);
+        uint64_t max = _maxUs.load(std::memory_order_relaxed);
+        while (us > max && !_maxUs.compare_exchange_weak(max, us, std::memory_order_relaxed)) {}
+    }
+
+    void Histogram::record(std::chrono::nanoseconds duration) {
+        record(static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0) / 1000));
+    }
+
+    Histogram::Snapshot Histogram::snapshot() const {
+        Snapshot snapshot;
+        snapshot.counts.resize(BUCKETS);
+        // The count is taken from the buckets so quantiles stay consistent with them
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            snapshot.counts[i] = _counts[i].load(std::memory_order_relaxed);
+            snapshot.count += snapshot.counts[i];
+        }
+        snapshot.sumUs = _sumUs.load(std::memory_order_relaxed);
+        snapshot.maxUs = _maxUs.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    uint64_t Histogram::Snapshot::quantileUs(double q) const {
+        if (count == 0) {
+            return 0;
+        }
+        auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(count) + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(highestOf(i), maxUs);
+            }
+        }
+        return maxUs;
+    }
+
+    Histogram &histogram(std::string_view name, std::string_view labels) {
+        uint64_t hash = hashOf(name, labels);
+        Entry *created = nullptr;
+        for (size_t probe = 0; probe < TABLE_SIZE; ++probe) {
+            std::atomic<Entry *> &slot = table[(hash + probe) % TABLE_SIZE];
+            Entry *entry = slot.load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                if (created == nullptr) {
+                    created = new Entry{std::string(name), std::string(labels), {}};
+                }
+                if (slot.compare_exchange_strong(entry, created, std::memory_order_acq_rel)) {
+                    return created->histogram;
+                }
+                // Lost the race, `entry` is now whoever won the slot
+            }
+            if (entry->name == name && entry->labels == labels) {
+                delete created;
+                return entry->histogram;
+            }
+        }
+        delete created;
+        return overflow;
+    }
+
+    std::string prometheusText() {
+        std::vector<const Entry *> entries;
+        for (const auto &slot: table) {
+            if (const Entry *entry = slot.load(std::memory_order_acquire)) {
+                entries.push_back(entry);
+            }
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry *a, const Entry *b) {
+            return std::tie(a->name, a->labels) < std::tie(b->name, b->labels);
+        });
+
+        static constexpr std::pair<double, std::string_view> QUANTILES[] = {
+                {0.5, "quantile=\"0.5\""},
+                {0.9, "quantile=\"0.9\""},
+                {0.99, "quantile=\"0.99\""},
+                {0.999, "quantile=\"0.999\""}
+        };
+
+        std::string out;
+        const std::string *currentName = nullptr;
+        for (const Entry *entry: entries) {
+            if (currentName == nullptr || *currentName != entry->name) {
+                out += "# TYPE " + entry->name + " summary\n";
+                currentName = &entry->name;
+            }
+            Histogram::Snapshot snapshot = entry->histogram.snapshot();
+            for (const auto &[q, label]: QUANTILES) {
+                appendSeries(out, entry->name, "", entry->labels, label);
+                appendSeconds(out, snapshot.quantileUs(q));
+                out += '\n';
+            }
+            appendSeries(out, entry->name, "_sum", entry->labels, "");
+            appendSeconds(out, snapshot.sumUs);
+            out += '\n';
+            appendSeries(out, entry->name, "_count", entry->labels, "");
+            out += std::to_string(snapshot.count);
+            out += '\n';
+            appendSeries(out, entry->name, "_max", entry->labels, "");
+            appendSeconds(out, snapshot.maxUs);
+            out += '\n';
+        }
+        return out;
+    }
+
+    void startExporter(const ExporterConfig &config) {
+        stopExporter();
+        exporterExit.store(false);
+
+        if (!config.path.empty()) {
+            fileWriter = std::thread([config]() {
+                while (true) {
+                    if (!writeFile(config.path)) {
+                        Log::error("Could not write metrics to ", config.path);
+                    }
+                    std::unique_lock lock(exporterMutex);
+                    if (exporterCv.wait_for(lock, config.interval, []() { return exporterExit.load(); })) {
+                        writeFile(config.path);
+                        return;
+                    }
+                }
+            });
+        }
+
+        if (config.port != 0) {
+            int listener = listenLocal(config.port);
+            if (listener < 0) {
+                Log::error("Could not listen on 127.0.0.1:", config.port, " for /metrics");
+            } else {
+                httpServer = std::thread(serve, listener);
+            }
+        }
+    }
+
+    void stopExporter() {
+        {
+            std::scoped_lock lock(exporterMutex);
+            exporterExit.store(true);
+        }
+        exporterCv.notify_all();
+        if (fileWriter.joinable()) {
+            fileWriter.join();
+        }
+        if (httpServer.joinable()) {
+            httpServer.join();
+        }
+    }
+}
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <chrono>
 #include <iomanip>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 
@@ -19,19 +20,10 @@ bool isToday(const std::string& dateTime);
 // Parse a datetime string into a chrono time_point
 std::chrono::system_clock::time_point parseDateTime(const std::string& dateTime);
 
-// Create a range from a sorted list of dates
-std::pair<std::chrono::system_clock::time_point, std::chrono::system_clock::time_point> createRange(
-    const std::vector<std::chrono::system_clock::time_point>& sortedDates);
-
-// Check if the current time is within a given range
-bool isCurrentTimeInRange(const std::pair<std::chrono::system_clock::time_point, std::chrono::system_clock::time_point>& range);
-
-bool isTimeInRange(const std::pair<std::chrono::system_clock::time_point, std::chrono::system_clock::time_point>& range, const std::chrono::system_clock::time_point& time);
+// Parse a "YYYY-MM-DD HH:MM:SS" datetime, nullopt when the text is not one
+std::optional<std::chrono::system_clock::time_point> tryParseDateTime(const std::string& dateTime);
 
 // Get the current date and time in YYYY-MM-DD HH:MM:SS format
 std::string getCurrentDateTime();
 
-// Fetch news dates from the file and return the range
-std::pair<std::chrono::system_clock::time_point, std::chrono::system_clock::time_point> fetchNewsDateRange();
-
 #endif // NEWS_H
@@ -0,0 +1,112 @@
+#ifndef OMS_H
+#define OMS_H
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "../../Order/models/APIParams/APIParams.h"
+#include "../../Decode/headers/decode.h"
+#include "../../Http/headers/http.h"
+#include "../../UserData/headers/userdata.h"
+#include "../../Utils/headers/decimal.h"
+
+// Local view of one account's orders and positions.
+//
+// Fed by our own order acks and the user data stream, and reconciled against the exchange
+// over REST from time to time. While the view is trusted, pre-trade checks ("are we flat",
+// "is an entry already working", "did it fill") are answered from memory instead of a
+// positionRisk/openOrders round trip. Anything the stream may have missed (disconnects)
+// makes the view untrusted until the next reconcile, callers then ask the exchange.
+namespace Oms {
+    enum class OrderState : uint8_t {
+        New,
+        PartiallyFilled,
+        Filled,
+        Canceled,
+        Expired,
+        Rejected
+    };
+
+    const char *stateName(OrderState state);
+
+    // Exchange status ("NEW", "FILLED", ...), nullopt for anything unknown
+    std::optional<OrderState> parseState(std::string_view status);
+
+    bool isOpen(OrderState state);
+
+    // States only move forward: New -> PartiallyFilled -> Filled/Canceled/Expired, any
+    // open state may end in Canceled/Expired/Rejected, and a final state never changes.
+    bool canTransition(OrderState from, OrderState to);
+
+    struct Order {
+        long long orderId = 0;
+        std::string clientOrderId;
+        std::string symbol;
+        std::string side;
+        std::string type;
+        Qty origQty;
+        Qty executedQty;
+        OrderState state = OrderState::New;
+        // Exchange time of the last change applied
+        int64_t updatedMs = 0;
+    };
+
+    // One-way mode position (positionSide BOTH)
+    struct Position {
+        double amount = 0;
+        double entryPrice = 0;
+        int64_t updatedMs = 0;
+    };
+
+    class Book {
+    public:
+        void onAck(const Decode::OrderAck &ack);
+
+        void onOrderUpdate(const UserData::OrderUpdate &update);
+
+        void onAccountUpdate(const UserData::AccountUpdate &update);
+
+        // Replaces what is known about `symbol` with an exchange snapshot requested at
+        // `requestedMs` (exchange clock). Changes the stream applied after that are kept.
+        void reconcile(const std::string &symbol,
+                       const std::vector<Decode::PositionRisk> &positions,
+                       const nlohmann::json &openOrders,
+                       int64_t requestedMs);
+
+        // Fetches positionRisk and openOrders and reconciles, false if either failed (or
+        // was shed)
+        bool reconcile(const APIParams &apiParams, const std::string &symbol,
+                       Http::Priority priority = Http::Priority::Query);
+
+        // Events may have been missed, nothing is trusted until reconciled again
+        void markStale();
+
+        bool trusted(const std::string &symbol) const;
+
+        // nullopt when `symbol` is not trusted
+        std::optional<Position> position(const std::string &symbol) const;
+
+        // Open orders of `symbol`, nullopt when it is not trusted
+        std::optional<std::vector<Order>> openOrders(const std::string &symbol) const;
+
+        std::optional<Order> order(long long orderId) const;
+
+    private:
+        // Caller holds _mutex
+        void apply(Order next);
+
+        void prune();
+
+        mutable std::mutex _mutex;
+        std::unordered_map<long long, Order> _orders;
+        std::unordered_map<std::string, Position> _positions;
+        std::unordered_map<std::string, bool> _trusted;
+    };
+}
+
+#endif // OMS_H
@@ -0,0 +1,297 @@
+#include "../headers/oms.h"
+#include "../../Margin/headers/margin.h"
+#include "../../ClockSync/headers/clocksync.h"
+#include "../../Log/headers/log.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace Oms {
+    namespace {
+        // Terminal orders are kept for lookups until the book holds this many orders
+        constexpr size_t MAX_ORDERS = 1024;
+
+        int rank(OrderState state) {
+            switch (state) {
+                case OrderState::New:
+                    return 0;
+                case OrderState::PartiallyFilled:
+                    return 1;
+                default:
+                    return 2;
+            }
+        }
+
+        Qty qtyOf(const nlohmann::json &value) {
+            if (value.is_string()) {
+                return Qty::parse(value.get<std::string>()).value_or(Qty{});
+            }
+            return value.is_number() ? Qty::fromDouble(value.get<double>()) : Qty{};
+        }
+    }
+
+    const char *stateName(OrderState state) {
+        switch (state) {
+            case OrderState::New:
+                return "NEW";
+            case OrderState::PartiallyFilled:
+                return "PARTIALLY_FILLED";
+            case OrderState::Filled:
+                return "FILLED";
+            case OrderState::Canceled:
+                return "CANCELED";
+            case OrderState::Expired:
+                return "EXPIRED";
+            case OrderState::Rejected:
+                return "REJECTED";
+        }
+        return "?";
+    }
+
+    std::optional<OrderState> parseState(std::string_view status) {
+        if (status == "NEW") {
+            return OrderState::New;
+        }
+        if (status == "PARTIALLY_FILLED") {
+            return OrderState::PartiallyFilled;
+        }
+        if (status == "FILLED") {
+            return OrderState::Filled;
+        }
+        if (status == "CANCELED") {
+            return OrderState::Canceled;
+        }
+        if (status == "EXPIRED" || status == "EXPIRED_IN_MATCH") {
+            return OrderState::Expired;
+        }
+        if (status == "REJECTED") {
+            return OrderState::Rejected;
+        }
+        return std::nullopt;
+    }
+
+    bool isOpen(OrderState state) {
+        return state == OrderState::New || state == OrderState::PartiallyFilled;
+    }
+
+    bool canTransition(OrderState from, OrderState to) {
+        if (!isOpen(from)) {
+            return false;
+        }
+        return rank(to) >= rank(from);
+    }
+
+    void Book::apply(Order next) {
+        auto [itr, inserted] = _orders.try_emplace(next.orderId, next);
+        if (inserted) {
+            prune();
+            return;
+        }
+
+        Order &current = itr->second;
+        if (current.state != next.state && !canTransition(current.state, next.state)) {
+            return;
+        }
+        // Same state (another partial fill, a late duplicate): only ever move forward
+        if (next.executedQty < current.executedQty || next.updatedMs < current.updatedMs) {
+            return;
+        }
+        // Acks and stream events do not carry every field, keep what is known
+        if (next.clientOrderId.empty()) {
+            next.clientOrderId = std::move(current.clientOrderId);
+        }
+        if (next.type.empty()) {
+            next.type = std::move(current.type);
+        }
+        current = std::move(next);
+    }
+
+    void Book::prune() {
+        if (_orders.size() <= MAX_ORDERS) {
+            return;
+        }
+        std::vector<std::pair<int64_t, long long>> finished;
+        for (const auto &[orderId, order]: _orders) {
+            if (!isOpen(order.state)) {
+                finished.emplace_back(order.updatedMs, orderId);
+            }
+        }
+        std::sort(finished.begin(), finished.end());
+        size_t excess = std::min(finished.size(), _orders.size() - MAX_ORDERS / 2);
+        for (size_t i = 0; i < excess; ++i) {
+            _orders.erase(finished[i].second);
+        }
+    }
+
+    void Book::onAck(const Decode::OrderAck &ack) {
+        auto state = parseState(ack.status);
+        if (!ack.ok() || !state) {
+            return;
+        }
+
+        Order order;
+        order.orderId = ack.orderId;
+        order.clientOrderId = ack.clientOrderId;
+        order.symbol = ack.symbol;
+        order.side = ack.side;
+        order.type = ack.type;
+        order.origQty = ack.origQty;
+        order.executedQty = ack.executedQty;
+        order.state = *state;
+        order.updatedMs = ack.updateTime;
+
+        std::scoped_lock lock(_mutex);
+        apply(std::move(order));
+    }
+
+    void Book::onOrderUpdate(const UserData::OrderUpdate &update) {
+        auto state = parseState(update.status);
+        if (!state) {
+            return;
+        }
+
+        Order order;
+        order.orderId = update.orderId;
+        order.clientOrderId = update.clientOrderId;
+        order.symbol = update.symbol;
+        order.side = update.side;
+        order.type = update.orderType;
+        order.origQty = Qty::fromDouble(update.origQty);
+        order.executedQty = Qty::fromDouble(update.filledQty);
+        order.state = *state;
+        order.updatedMs = update.eventTimeMs;
+
+        std::scoped_lock lock(_mutex);
+        apply(std::move(order));
+    }
+
+    void Book::onAccountUpdate(const UserData::AccountUpdate &update) {
+        std::scoped_lock lock(_mutex);
+        for (const auto &change: update.positions) {
+            if (change.positionSide != "BOTH") {
+                continue;
+            }
+            Position &position = _positions[change.symbol];
+            if (update.eventTimeMs >= position.updatedMs) {
+                position = {change.amount, change.entryPrice, update.eventTimeMs};
+            }
+        }
+    }
+
+    void Book::reconcile(const std::string &symbol,
+                         const std::vector<Decode::PositionRisk> &positions,
+                         const nlohmann::json &openOrders,
+                         int64_t requestedMs) {
+        std::scoped_lock lock(_mutex);
+
+        for (const auto &risk: positions) {
+            if (risk.symbol != symbol || (risk.positionSide != "BOTH" && !risk.positionSide.empty())) {
+                continue;
+            }
+            Position &position = _positions[symbol];
+            if (requestedMs >= position.updatedMs) {
+                position = {risk.positionAmt, risk.entryPrice, requestedMs};
+            }
+        }
+
+        std::unordered_set<long long> listed;
+        if (openOrders.is_array()) {
+            for (const auto &entry: openOrders) {
+                auto state = parseState(entry.value("status", ""));
+                if (!state || !entry.contains("orderId")) {
+                    continue;
+                }
+                Order order;
+                order.orderId = entry["orderId"].get<long long>();
+                order.clientOrderId = entry.value("clientOrderId", "");
+                order.symbol = entry.value("symbol", symbol);
+                order.side = entry.value("side", "");
+                order.type = entry.value("origType", entry.value("type", ""));
+                order.origQty = qtyOf(entry.value("origQty", nlohmann::json()));
+                order.executedQty = qtyOf(entry.value("executedQty", nlohmann::json()));
+                order.state = *state;
+                order.updatedMs = entry.value("updateTime", 0LL);
+                listed.insert(order.orderId);
+                apply(std::move(order));
+            }
+        }
+
+        // Open here but not on the exchange: filled or canceled in between. Unless the
+        // stream told us after the snapshot was taken, forget it, a lookup asks the exchange.
+        std::erase_if(_orders, [&](const auto &item) {
+            const Order &order = item.second;
+            return order.symbol == symbol && isOpen(order.state) && !listed.contains(order.orderId) &&
+                   order.updatedMs < requestedMs;
+        });
+
+        _trusted[symbol] = true;
+    }
+
+    bool Book::reconcile(const APIParams &apiParams, const std::string &symbol, Http::Priority priority) {
+        int64_t requestedMs = ClockSync::nowMs();
+        auto positions_future = Margin::getPositionsAsync(apiParams, symbol, priority);
+        auto open_orders_future = Margin::getOpenOrdersAsync(apiParams, symbol, priority);
+
+        auto positions = positions_future.get();
+        nlohmann::json openOrders;
+        try {
+            openOrders = open_orders_future.get();
+        } catch (const std::exception &e) {
+            Log::error(apiParams.name, "/", symbol, ": openOrders failed: ", e.what());
+            return false;
+        }
+        if (positions.empty() || !openOrders.is_array()) {
+            return false;
+        }
+
+        reconcile(symbol, positions, openOrders, requestedMs);
+        return true;
+    }
+
+    void Book::markStale() {
+        std::scoped_lock lock(_mutex);
+        for (auto &[symbol, trusted]: _trusted) {
+            trusted = false;
+        }
+    }
+
+    bool Book::trusted(const std::string &symbol) const {
+        std::scoped_lock lock(_mutex);
+        auto itr = _trusted.find(symbol);
+        return itr != _trusted.end() && itr->second;
+    }
+
+    std::optional<Position> Book::position(const std::string &symbol) const {
+        std::scoped_lock lock(_mutex);
+        auto trusted = _trusted.find(symbol);
+        if (trusted == _trusted.end() || !trusted->second) {
+            return std::nullopt;
+        }
+        auto itr = _positions.find(symbol);
+        return itr != _positions.end() ? itr->second : Position{};
+    }
+
+    std::optional<std::vector<Order>> Book::openOrders(const std::string &symbol) const {
+        std::scoped_lock lock(_mutex);
+        auto trusted = _trusted.find(symbol);
+        if (trusted == _trusted.end() || !trusted->second) {
+            return std::nullopt;
+        }
+        std::vector<Order> open;
+        for (const auto &[orderId, order]: _orders) {
+            if (order.symbol == symbol && isOpen(order.state)) {
+                open.push_back(order);
+            }
+        }
+        return open;
+    }
+
+    std::optional<Order> Book::order(long long orderId) const {
+        std::scoped_lock lock(_mutex);
+        auto itr = _orders.find(orderId);
+        if (itr == _orders.end()) {
+            return std::nullopt;
+        }
+        return itr->second;
+    }
+}
@@ -4,14 +4,49 @@
 #include "../models/APIParams/APIParams.h"
 #include "../models/OrderInput/OrderInput.h"
 #include "../models/TriggerOrderInput/TriggerOrderInput.h"
+#include "../../Decode/headers/decode.h"
+#include "../../Http/headers/http.h"
 #include "nlohmann/json.hpp"
+#include <future>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One leg of a fapi/v1/batchOrders call, in the order the legs were sent. A failed leg
+// (or a request that failed as a whole) carries the exchange error code and message.
+// Legs whose outcome was unknown (timeout, 5xx, -1000/-1006/-1007) have been looked up by
+// their client order id: found ones are ok, ones the lookup could not settle are `unknown`
+// and must not be sent again.
+struct BatchOrderResult {
+    nlohmann::json response;
+    int code = 0;
+    std::string msg;
+    bool unknown = false;
+
+    bool ok() const { return code == 0; }
+};
 
 class OrderService {
 public:
-    static nlohmann::json createOrder(const APIParams &apiParams, const OrderInput &order);
-    static nlohmann::json createTriggerOrder(const APIParams &apiParams, const TriggerOrderInput &triggerOrder);
+    static Decode::OrderAck createOrder(const APIParams &apiParams, const OrderInput &order);
+    static Decode::OrderAck createTriggerOrder(const APIParams &apiParams, const TriggerOrderInput &triggerOrder);
     static nlohmann::json cancelAllOpenOrders(const APIParams &apiParams, const std::string &symbol);
-    static nlohmann::json getOrderDetails(const APIParams &apiParams, const std::string &symbol, const std::string &orderId = "", const std::string &origClientOrderId = "");
+
+    // Up to 5 orders in a single signed request. The exchange accepts or rejects every
+    // leg on its own, see BatchOrderResult.
+    static std::vector<BatchOrderResult> createBatchOrders(const APIParams &apiParams, std::span<const OrderInput> orders);
+    static std::vector<BatchOrderResult> createBatchOrders(const APIParams &apiParams, std::span<const TriggerOrderInput> triggerOrders);
+    // Same id for the same inputs, e.g. (account, symbol, signal time, "entry"), so a
+    // resent order can not be placed twice and its outcome can be looked up
+    static std::string clientOrderId(std::string_view account, std::string_view symbol, std::string_view source, std::string_view leg);
+    static Decode::OrderAck getOrderDetails(const APIParams &apiParams, const std::string &symbol, const std::string &orderId = "", const std::string &origClientOrderId = "",
+                                            Http::Priority priority = Http::Priority::Query);
+
+    static std::future<Decode::OrderAck> createOrderAsync(const APIParams &apiParams, const OrderInput &order);
+    static std::future<Decode::OrderAck> createTriggerOrderAsync(const APIParams &apiParams, const TriggerOrderInput &triggerOrder);
+    static std::future<nlohmann::json> cancelAllOpenOrdersAsync(const APIParams &apiParams, const std::string &symbol);
+    static std::future<Decode::OrderAck> getOrderDetailsAsync(const APIParams &apiParams, const std::string &symbol, const std::string &orderId = "", const std::string &origClientOrderId = "");
 };
 
 #endif // ORDER_SERVICE_H
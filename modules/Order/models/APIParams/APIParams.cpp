@@ -1,4 +1,5 @@
 #include "APIParams.h"
+#include "../../../Http/headers/http.h"
 
 APIParams::APIParams(
         const std::string &apiKey,
@@ -10,3 +11,14 @@ APIParams::APIParams(
         apiSecret(apiSecret),
         recvWindow(recvWindow),
         useTestnet(useTestnet) {}
+
+std::string APIParams::baseUrl() const {
+    if (!restUrl.empty()) {
+        return restUrl;
+    }
+    return useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
+}
+
+Http::SessionPool &APIParams::sessionPool() const {
+    return sessions ? *sessions : Http::SessionPool::shared();
+}
@@ -1,8 +1,15 @@
 #ifndef API_PARAMS_H
 #define API_PARAMS_H
 
+#include <memory>
 #include <string>
 
+namespace Http {
+    class SessionPool;
+
+    class TokenBucket;
+}
+
 class APIParams {
 public:
     std::string apiKey;
@@ -10,12 +17,26 @@ public:
     long recvWindow;
     bool useTestnet;
 
+    // Label of the account in logs and metrics
+    std::string name = "main";
+    // REST endpoint instead of the exchange's (e.g. tools/MockExchange), empty for mainnet/testnet
+    std::string restUrl;
+    // Connections of this account, the process wide pool when null
+    std::shared_ptr<Http::SessionPool> sessions;
+    // New orders this account may still send, the exchange counts them per account.
+    // Unlimited when null.
+    std::shared_ptr<Http::TokenBucket> orderBudget;
+
     APIParams(
             const std::string &apiKey,
             const std::string &apiSecret,
             const long &recvWindow,
             bool useTestnet
     );
+
+    std::string baseUrl() const;
+
+    Http::SessionPool &sessionPool() const;
 };
 
 #endif // API_PARAMS_H
@@ -5,8 +5,8 @@ OrderInput::OrderInput(
         const std::string &side,
         const std::string &type,
         const std::string &timeInForce,
-        const double &quantity,
-        const double &price
+        const Qty &quantity,
+        const Price &price
 ) :
         symbol(symbol),
         side(side),
@@ -2,6 +2,7 @@
 #define ORDER_INPUT_H
 
 #include <string>
+#include "../../../Utils/headers/decimal.h"
 
 class OrderInput {
 public:
@@ -9,16 +10,18 @@ public:
     std::string side;
     std::string type;
     std::string timeInForce;
-    double quantity;
-    double price;
+    Qty quantity;
+    Price price;
+    // Sent as newClientOrderId when set
+    std::string clientOrderId;
 
     OrderInput(
             const std::string &symbol,
             const std::string &side,
             const std::string &type,
             const std::string &timeInForce,
-            const double &quantity,
-            const double &price
+            const Qty &quantity,
+            const Price &price
     );
 };
 
@@ -5,9 +5,9 @@ TriggerOrderInput::TriggerOrderInput(
         const std::string &side,
         const std::string &type,
         const std::string &timeInForce,
-        const double &quantity,
-        const double &price,
-        const double &stopPrice,
+        const Qty &quantity,
+        const Price &price,
+        const Price &stopPrice,
         const bool &reduceOnly
 ) :
         OrderInput(symbol, side, type, timeInForce, quantity, price),
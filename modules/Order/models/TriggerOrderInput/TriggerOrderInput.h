@@ -6,16 +6,16 @@
 
 class TriggerOrderInput : public OrderInput {
 public:
-    double stopPrice;
+    Price stopPrice;
     const bool reduceOnly;
 
     TriggerOrderInput(const std::string &symbol,
                       const std::string &side,
                       const std::string &type,
                       const std::string &timeInForce,
-                      const double &quantity,
-                      const double &price,
-                      const double &stopPrice,
+                      const Qty &quantity,
+                      const Price &price,
+                      const Price &stopPrice,
                       const bool &reduceOnly);
 };
 
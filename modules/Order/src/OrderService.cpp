@@ -1,109 +1,433 @@
 #include "../headers/order.h"
-#include "../../Utils/headers/utils.h"
+#include "../../Http/headers/http.h"
+#include "../../Http/headers/signedrequest.h"
+#include "../../Http/headers/ratelimit.h"
+#include "../../Http/headers/scheduler.h"
+#include "../../ClockSync/headers/clocksync.h"
+#include "../../Log/headers/log.h"
 #include "cpr/cpr.h"
-#include <iostream>
-#include <ctime>
+#include <random>
+#include <stdexcept>
+#include <thread>
 
-nlohmann::json OrderService::createOrder(const APIParams &apiParams, const OrderInput &order) {
-    std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-    std::string apiCall = "fapi/v1/order";
+namespace {
+    // batchOrders takes every value as a string
+    nlohmann::json batchLeg(const OrderInput &order) {
+        nlohmann::json leg = {
+                {"symbol", order.symbol},
+                {"side", order.side},
+                {"type", order.type},
+                {"timeInForce", order.timeInForce},
+                {"quantity", order.quantity.toString()}
+        };
+        if (order.type != "MARKET") {
+            leg["price"] = order.price.toString();
+        }
+        if (!order.clientOrderId.empty()) {
+            leg["newClientOrderId"] = order.clientOrderId;
+        }
+        return leg;
+    }
+
+    nlohmann::json batchLeg(const TriggerOrderInput &triggerOrder) {
+        nlohmann::json leg = {
+                {"symbol", triggerOrder.symbol},
+                {"side", triggerOrder.side},
+                {"type", triggerOrder.type},
+                {"quantity", triggerOrder.quantity.toString()},
+                {"stopPrice", triggerOrder.stopPrice.toString()}
+        };
+        if (triggerOrder.type != "STOP_MARKET" && triggerOrder.type != "TAKE_PROFIT_MARKET") {
+            leg["price"] = triggerOrder.price.toString();
+        }
+        if (triggerOrder.reduceOnly) {
+            leg["reduceOnly"] = "true";
+        }
+        if (!triggerOrder.clientOrderId.empty()) {
+            leg["newClientOrderId"] = triggerOrder.clientOrderId;
+        }
+        return leg;
+    }
 
-    long timestamp = static_cast<long>(std::time(nullptr) * 1000);
+    // A rejected timestamp means the clock offset went stale
+    void checkTimestamp(int code) {
+        if (code == ClockSync::INVALID_TIMESTAMP) {
+            ClockSync::requestResync();
+        }
+    }
 
-    std::string params =
-            "symbol=" + order.symbol + "&side=" + order.side + "&type=" + order.type + "&timeInForce=" +
-            order.timeInForce +
-            "&quantity=" + std::to_string(order.quantity) + "&recvWindow=" + std::to_string(apiParams.recvWindow) +
-            "&timestamp=" + std::to_string(timestamp);
+    // Same code the exchange answers with when an account sends too many orders
+    constexpr int TOO_MANY_ORDERS = -1015;
+    constexpr const char *OVER_BUDGET = "Order budget of the account used up";
 
-    if (order.type != "MARKET") {
-        params += "&price=" + std::to_string(order.price);
+    // Orders are counted per account by the exchange, going over the limit gets the
+    // account blocked for a while. Refused locally instead of being sent.
+    bool takeOrderBudget(const APIParams &apiParams, size_t orders) {
+        if (!apiParams.orderBudget || apiParams.orderBudget->tryAcquire(static_cast<double>(orders))) {
+            return true;
+        }
+        Log::warn(apiParams.name, ": order budget used up, ", orders, " order(s) not sent");
+        return false;
     }
 
-    std::string signature = Utils::HMAC_SHA256(apiParams.apiSecret, params);
-    std::string url = baseUrl + "/" + apiCall + "?" + params + "&signature=" + Utils::urlEncode(signature);
+    // Orders the exchange allows an account per 10s and per minute
+    constexpr long ORDERS_PER_10S = 300;
+    constexpr long ORDERS_PER_MINUTE = 1200;
 
-    cpr::Response r = cpr::Post(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
-    std::cout << "Response Code: " << r.status_code << std::endl;
-    std::cout << "Response Text: " << r.text << std::endl;
+    // The exchange's own count of the account's orders bounds what the local budget allows
+    void syncOrderBudget(const APIParams &apiParams, const cpr::Response &r) {
+        if (!apiParams.orderBudget) {
+            return;
+        }
+        if (auto count = Http::headerNumber(r, "X-MBX-ORDER-COUNT-10S")) {
+            apiParams.orderBudget->cap(static_cast<double>(ORDERS_PER_10S - *count));
+        }
+        if (auto count = Http::headerNumber(r, "X-MBX-ORDER-COUNT-1M")) {
+            apiParams.orderBudget->cap(static_cast<double>(ORDERS_PER_MINUTE - *count));
+        }
+    }
 
-    return nlohmann::json::parse(r.text);
-}
+    Decode::OrderAck overBudget() {
+        Decode::OrderAck ack;
+        ack.error = Decode::ApiError{TOO_MANY_ORDERS, OVER_BUDGET};
+        return ack;
+    }
 
-nlohmann::json OrderService::createTriggerOrder(const APIParams &apiParams, const TriggerOrderInput &triggerOrder) {
-    std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-    std::string apiCall = "fapi/v1/order";
+    Decode::OrderAck decodeAck(const APIParams &apiParams, const cpr::Response &r) {
+        syncOrderBudget(apiParams, r);
+        if (r.error) {
+            Decode::OrderAck ack;
+            ack.error = Decode::ApiError{-1, r.error.message};
+            return ack;
+        }
+        Decode::OrderAck ack = Decode::orderAck(r.text);
+        if (ack.error) {
+            checkTimestamp(ack.error->code);
+        }
+        return ack;
+    }
 
-    long timestamp = static_cast<long>(std::time(nullptr) * 1000);
+    // A new order is sent up to this many times while the exchange has not definitely
+    // answered, backing off ORDER_BACKOFF * 2^n (jittered) in between
+    constexpr int ORDER_ATTEMPTS = 3;
+    constexpr std::chrono::milliseconds ORDER_BACKOFF{40};
+    // Exchange codes: the backend timed out / answered garbage (the order may exist),
+    // and no order with that id
+    constexpr int UNKNOWN_ERROR = -1000;
+    constexpr int UNEXPECTED_RESPONSE = -1006;
+    constexpr int BACKEND_TIMEOUT = -1007;
+    constexpr int NO_SUCH_ORDER = -2013;
 
-    std::string params =
-            "symbol=" + triggerOrder.symbol + "&side=" + triggerOrder.side + "&type=" + triggerOrder.type +
-            "&quantity=" + std::to_string(triggerOrder.quantity) + "&recvWindow=" +
-            std::to_string(apiParams.recvWindow) +
-            "&timestamp=" + std::to_string(timestamp);
+    enum class Outcome {
+        // Accepted or rejected, either way final
+        Answered,
+        // Never left this process, safe to send again
+        NotSent,
+        // May or may not have reached the exchange
+        Unknown
+    };
 
-    if (triggerOrder.type == "STOP_MARKET" || triggerOrder.type == "TAKE_PROFIT_MARKET") {
-        params += "&stopPrice=" + std::to_string(triggerOrder.stopPrice);
-    } else {
-        params += "&price=" + std::to_string(triggerOrder.price) + "&stopPrice=" + std::to_string(triggerOrder.stopPrice);
+    bool mayExist(int code) {
+        return code == UNKNOWN_ERROR || code == UNEXPECTED_RESPONSE || code == BACKEND_TIMEOUT;
+    }
+
+    Outcome outcomeOf(const cpr::Response &r, const Decode::OrderAck &ack) {
+        if (r.error) {
+            switch (r.error.code) {
+                case cpr::ErrorCode::HOST_RESOLUTION_FAILURE:
+                case cpr::ErrorCode::CONNECTION_FAILURE:
+                case cpr::ErrorCode::SSL_CONNECT_ERROR:
+                case cpr::ErrorCode::REQUEST_CANCELLED:
+                    return Outcome::NotSent;
+                default:
+                    return Outcome::Unknown;
+            }
+        }
+        if (r.status_code >= 500 || r.text.empty()) {
+            return Outcome::Unknown;
+        }
+        if (ack.error && mayExist(ack.error->code)) {
+            return Outcome::Unknown;
+        }
+        return Outcome::Answered;
+    }
+
+    void backOff(int attempt) {
+        thread_local std::minstd_rand random(std::random_device{}());
+        auto ceiling = ORDER_BACKOFF * (1 << (attempt - 1));
+        std::uniform_int_distribution<long> jitter(ceiling.count() / 2, ceiling.count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(jitter(random)));
     }
 
-    if (triggerOrder.reduceOnly) {
-        params += "&reduceOnly=true";
+    // Sends until the exchange has answered. When the outcome is unknown the order is
+    // looked up by its client order id: found means it got there, unknown to the exchange
+    // means it is sent again. Without a client order id an unknown outcome is final, a
+    // blind resubmit could double the position.
+    template<typename Send>
+    Decode::OrderAck submit(const APIParams &apiParams, const std::string &symbol, const std::string &clientOrderId, Send &&send) {
+        for (int attempt = 1;; ++attempt) {
+            if (!takeOrderBudget(apiParams, 1)) {
+                return overBudget();
+            }
+            cpr::Response r = send();
+            Decode::OrderAck ack = decodeAck(apiParams, r);
+
+            Outcome outcome = outcomeOf(r, ack);
+            if (outcome == Outcome::Answered) {
+                return ack;
+            }
+            if (outcome == Outcome::Unknown) {
+                if (clientOrderId.empty()) {
+                    Log::error(apiParams.name, "/", symbol, ": order outcome unknown (HTTP ", r.status_code, ") and no client order id to look it up");
+                    return ack;
+                }
+                Log::warn(apiParams.name, "/", symbol, ": order ", clientOrderId, " outcome unknown (HTTP ", r.status_code, "), looking it up");
+                Decode::OrderAck known = OrderService::getOrderDetails(apiParams, symbol, "", clientOrderId, Http::Priority::Trade);
+                if (known.ok()) {
+                    return known;
+                }
+                if (!known.error || known.error->code != NO_SUCH_ORDER) {
+                    Log::error(apiParams.name, "/", symbol, ": order ", clientOrderId, " still unknown, not sending it again");
+                    return ack;
+                }
+            }
+
+            if (attempt >= ORDER_ATTEMPTS) {
+                Log::error(apiParams.name, "/", symbol, ": order ", clientOrderId, " not placed after ", attempt, " attempts");
+                return ack;
+            }
+            backOff(attempt);
+        }
+    }
+
+    // Same lookup as submit() for one leg of a batch: found means placed, unknown to the
+    // exchange leaves it failed (safe to send again), anything else marks it unknown.
+    void resolveLeg(const APIParams &apiParams, const nlohmann::json &leg, BatchOrderResult &result) {
+        std::string symbol = leg.value("symbol", "");
+        std::string clientOrderId = leg.value("newClientOrderId", "");
+        if (clientOrderId.empty()) {
+            Log::error(apiParams.name, "/", symbol, ": batch leg outcome unknown and no client order id to look it up");
+            result.unknown = true;
+            return;
+        }
+
+        Log::warn(apiParams.name, "/", symbol, ": batch leg ", clientOrderId, " outcome unknown (", result.code, "), looking it up");
+        Decode::OrderAck known = OrderService::getOrderDetails(apiParams, symbol, "", clientOrderId, Http::Priority::Trade);
+        if (known.ok()) {
+            result.response = {{"orderId", known.orderId}, {"clientOrderId", known.clientOrderId}, {"symbol", known.symbol}, {"status", known.status}};
+            result.code = 0;
+            result.msg.clear();
+            return;
+        }
+        if (!known.error || known.error->code != NO_SUCH_ORDER) {
+            Log::error(apiParams.name, "/", symbol, ": batch leg ", clientOrderId, " still unknown, not sending it again");
+            result.unknown = true;
+        }
+    }
+
+    std::vector<BatchOrderResult> sendBatch(const APIParams &apiParams, const nlohmann::json &legs) {
+        if (!takeOrderBudget(apiParams, legs.size())) {
+            std::vector<BatchOrderResult> results(legs.size());
+            for (auto &result: results) {
+                result.code = TOO_MANY_ORDERS;
+                result.msg = OVER_BUDGET;
+            }
+            return results;
+        }
+
+        std::string baseUrl = apiParams.baseUrl();
+
+        auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/batchOrders");
+        request.paramEncoded("batchOrders", legs.dump()).param("recvWindow", apiParams.recvWindow).timestamp();
+
+        cpr::Response r = Http::post(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool(), Http::Priority::Trade);
+        Log::info("POST fapi/v1/batchOrders ", r.status_code, " ", r.text);
+        syncOrderBudget(apiParams, r);
+
+        std::vector<BatchOrderResult> results(legs.size());
+        auto body = nlohmann::json::parse(r.text, nullptr, false);
+        if (body.is_array() && body.size() == legs.size()) {
+            for (size_t i = 0; i < results.size(); ++i) {
+                results[i].response = body[i];
+                if (body[i].contains("code") && body[i]["code"].is_number() && body[i]["code"].get<int>() != 200) {
+                    results[i].code = body[i]["code"].get<int>();
+                    results[i].msg = body[i].value("msg", "");
+                    if (mayExist(results[i].code)) {
+                        resolveLeg(apiParams, legs[i], results[i]);
+                    }
+                }
+            }
+            return results;
+        }
+
+        // The request failed as a whole. Answered (signature, timestamp...) or never sent,
+        // none of the legs exist. Otherwise (timeout, 5xx) every leg is looked up.
+        int code = body.is_object() && body.contains("code") && body["code"].is_number() ? body["code"].get<int>() : -1;
+        checkTimestamp(code);
+        std::string msg = body.is_object() ? body.value("msg", "") : "";
+        if (msg.empty()) {
+            msg = r.error ? r.error.message : "Unexpected response (HTTP " + std::to_string(r.status_code) + ")";
+        }
+        Decode::OrderAck ack;
+        ack.error = Decode::ApiError{code, msg};
+        Outcome outcome = outcomeOf(r, ack);
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            results[i].response = body.is_discarded() ? nlohmann::json() : body;
+            results[i].code = code;
+            results[i].msg = msg;
+            if (outcome == Outcome::Unknown) {
+                resolveLeg(apiParams, legs[i], results[i]);
+            }
+        }
+        return results;
     }
+}
 
-    std::string signature = Utils::HMAC_SHA256(apiParams.apiSecret, params);
-    std::string url = baseUrl + "/" + apiCall + "?" + params + "&signature=" + Utils::urlEncode(signature);
+Decode::OrderAck OrderService::createOrder(const APIParams &apiParams, const OrderInput &order) {
+    return submit(apiParams, order.symbol, order.clientOrderId, [&]() {
+        std::string baseUrl = apiParams.baseUrl();
 
-    cpr::Response r = cpr::Post(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
-    std::cout << "Response Code: " << r.status_code << std::endl;
-    std::cout << "Response Text: " << r.text << std::endl;
+        // Signed again on every attempt, the timestamp has to be fresh
+        auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/order");
+        request.param("symbol", order.symbol).param("side", order.side).param("type", order.type)
+                .param("timeInForce", order.timeInForce).param("quantity", order.quantity)
+                .param("recvWindow", apiParams.recvWindow).timestamp();
 
-    return nlohmann::json::parse(r.text);
+        if (order.type != "MARKET") {
+            request.param("price", order.price);
+        }
+        if (!order.clientOrderId.empty()) {
+            request.param("newClientOrderId", order.clientOrderId);
+        }
+
+        cpr::Response r = Http::post(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool(), Http::Priority::Trade);
+        Log::info("POST fapi/v1/order ", r.status_code, " ", r.text);
+        return r;
+    });
+}
+
+Decode::OrderAck OrderService::createTriggerOrder(const APIParams &apiParams, const TriggerOrderInput &triggerOrder) {
+    return submit(apiParams, triggerOrder.symbol, triggerOrder.clientOrderId, [&]() {
+        std::string baseUrl = apiParams.baseUrl();
+
+        auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/order");
+        request.param("symbol", triggerOrder.symbol).param("side", triggerOrder.side).param("type", triggerOrder.type)
+                .param("quantity", triggerOrder.quantity).param("recvWindow", apiParams.recvWindow).timestamp();
+
+        if (triggerOrder.type == "STOP_MARKET" || triggerOrder.type == "TAKE_PROFIT_MARKET") {
+            request.param("stopPrice", triggerOrder.stopPrice);
+        } else {
+            request.param("price", triggerOrder.price).param("stopPrice", triggerOrder.stopPrice);
+        }
+
+        if (triggerOrder.reduceOnly) {
+            request.param("reduceOnly", true);
+        }
+        if (!triggerOrder.clientOrderId.empty()) {
+            request.param("newClientOrderId", triggerOrder.clientOrderId);
+        }
+
+        cpr::Response r = Http::post(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool(), Http::Priority::Trade);
+        Log::info("POST fapi/v1/order ", r.status_code, " ", r.text);
+        return r;
+    });
 }
 
 nlohmann::json OrderService::cancelAllOpenOrders(const APIParams &apiParams, const std::string &symbol) {
-    std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-    std::string apiCall = "fapi/v1/allOpenOrders";
+    std::string baseUrl = apiParams.baseUrl();
 
-    long timestamp = static_cast<long>(std::time(nullptr) * 1000);
+    auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/allOpenOrders");
+    request.param("symbol", symbol).param("recvWindow", apiParams.recvWindow).timestamp();
 
-    std::string params =
-            "symbol=" + symbol + "&recvWindow=" + std::to_string(apiParams.recvWindow) +
-            "&timestamp=" + std::to_string(timestamp);
+    cpr::Response r = Http::del(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool(), Http::Priority::Trade);
+    Log::info("DELETE fapi/v1/allOpenOrders ", r.status_code, " ", r.text);
 
-    std::string signature = Utils::HMAC_SHA256(apiParams.apiSecret, params);
-    std::string url = baseUrl + "/" + apiCall + "?" + params + "&signature=" + Utils::urlEncode(signature);
+    auto body = nlohmann::json::parse(r.text, nullptr, false);
+    if (body.is_discarded()) {
+        std::string msg = r.error ? r.error.message : "Unexpected response (HTTP " + std::to_string(r.status_code) + ")";
+        return {{"code", -1}, {"msg", msg}};
+    }
+    return body;
+}
 
-    cpr::Response r = cpr::Delete(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
-    std::cout << "Response Code: " << r.status_code << std::endl;
-    std::cout << "Response Text: " << r.text << std::endl;
+std::vector<BatchOrderResult> OrderService::createBatchOrders(const APIParams &apiParams, std::span<const OrderInput> orders) {
+    nlohmann::json legs = nlohmann::json::array();
+    for (const auto &order: orders) {
+        legs.push_back(batchLeg(order));
+    }
+    return sendBatch(apiParams, legs);
+}
 
-    return nlohmann::json::parse(r.text);
+std::vector<BatchOrderResult> OrderService::createBatchOrders(const APIParams &apiParams, std::span<const TriggerOrderInput> triggerOrders) {
+    nlohmann::json legs = nlohmann::json::array();
+    for (const auto &triggerOrder: triggerOrders) {
+        legs.push_back(batchLeg(triggerOrder));
+    }
+    return sendBatch(apiParams, legs);
 }
 
-nlohmann::json OrderService::getOrderDetails(const APIParams &apiParams, const std::string &symbol, const std::string &orderId, const std::string &origClientOrderId) {
-    std::string baseUrl = apiParams.useTestnet ? "https://testnet.binancefuture.com" : "https://fapi.binance.com";
-    std::string apiCall = "fapi/v1/order";
+std::string OrderService::clientOrderId(std::string_view account, std::string_view symbol, std::string_view source, std::string_view leg) {
+    // FNV-1a over the parts, the exchange allows [.A-Z:/a-z0-9_-]{1,36}
+    uint64_t hash = 14695981039346656037ULL;
+    for (std::string_view part: {account, symbol, source}) {
+        for (unsigned char c: part) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        hash = (hash ^ '/') * 1099511628211ULL;
+    }
+
+    static constexpr char HEX[] = "0123456789abcdef";
+    std::string id = "x-";
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        id += HEX[(hash >> shift) & 0xf];
+    }
+    id += '-';
+    id.append(leg.substr(0, 36 - id.size()));
+    return id;
+}
 
-    long timestamp = static_cast<long>(std::time(nullptr) * 1000);
+Decode::OrderAck OrderService::getOrderDetails(const APIParams &apiParams, const std::string &symbol, const std::string &orderId, const std::string &origClientOrderId,
+                                               Http::Priority priority) {
+    std::string baseUrl = apiParams.baseUrl();
 
-    std::string params = "symbol=" + symbol + "&recvWindow=" + std::to_string(apiParams.recvWindow) + "&timestamp=" + std::to_string(timestamp);
+    auto &request = Http::SignedRequestBuilder::forThread("fapi/v1/order");
+    request.param("symbol", symbol).param("recvWindow", apiParams.recvWindow).timestamp();
 
     if (!orderId.empty()) {
-        params += "&orderId=" + orderId;
+        request.param("orderId", orderId);
     } else if (!origClientOrderId.empty()) {
-        params += "&origClientOrderId=" + origClientOrderId;
+        request.paramEncoded("origClientOrderId", origClientOrderId);
     } else {
         throw std::invalid_argument("Either orderId or origClientOrderId must be provided.");
     }
 
-    std::string signature = Utils::HMAC_SHA256(apiParams.apiSecret, params);
-    std::string url = baseUrl + "/" + apiCall + "?" + params + "&signature=" + Utils::urlEncode(signature);
+    cpr::Response r = Http::get(baseUrl, request.sign(apiParams.apiSecret), cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool(), priority);
+    Log::info("GET fapi/v1/order ", r.status_code, " ", r.text);
+
+    return decodeAck(apiParams, r);
+}
+
+std::future<Decode::OrderAck> OrderService::createOrderAsync(const APIParams &apiParams, const OrderInput &order) {
+    return std::async(std::launch::async, [apiParams, order]() {
+        return createOrder(apiParams, order);
+    });
+}
 
-    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}});
-    std::cout << "Response Code: " << r.status_code << std::endl;
-    std::cout << "Response Text: " << r.text << std::endl;
+std::future<Decode::OrderAck> OrderService::createTriggerOrderAsync(const APIParams &apiParams, const TriggerOrderInput &triggerOrder) {
+    return std::async(std::launch::async, [apiParams, triggerOrder]() {
+        return createTriggerOrder(apiParams, triggerOrder);
+    });
+}
+
+std::future<nlohmann::json> OrderService::cancelAllOpenOrdersAsync(const APIParams &apiParams, const std::string &symbol) {
+    return std::async(std::launch::async, [apiParams, symbol]() {
+        return cancelAllOpenOrders(apiParams, symbol);
+    });
+}
 
-    return nlohmann::json::parse(r.text);
+std::future<Decode::OrderAck> OrderService::getOrderDetailsAsync(const APIParams &apiParams, const std::string &symbol, const std::string &orderId, const std::string &origClientOrderId) {
+    return std::async(std::launch::async, [apiParams, symbol, orderId, origClientOrderId]() {
+        return getOrderDetails(apiParams, symbol, orderId, origClientOrderId);
+    });
 }
@@ -0,0 +1,95 @@
+#ifndef SIGNAL_SOURCE_H
+#define SIGNAL_SOURCE_H
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct SignalDocument {
+    std::string name;
+    std::string content;
+};
+
+// Delivers the signal/news/deactivate CSVs only when they actually changed, so the
+// signaling loop re-reads and re-parses a file once per update instead of on every
+// iteration. The first poll() returns every document that exists.
+class SignalSource {
+public:
+    virtual ~SignalSource() = default;
+
+    // Waits at most `timeout` for changes and returns the documents whose content changed
+    // since the previous call, possibly none. A removed document is reported with empty
+    // content.
+    virtual std::vector<SignalDocument> poll(std::chrono::milliseconds timeout) = 0;
+
+protected:
+    // Returns true when content differs from what was last reported for name.
+    bool remember(const std::string &name, const std::string &content);
+
+private:
+    std::map<std::string, std::string> _reported;
+};
+
+// Local directory watched through inotify, wakes up as soon as a file is written.
+class InotifySignalSource : public SignalSource {
+public:
+    InotifySignalSource(std::string directory, std::vector<std::string> names);
+
+    ~InotifySignalSource() override;
+
+    std::vector<SignalDocument> poll(std::chrono::milliseconds timeout) override;
+
+private:
+    std::string _directory;
+    std::vector<std::string> _names;
+    int _fd = -1;
+    bool _initialized = false;
+};
+
+// Local directory polled through stat(), for filesystems without inotify support
+// (network mounts, gcsfuse). Files are only read when mtime, size or inode moved.
+class MtimeSignalSource : public SignalSource {
+public:
+    MtimeSignalSource(std::string directory, std::vector<std::string> names);
+
+    std::vector<SignalDocument> poll(std::chrono::milliseconds timeout) override;
+
+private:
+    struct FileStamp {
+        long long mtimeNs = -1;
+        long long size = -1;
+        unsigned long long inode = 0;
+
+        bool operator==(const FileStamp &) const = default;
+    };
+
+    std::string _directory;
+    std::vector<std::string> _names;
+    std::map<std::string, FileStamp> _stamps;
+    bool _initialized = false;
+};
+
+// Objects in a GCS bucket. Every poll is a single `gsutil stat` for all objects, an
+// object is only downloaded when its generation changed.
+class GsutilSignalSource : public SignalSource {
+public:
+    GsutilSignalSource(std::string bucket, std::vector<std::string> names, std::string gsutil = "/usr/bin/gsutil");
+
+    std::vector<SignalDocument> poll(std::chrono::milliseconds timeout) override;
+
+private:
+    std::string _bucket;
+    std::vector<std::string> _names;
+    std::string _gsutil;
+    std::map<std::string, std::string> _generations;
+    bool _initialized = false;
+};
+
+// SIGNAL_SOURCE selects the backend: "gcs" (default), "inotify" or "mtime".
+// SIGNAL_BUCKET and SIGNAL_DIR point the backends at their data.
+std::unique_ptr<SignalSource> createSignalSource(const std::map<std::string, std::string> &env,
+                                                 const std::vector<std::string> &names);
+
+#endif // SIGNAL_SOURCE_H
@@ -0,0 +1,211 @@
+#include "../headers/signalsource.h"
+#include "../../Utils/headers/utils.h"
+#include "../../Log/headers/log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+namespace {
+    std::string readFile(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return "";
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    std::string envOr(const std::map<std::string, std::string> &env, const std::string &key, const std::string &fallback) {
+        auto itr = env.find(key);
+        return itr == env.end() || itr->second.empty() ? fallback : itr->second;
+    }
+}
+
+bool SignalSource::remember(const std::string &name, const std::string &content) {
+    auto itr = _reported.find(name);
+    if (itr != _reported.end() && itr->second == content) {
+        return false;
+    }
+    _reported[name] = content;
+    return true;
+}
+
+InotifySignalSource::InotifySignalSource(std::string directory, std::vector<std::string> names) :
+        _directory(std::move(directory)),
+        _names(std::move(names)),
+        _fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+    if (_fd < 0 || inotify_add_watch(_fd, _directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM) < 0) {
+        throw std::runtime_error("Could not watch signal directory " + _directory);
+    }
+}
+
+InotifySignalSource::~InotifySignalSource() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+std::vector<SignalDocument> InotifySignalSource::poll(std::chrono::milliseconds timeout) {
+    std::vector<SignalDocument> changed;
+    std::set<std::string> touched;
+
+    if (!_initialized) {
+        _initialized = true;
+        touched.insert(_names.begin(), _names.end());
+    } else {
+        pollfd pfd{_fd, POLLIN, 0};
+        if (::poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) {
+            return changed;
+        }
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(_fd, buffer, sizeof(buffer))) > 0) {
+            for (char *ptr = buffer; ptr < buffer + length;) {
+                auto *event = reinterpret_cast<inotify_event *>(ptr);
+                if (event->len > 0) {
+                    std::string name(event->name);
+                    if (std::find(_names.begin(), _names.end(), name) != _names.end()) {
+                        touched.insert(name);
+                    }
+                }
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+
+    for (const auto &name: touched) {
+        std::string content = readFile(_directory + "/" + name);
+        if (remember(name, content)) {
+            changed.push_back({name, std::move(content)});
+        }
+    }
+    return changed;
+}
+
+MtimeSignalSource::MtimeSignalSource(std::string directory, std::vector<std::string> names) :
+        _directory(std::move(directory)),
+        _names(std::move(names)) {}
+
+std::vector<SignalDocument> MtimeSignalSource::poll(std::chrono::milliseconds timeout) {
+    if (_initialized) {
+        std::this_thread::sleep_for(timeout);
+    }
+    _initialized = true;
+
+    std::vector<SignalDocument> changed;
+    for (const auto &name: _names) {
+        std::string path = _directory + "/" + name;
+        FileStamp stamp;
+        struct stat info{};
+        if (stat(path.c_str(), &info) == 0) {
+            stamp.mtimeNs = static_cast<long long>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+            stamp.size = static_cast<long long>(info.st_size);
+            stamp.inode = info.st_ino;
+        }
+
+        auto itr = _stamps.find(name);
+        if (itr != _stamps.end() && itr->second == stamp) {
+            continue;
+        }
+        _stamps[name] = stamp;
+
+        std::string content = readFile(path);
+        if (remember(name, content)) {
+            changed.push_back({name, std::move(content)});
+        }
+    }
+    return changed;
+}
+
+GsutilSignalSource::GsutilSignalSource(std::string bucket, std::vector<std::string> names, std::string gsutil) :
+        _bucket(std::move(bucket)),
+        _names(std::move(names)),
+        _gsutil(std::move(gsutil)) {}
+
+std::vector<SignalDocument> GsutilSignalSource::poll(std::chrono::milliseconds timeout) {
+    if (_initialized) {
+        std::this_thread::sleep_for(timeout);
+    }
+    _initialized = true;
+
+    // One subprocess for all objects:
+    //   gs://bucket/signal.csv:
+    //       ...
+    //       Generation:             1718000000000000
+    std::string command = _gsutil + " stat";
+    for (const auto &name: _names) {
+        command += " gs://" + _bucket + "/" + name;
+    }
+    command += " 2>/dev/null";
+
+    std::map<std::string, std::string> generations;
+    std::istringstream output(Utils::exec(command.c_str()));
+    std::string line;
+    std::string current;
+    std::string prefix = "gs://" + _bucket + "/";
+    while (std::getline(output, line)) {
+        if (line.rfind(prefix, 0) == 0 && !line.empty() && line.back() == ':') {
+            current = line.substr(prefix.size(), line.size() - prefix.size() - 1);
+            continue;
+        }
+
+        size_t key = line.find_first_not_of(" \t");
+        if (!current.empty() && key != std::string::npos && line.compare(key, 11, "Generation:") == 0) {
+            size_t value = line.find_first_not_of(" \t", key + 11);
+            generations[current] = value == std::string::npos ? "" : line.substr(value);
+        }
+    }
+
+    // gsutil itself failed (network, auth), keep what we have instead of clearing everything
+    if (generations.empty()) {
+        return {};
+    }
+
+    std::vector<SignalDocument> changed;
+    for (const auto &name: _names) {
+        std::string generation = generations.count(name) ? generations[name] : "";
+        auto itr = _generations.find(name);
+        if (itr != _generations.end() && itr->second == generation) {
+            continue;
+        }
+
+        std::string content;
+        if (!generation.empty()) {
+            std::string cat = _gsutil + " cat gs://" + _bucket + "/" + name + " 2>/dev/null";
+            int status = 0;
+            content = Utils::exec(cat.c_str(), &status);
+            // Failed download, keep the previous content and generation so the next poll retries
+            if (status != 0) {
+                Log::error("gsutil cat gs://", _bucket, "/", name, " failed with exit status ", status);
+                continue;
+            }
+        }
+        _generations[name] = generation;
+        if (remember(name, content)) {
+            changed.push_back({name, std::move(content)});
+        }
+    }
+    return changed;
+}
+
+std::unique_ptr<SignalSource> createSignalSource(const std::map<std::string, std::string> &env,
+                                                 const std::vector<std::string> &names) {
+    std::string backend = envOr(env, "SIGNAL_SOURCE", "gcs");
+    if (backend == "inotify") {
+        return std::make_unique<InotifySignalSource>(envOr(env, "SIGNAL_DIR", "."), names);
+    }
+    if (backend == "mtime") {
+        return std::make_unique<MtimeSignalSource>(envOr(env, "SIGNAL_DIR", "."), names);
+    }
+    return std::make_unique<GsutilSignalSource>(envOr(env, "SIGNAL_BUCKET", "caps-signal-bucket"), names);
+}
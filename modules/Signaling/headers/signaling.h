@@ -1,12 +1,38 @@
 #ifndef SIGNALING_H
 #define SIGNALING_H
 
+#include <chrono>
 #include <string>
 #include <vector>
 #include "../../Order/models/APIParams/APIParams.h"
+#include "../../SignalSource/headers/signalsource.h"
+#include "../../Blackout/headers/blackout.h"
+#include "../../Strategy/headers/strategy.h"
+#include "signalreader.h"
+
+#define SIGNAL_FILE "signal.csv"
+#define NEWS_FILE "news.csv"
+#define DEACTIVATE_FILE "deactivate.csv"
 
 namespace Signaling {
-    [[noreturn]] void init(const APIParams &apiParams);
+    struct Config {
+        std::chrono::milliseconds pollInterval{1000};
+        BlackoutPaddings blackoutPaddings;
+        // Traded symbols, each gets its own strategy state and an equal share of the balance
+        std::vector<std::string> symbols{"BTCUSDT"};
+        // Symbols are spread round-robin over this many independent worker pools
+        size_t shards = 4;
+        // Workers running the queue callbacks (REST calls) of one shard
+        size_t executorThreads = 2;
+        // How long the entry orders of a signal are held back, from the first account that
+        // is ready to send, for the other accounts, so they leave together
+        std::chrono::milliseconds dispatchWait{250};
+        // Prices and delays of the strategy, shared with the backtest
+        Strategy::Params strategy;
+    };
+
+    // Every signal is executed on each account, sized off that account's own balance
+    [[noreturn]] void init(const std::vector<APIParams> &accounts, SignalSource &signalSource, const Config &config);
 }
 
 #endif // SIGNALING_H
@@ -0,0 +1,64 @@
+#ifndef SIGNAL_READER_H
+#define SIGNAL_READER_H
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Signaling {
+    // One row of signal.csv
+    struct SignalRow {
+        std::string symbol;
+        // Empty when the row has none or it is not "YYYY-mm-dd HH:MM:SS"
+        std::string datetime;
+        int signal = 0;
+        double lag = 0.0;
+        std::chrono::system_clock::time_point time;
+    };
+
+    // Reads signal.csv as it grows. The header is resolved to column indices once, rows are
+    // split in place (string_views, std::from_chars) and only the rows behind the previous
+    // call are parsed. Content that does not continue what was read before (first call,
+    // rewritten or truncated file, another header) is read from the top, and of that only
+    // the last row of every symbol counts: history is not traded again. With `everyRow`
+    // (backtests) a restart returns the whole history too.
+    class SignalReader {
+    public:
+        // Rows without a `symbol` column belong to `defaultSymbol`
+        explicit SignalReader(std::string defaultSymbol, bool everyRow = false);
+
+        // Rows added since the previous call, oldest first. After a restart the last row
+        // of every symbol, in order of first appearance (unless `everyRow`). A last row
+        // without '\n' is left for the next call unless the content is `complete`.
+        std::vector<SignalRow> consume(std::string_view csv, bool complete = false);
+
+        bool restarted() const { return _restarted; }
+
+    private:
+        enum Column {
+            DATETIME,
+            SYMBOL,
+            SIGNAL,
+            LAG,
+            COLUMNS
+        };
+
+        void readHeader(std::string_view header);
+
+        std::string _defaultSymbol;
+        bool _everyRow;
+        std::string _header;
+        std::array<int, COLUMNS> _columns{};
+        // End of the last row read, and that row, to recognize the same file grown
+        size_t _offset = 0;
+        std::string _lastLine;
+        bool _restarted = false;
+    };
+
+    // Last row of every symbol of a whole signal.csv, in order of first appearance
+    std::vector<SignalRow> readSignals(const std::string &csv, const std::string &defaultSymbol);
+}
+
+#endif // SIGNAL_READER_H
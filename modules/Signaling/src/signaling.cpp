@@ -3,431 +3,724 @@
 #include "margin.h"
 #include "utils.h"
 #include "news.h"
+#include "userdata.h"
+#include "exchangeinfo.h"
+#include "log.h"
+#include "metrics.h"
+#include "oms.h"
+#include "clocksync.h"
+#include "strategy.h"
 #include "../../TimedEventQueue/headers/SignalQueue.h"
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#define RECONCILE_INTERVAL 30 // REST fill check while the user data stream is connected
+#define BRACKET_ATTEMPTS 3
+
+
+// Entry order the TP & SL brackets are waiting for. Written by the signal queue, read by
+// the tpSl queue and the user data stream thread. Its state lives in the account's book.
+struct TrackedOrder {
+    std::mutex mutex;
+    long long orderId = 0;
+    std::string entrySide;
+    Qty origQty;
+    std::atomic<bool> monitorLock = true;
+};
+
+// Worker pool and timer queues shared by the symbols assigned to one shard. Each queue is a
+// strand on the pool: its own callbacks stay in order while a slow REST call in one queue
+// does not hold up timers of the other, nor anything on the other shards.
+struct Shard {
+    Shard(const std::string &account, size_t index, size_t threads) :
+            executor(std::make_shared<ThreadPoolExecutor>(std::max<size_t>(threads, 1))),
+            signalStrand(std::make_shared<Strand>(executor)),
+            signalQueue(signalStrand),
+            tpSlQueue(std::make_shared<Strand>(executor)) {
+        std::string shard = ",account=\"" + account + "\",shard=\"" + std::to_string(index) + "\"";
+        signalQueue.setLagObserver([&lag = Metrics::histogram("executioner_timer_lag_seconds", "queue=\"signal\"" + shard)](auto ns) {
+            lag.record(ns);
+        });
+        tpSlQueue.setLagObserver([&lag = Metrics::histogram("executioner_timer_lag_seconds", "queue=\"tpsl\"" + shard)](auto ns) {
+            lag.record(ns);
+        });
+    }
+
+    std::shared_ptr<ThreadPoolExecutor> executor;
+    // Runs signalQueue's callbacks, work posted here stays in order with them
+    std::shared_ptr<Strand> signalStrand;
+    SignalQueue signalQueue;
+    SignalQueue tpSlQueue;
+};
+
+// Strategy state of one symbol on one account, only ever touched through its own shard's
+// queues, the account's user data stream and the poll loop
+struct SymbolState {
+    SymbolState(std::string symbol, Shard &shard, Oms::Book &book, const Strategy::Params &params, double allocation) :
+            symbol(std::move(symbol)), shard(shard), book(book), params(params), allocation(allocation) {}
+
+    const std::string symbol;
+    Shard &shard;
+    Oms::Book &book;
+    const Strategy::Params &params;
+    // Share of the account's USDT balance an entry order may use
+    const double allocation;
+    TrackedOrder tracked;
+    // Poll loop only
+    TIMESTAMP lastReconcile = TIME::now();
+    TIMESTAMP lastResync = TIME::now() - std::chrono::hours(1);
+};
+
+// Everything one set of credentials trades with: its own worker pools (and through
+// apiParams its own connections and order budget), strategy state and user data stream.
+struct Account {
+    Account(const APIParams &params, const std::vector<std::string> &symbols, const Strategy::Params &strategy,
+            size_t shardCount, size_t threads) :
+            apiParams(params),
+            userDataStream(apiParams, UserData::defaultStreamUrl(apiParams.useTestnet)) {
+        for (size_t i = 0; i < shardCount; ++i) {
+            shards.emplace_back(apiParams.name, i, threads);
+        }
+        // Symbols are dealt to the shards round-robin and share the balance evenly
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            SymbolState &state = states.emplace_back(symbols[i], shards[i % shardCount], book, strategy, 1.0 / static_cast<double>(symbols.size()));
+            stateOf[state.symbol] = &state;
+        }
+    }
+
+    const APIParams apiParams;
+    Oms::Book book;
+    std::deque<Shard> shards;
+    std::deque<SymbolState> states;
+    std::unordered_map<std::string, SymbolState *> stateOf;
+    UserData::UserDataStream userDataStream;
+};
+
+// Latest signal.csv row of one symbol, shared by all accounts. Poll loop only.
+struct SymbolSignal {
+    Signaling::SignalRow latest;
+    TIMESTAMP read = TIME::now();
+    std::string prevDatetime;
+    // Rows read but not looked at yet, oldest first, with the time they were read
+    std::deque<std::pair<Signaling::SignalRow, TIMESTAMP>> pending;
+
+    // Moves the next pending row into `latest`, or all of them when only the newest counts
+    void advance(bool newestOnly) {
+        while (!pending.empty()) {
+            auto &[row, readAt] = pending.front();
+            if (row.datetime != latest.datetime) {
+                read = readAt;
+            }
+            latest = std::move(row);
+            pending.pop_front();
+            if (!newestOnly) {
+                break;
+            }
+        }
+    }
+};
+
+// One signal going out on every account. The accounts run their pre-trade checks in
+// parallel, then their entry orders leave together instead of in the order the checks
+// happened to finish: each ready account parks its send, and the sends are posted back onto
+// their accounts' signal strands once every account is ready or gave up, or `timeout` after
+// the first one got ready. No worker waits in between. The spread between the first and the
+// last request is recorded as executioner_fanout_skew_seconds.
+class Dispatch : public std::enable_shared_from_this<Dispatch> {
+public:
+    Dispatch(std::string symbol, size_t accounts) :
+            _symbol(std::move(symbol)), _turns(accounts, Turn::Preparing), _preparing(accounts) {}
+
+    // `account` is ready, `send` runs on `shard`'s signal strand once the others are
+    void ready(size_t account, Shard &shard, std::chrono::milliseconds timeout, std::function<void()> send) {
+        bool arm = false;
+        {
+            std::scoped_lock lock(_mutex);
+            _parked.push_back({shard.signalStrand, std::move(send)});
+            if (_turns[account] == Turn::Preparing) {
+                _turns[account] = Turn::Ready;
+                --_preparing;
+            }
+            if (_released || _preparing == 0) {
+                release();
+            } else if (!_armed) {
+                _armed = arm = true;
+            }
+        }
+        if (arm) {
+            shard.signalQueue.addEvent(TIME::now() + timeout, "Dispatch deadline " + _symbol, [weak = weak_from_this()]() {
+                if (auto dispatch = weak.lock()) {
+                    std::scoped_lock lock(dispatch->_mutex);
+                    dispatch->_released = true;
+                    dispatch->release();
+                }
+            });
+        }
+    }
 
-#define EXEC_DELAY 1 // Entry Time offset
-#define CANCEL_DELAY 3301 // Open Order Elimination
-#define MONITOR_DELAY 1
-#define CALC_PRICE_PERCENTAGE (-0.002) // Entry Gap needs to be minus
-#define TP_PRICE_PERCENTAGE 0.014
-#define SL_PRICE_PERCENTAGE (-0.01)
-
-#define TICK_SIZE 0.1
-
-bool prepareForOrder(const APIParams &apiParams) {
-    std::string notional;
-    size_t array_length;
-
-    auto positions_response = Margin::getPositions(apiParams, "BTCUSDT");
-    if (positions_response.is_array() && positions_response[0].contains("notional")) {
-        notional = positions_response[0]["notional"].get<std::string>();
-    } else {
-        std::cerr << "Notional not found in the response" << std::endl;
-        return false;
+    // Right before the order request of `account` goes out
+    void sending(size_t account) {
+        std::scoped_lock lock(_mutex);
+        auto now = TIME::now();
+        _first = _sent == 0 ? now : std::min(_first, now);
+        _last = _sent == 0 ? now : std::max(_last, now);
+        ++_sent;
+        finish(account);
     }
 
-    auto open_orders_response = Margin::getOpenOrders(apiParams, "BTCUSDT");
-    if (open_orders_response.is_array()) {
-        array_length = open_orders_response.size();
-    } else {
-        std::cerr << "Unexpected response format: " << open_orders_response.dump(4) << std::endl;
-        return false;
+    // `account` sends nothing for this signal, safe to call more than once
+    void leave(size_t account) {
+        std::scoped_lock lock(_mutex);
+        finish(account);
     }
 
-    if (notional != "0") {
-        std::cerr << "Notional is not 0. skipping to the next signal" << std::endl;
-        return false;
+private:
+    enum class Turn {
+        Preparing,
+        Ready,
+        Done
+    };
+
+    struct Parked {
+        std::shared_ptr<Strand> strand;
+        std::function<void()> send;
+    };
+
+    // Posts every parked send, the lock is held
+    void release() {
+        for (auto &parked: _parked) {
+            parked.strand->post([symbol = _symbol, send = std::move(parked.send)]() {
+                try {
+                    send();
+                } catch (const std::exception &e) {
+                    Log::error(symbol, ": entry send failed: ", e.what());
+                }
+            });
+        }
+        _parked.clear();
     }
 
-    if (array_length >= 1) {
-        for (const auto& order : open_orders_response) {
-            if (order.contains("origType") && order["origType"] == "LIMIT") {
-                return false;
+    void finish(size_t account) {
+        if (_turns[account] == Turn::Done) {
+            return;
+        }
+        if (_turns[account] == Turn::Preparing) {
+            --_preparing;
+            if (_preparing == 0) {
+                release();
             }
         }
+        _turns[account] = Turn::Done;
+        if (++_done == _turns.size() && _sent > 1) {
+            Metrics::histogram("executioner_fanout_skew_seconds", "symbol=\"" + _symbol + "\"").record(_last - _first);
+            Log::info(_symbol, ": entry sent on ", _sent, " accounts within ",
+                      std::chrono::duration_cast<std::chrono::microseconds>(_last - _first).count(), "us");
+        }
+    }
 
-        auto response = OrderService::cancelAllOpenOrders(apiParams, "BTCUSDT");
-        std::cout << "Cancel All Orders Response: " << response.dump(4) << std::endl;
+    const std::string _symbol;
+    std::mutex _mutex;
+    std::vector<Turn> _turns;
+    size_t _preparing;
+    std::vector<Parked> _parked;
+    // The deadline timer is set, and has fired
+    bool _armed = false;
+    bool _released = false;
+    size_t _done = 0;
+    size_t _sent = 0;
+    TIMESTAMP _first;
+    TIMESTAMP _last;
+};
+
+// Where one account stands in a Dispatch, leaves it on every path that sends nothing
+struct DispatchTurn {
+    DispatchTurn(std::shared_ptr<Dispatch> dispatch, size_t account) :
+            dispatch(std::move(dispatch)), account(account) {}
+
+    DispatchTurn(DispatchTurn &&) = default;
+
+    std::shared_ptr<Dispatch> dispatch;
+    size_t account;
+
+    ~DispatchTurn() {
+        if (dispatch) {
+            dispatch->leave(account);
+        }
+    }
+};
+
+// Strategy::Exchange of one account. Positions and open orders are answered by the book
+// while it is trusted, otherwise positionRisk and openOrders are fetched, which also brings
+// the book up to date.
+class LiveExchange : public Strategy::Exchange {
+public:
+    LiveExchange(const APIParams &apiParams, Oms::Book &book) : _apiParams(apiParams), _book(book) {}
+
+    std::optional<double> position(const std::string &symbol) override {
+        auto position = _book.position(symbol);
+        if (!position && sync(symbol)) {
+            position = _book.position(symbol);
+        }
+        return position ? std::optional<double>(position->amount) : std::nullopt;
     }
 
-    return true;
-}
+    std::optional<std::vector<Strategy::OpenOrder>> openOrders(const std::string &symbol) override {
+        auto orders = _book.openOrders(symbol);
+        if (!orders && sync(symbol)) {
+            orders = _book.openOrders(symbol);
+        }
+        if (!orders) {
+            return std::nullopt;
+        }
+        std::vector<Strategy::OpenOrder> open;
+        for (const auto &order: *orders) {
+            open.push_back({order.orderId, order.type});
+        }
+        return open;
+    }
 
-double roundToTickSize(double price, double tick_size) {
-    return std::round(price / tick_size) * tick_size;
-}
+    void cancelAll(const std::string &symbol) override {
+        auto response = OrderService::cancelAllOpenOrders(_apiParams, symbol);
+        Log::info(_apiParams.name, "/", symbol, ": cancel all orders: ", response.value("code", 0), " ", response.value("msg", ""));
+    }
 
-void placeTpAndSlOrders(const APIParams &apiParams, const std::string &symbol, const std::string &side, double orig_qty) {
-    int signal = side == "SELL" ? 1:-1;
-    auto price = Margin::getPrice(apiParams, "BTCUSDT");
-    double newTpPrice = roundToTickSize(price * (1 + (TP_PRICE_PERCENTAGE * signal)), TICK_SIZE);
-    double newSlPrice = roundToTickSize(price * (1 + (SL_PRICE_PERCENTAGE * signal)), TICK_SIZE);
-
-    TriggerOrderInput tpOrder(
-            symbol,
-            side,
-            "TAKE_PROFIT_MARKET",
-            "GTC",
-            orig_qty,
-            newTpPrice,
-            newTpPrice,
-            true
-    );
-    auto tp_response = OrderService::createTriggerOrder(apiParams, tpOrder);
-    std::cout << "TP Order Response: " << tp_response.dump(4) << std::endl;
-
-    TriggerOrderInput slOrder(
-            symbol,
-            side,
-            "STOP_MARKET",
-            "GTC",
-            orig_qty,
-            newSlPrice,
-            newSlPrice,
-            true
-    );
-    auto sl_response = OrderService::createTriggerOrder(apiParams, slOrder);
-    std::cout << "SL Order Response: " << sl_response.dump(4) << std::endl;
-}
+    Decode::OrderAck placeOrder(const OrderInput &order) override {
+        return OrderService::createOrder(_apiParams, order);
+    }
 
-bool isOrderFilled(const APIParams &apiParams) {
-    std::string notional;
+    // Both legs go out in one request so the position is protected after one round trip.
+    // Legs known not to exist are sent again on their own, the accepted ones are kept and
+    // ones whose outcome stayed unknown after the lookup are not sent again.
+    size_t placeBrackets(const std::vector<TriggerOrderInput> &brackets) override {
+        std::vector<TriggerOrderInput> legs = brackets;
+        for (int attempt = 1; attempt <= BRACKET_ATTEMPTS && !legs.empty(); ++attempt) {
+            auto results = OrderService::createBatchOrders(_apiParams, legs);
+
+            std::vector<TriggerOrderInput> failed;
+            for (size_t i = 0; i < legs.size(); ++i) {
+                if (results[i].ok()) {
+                    Log::info(_apiParams.name, "/", legs[i].symbol, ": ", legs[i].type, " order ", results[i].response.value("orderId", 0L), " placed at ", legs[i].stopPrice);
+                } else if (results[i].unknown) {
+                    Log::error(_apiParams.name, "/", legs[i].symbol, ": ", legs[i].type, " order ", legs[i].clientOrderId, " outcome unknown, check the open orders");
+                } else {
+                    Log::error(_apiParams.name, "/", legs[i].symbol, ": ", legs[i].type, " order failed (", results[i].code, "): ", results[i].msg);
+                    failed.push_back(legs[i]);
+                }
+            }
+            legs = std::move(failed);
+        }
+
+        if (!legs.empty()) {
+            Log::error(_apiParams.name, "/", legs.front().symbol, ": giving up on ", legs.size(), " bracket order(s) after ", BRACKET_ATTEMPTS, " attempts");
+        }
+        return brackets.size() - legs.size();
+    }
+
+private:
+    bool sync(const std::string &symbol) {
+        if (!_book.reconcile(_apiParams, symbol)) {
+            Log::error(_apiParams.name, "/", symbol, ": positions or open orders unavailable");
+            return false;
+        }
+        return true;
+    }
 
-    auto positions_response = Margin::getPositions(apiParams, "BTCUSDT");
-    if (positions_response.is_array() && positions_response[0].contains("notional")) {
-        notional = positions_response[0]["notional"].get<std::string>();
-    } else {
-        std::cerr << "Notional not found in the response" << std::endl;
-        return false;
+    const APIParams &_apiParams;
+    Oms::Book &_book;
+};
+
+void placeTpAndSlOrders(const APIParams &apiParams, SymbolState &state, const std::string &entrySide, Qty orig_qty, long long entryOrderId) {
+    const std::string &symbol = state.symbol;
+    // The position is open, send the brackets even if the rules are unknown and let the
+    // exchange judge the prices
+    auto filters = ExchangeInfo::filters(apiParams, symbol);
+    if (!filters) {
+        Log::warn("No exchange filters for ", symbol, ", brackets are sent unrounded");
+        filters = Decode::SymbolFilters{};
     }
 
-    return notional != "0";
+    // Without a quote the brackets are placed around the entry price of the position
+    auto price = Margin::getPrice(apiParams, symbol);
+    if (!price) {
+        auto position = state.book.position(symbol);
+        if (!position || position->entryPrice <= 0) {
+            Log::error(apiParams.name, "/", symbol, ": price unavailable, brackets for order ", entryOrderId, " not placed");
+            return;
+        }
+        price = position->entryPrice;
+    }
+    auto legs = Strategy::brackets(state.params, symbol, entrySide, orig_qty, *price, *filters);
+    // Tied to the entry, a leg that did get through is refused as a duplicate when resent
+    legs[0].clientOrderId = OrderService::clientOrderId(apiParams.name, symbol, std::to_string(entryOrderId), "tp");
+    legs[1].clientOrderId = OrderService::clientOrderId(apiParams.name, symbol, std::to_string(entryOrderId), "sl");
+
+    LiveExchange exchange(apiParams, state.book);
+    exchange.placeBrackets(legs);
+}
+
+// Places the brackets for the tracked order exactly once, no matter whether the stream
+// or the REST fallback noticed the fill first.
+void placeBracketsOnce(const APIParams &apiParams, SymbolState &state) {
+    TrackedOrder &tracked = state.tracked;
+    bool expected = false;
+    if (!tracked.monitorLock.compare_exchange_strong(expected, true)) {
+        return;
+    }
+
+    std::string side;
+    Qty orig_qty;
+    long long entry_order_id;
+    {
+        std::scoped_lock lock(tracked.mutex);
+        side = tracked.entrySide;
+        orig_qty = tracked.origQty;
+        entry_order_id = tracked.orderId;
+    }
+    placeTpAndSlOrders(apiParams, state, side, orig_qty, entry_order_id);
 }
 
-void monitorOrderAndPlaceTpSl(SignalQueue &signalQueue,
-                              const APIParams &apiParams,
-                              const std::string &symbol,
-                              const std::string &side,
-                              std::string &order_id,
-                              double &orig_qty,
-                              bool &monitor_lock) {
-    std::cout << "Monitor Order Status will run in 1 secs.\n";
-    signalQueue.addEvent(
-            TIME::now() + std::chrono::seconds(MONITOR_DELAY),
-            "Monitor Order Status",
-            [&apiParams, &symbol, &side, &order_id, &orig_qty, &monitor_lock]() {
-                if (monitor_lock) {
-                    std::cout << "Monitoring is locked, waiting for the order to be executed.\n";
+void monitorOrderAndPlaceTpSl(const APIParams &apiParams, SymbolState &state) {
+    Log::info(apiParams.name, "/", state.symbol, ": monitor order status will run in ", state.params.monitorDelay.count(), " secs.");
+    state.shard.tpSlQueue.addEvent(
+            TIME::now() + state.params.monitorDelay,
+            "Monitor Order Status " + state.symbol,
+            [&apiParams, &state]() {
+                TrackedOrder &tracked = state.tracked;
+                if (tracked.monitorLock) {
+                    Log::info(apiParams.name, "/", state.symbol, ": monitoring is locked, waiting for the order to be executed.");
                     return;
                 }
 
-                std::string order_status = "none";
-                auto response = OrderService::getOrderDetails(apiParams, "BTCUSDT", order_id);
-                if (response["status"].is_string()) {
-                    order_status = response["status"].get<std::string>();
+                long long order_id;
+                {
+                    std::scoped_lock lock(tracked.mutex);
+                    order_id = tracked.orderId;
                 }
-                if (order_status == "CANCELED") {
-                    std::cout << "XXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXXX\n" << "Order Is CANCELED Aborting TP & SL\n";
-                    monitor_lock = true;
+
+                // The book knows while the stream is up, otherwise (or if it forgot the
+                // order) the exchange is asked and the answer goes into the book
+                auto order = state.book.trusted(state.symbol) ? state.book.order(order_id) : std::nullopt;
+                if (!order) {
+                    state.book.onAck(OrderService::getOrderDetails(apiParams, state.symbol, std::to_string(order_id), "", Http::Priority::Poll));
+                    order = state.book.order(order_id);
+                }
+                if (!order) {
+                    Log::warn(apiParams.name, "/", state.symbol, ": order ", order_id, " status unknown, will check again later.");
                     return;
                 }
 
-                if (isOrderFilled(apiParams)) {
-                    std::cout << "$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$\n" << "Order Is FILLED Adding TP & SL\n";
-                    monitor_lock = true;
-                    placeTpAndSlOrders(apiParams, symbol, side, orig_qty);
+                if (order->executedQty > Qty{}) {
+                    Log::info(apiParams.name, "/", state.symbol, ": order is ", Oms::stateName(order->state), ", adding TP & SL");
+                    placeBracketsOnce(apiParams, state);
+                } else if (!Oms::isOpen(order->state)) {
+                    Log::warn(apiParams.name, "/", state.symbol, ": order is ", Oms::stateName(order->state), ", aborting TP & SL");
+                    tracked.monitorLock = true;
                 } else {
-                    std::cout << "Not filled yet, will check again later.\n";
+                    Log::info(apiParams.name, "/", state.symbol, ": not filled yet, will check again later.");
                 }
             }
     );
 }
 
+// Reacts to ORDER_TRADE_UPDATE events of the tracked entry order, after the book has taken
+// them in. The brackets go out as soon as the first fill is reported instead of waiting
+// for the next REST check.
+void handleOrderUpdate(const UserData::OrderUpdate &update,
+                       const APIParams &apiParams,
+                       SymbolState &state) {
+    TrackedOrder &tracked = state.tracked;
+    {
+        std::scoped_lock lock(tracked.mutex);
+        // Fills that beat our own ack are picked up from the book once the ack is in
+        if (update.orderId != tracked.orderId) {
+            return;
+        }
+    }
+
+    if (tracked.monitorLock) {
+        return;
+    }
+
+    if (update.status == "FILLED" || update.status == "PARTIALLY_FILLED") {
+        Log::info(apiParams.name, "/", state.symbol, ": order fill received, adding TP & SL");
+        state.shard.tpSlQueue.addEvent(TIME::now(), "Fill Received " + state.symbol, [&apiParams, &state]() {
+            placeBracketsOnce(apiParams, state);
+        });
+    } else if (update.status == "CANCELED" || update.status == "EXPIRED" || update.status == "REJECTED") {
+        Log::warn(apiParams.name, "/", state.symbol, ": order is ", update.status, ", aborting TP & SL");
+        tracked.monitorLock = true;
+    }
+}
+
 void cancelWithDelay(int signal,
                      const APIParams &apiParams,
-                     SignalQueue &signalQueue,
-                     SignalQueue &tpSlQueue,
-                     bool &lock
+                     SymbolState &state
                      ) {
-    std::cout << "Signal #" + std::to_string(signal) + " Added to queue to be canceled" << std::endl;
-    signalQueue.addEvent(
-            TIME::now() + std::chrono::seconds(CANCEL_DELAY),
-            "Trying to cancel the order " + std::to_string(signal),
-            [&apiParams, &tpSlQueue, &lock]() {
-                std::string notional;
-                auto positions_response = Margin::getPositions(apiParams, "BTCUSDT");
-                if (positions_response.is_array() && positions_response[0].contains("notional")) {
-                    notional = positions_response[0]["notional"];
-                } else {
-                    std::cerr << "Notional not found in the response" << std::endl;
-                    return;
+    Log::info(apiParams.name, "/", state.symbol, ": signal #", signal, " added to queue to be canceled");
+    state.shard.signalQueue.addEvent(
+            TIME::now() + state.params.cancelDelay,
+            "Trying to cancel the order " + state.symbol + " " + std::to_string(signal),
+            [&apiParams, &state]() {
+                LiveExchange exchange(apiParams, state.book);
+                auto cleanup = Strategy::cancelLeftovers(exchange, state.symbol);
+                Log::info(apiParams.name, "/", state.symbol, ": ", Strategy::cleanupName(cleanup));
+
+                if (cleanup == Strategy::Cleanup::Canceled) {
+                    state.tracked.monitorLock = true;
                 }
+            }
+    );
+}
 
-                if (notional != "0") {
-                    std::cout << "Canceling aborted due to open position\n";
-                    return;
-                }
+// Entry order of a signal, sent once every account is ready (see Dispatch)
+void sendEntry(const APIParams &apiParams, const std::string &side, SymbolState &state, TIMESTAMP received, const OrderInput &order) {
+    const std::string &symbol = state.symbol;
+    TrackedOrder &tracked = state.tracked;
+    LiveExchange exchange(apiParams, state.book);
+    auto order_response = exchange.placeOrder(order);
+    // From the moment the row was read, the execution delay included
+    Metrics::histogram("executioner_signal_to_ack_seconds",
+                       "symbol=\"" + symbol + (order_response.ok() ? "\",outcome=\"ack\"" : "\",outcome=\"rejected\""))
+            .record(TIME::now() - received);
+    if (order_response.error) {
+        Log::error(apiParams.name, "/", symbol, ": order rejected (", order_response.error->code, "): ", order_response.error->msg);
+    }
 
-                std::cout << "\nCanceling:\n";
-                auto open_orders_response = Margin::getOpenOrders(apiParams, "BTCUSDT");
-                if (open_orders_response.is_array() && !open_orders_response.empty()) {
-                    auto response = OrderService::cancelAllOpenOrders(apiParams, "BTCUSDT");
-                    std::cout << "Cancel All Orders Response: " << response.dump(4) << std::endl;
+    if (order_response.ok()) {
+        state.book.onAck(order_response);
+        Log::info(apiParams.name, "/", symbol, ": order ", order_response.orderId, " ", order_response.status, " ",
+                  order_response.executedQty, "/", order_response.origQty, " @ ", order_response.price);
 
-                    lock = true;
-                } else {
-                    std::cerr << "Unexpected response format: " << open_orders_response.dump(4) << std::endl;
-                }
-            }
-    );
+        {
+            std::scoped_lock lock(tracked.mutex);
+            tracked.orderId = order_response.orderId;
+            tracked.origQty = order_response.origQty;
+            tracked.entrySide = side;
+        }
+        tracked.monitorLock = false;
+
+        // A fill the stream delivered before the ack (or while the order was
+        // being tracked) was only recorded in the book
+        auto known = state.book.order(order_response.orderId);
+        if (known && known->executedQty > Qty{}) {
+            state.shard.tpSlQueue.addEvent(TIME::now(), "Fill Received " + symbol, [&apiParams, &state]() {
+                placeBracketsOnce(apiParams, state);
+            });
+        }
+    }
 }
 
 void processSignal(int signal,
+                   const std::string &signalTime,
                    const APIParams &apiParams,
-                   SignalQueue &signalQueue,
                    const std::string &side,
-                   std::string &last_order_id,
-                   double &last_orig_qty,
-                   bool &monitor_lock
+                   SymbolState &state,
+                   TIMESTAMP received,
+                   TIMESTAMP executeAt,
+                   DispatchTurn turn,
+                   std::chrono::milliseconds dispatchWait
 ) {
-    std::cout << "Signaling received: " << side << std::endl;
-    std::cout << "Signal " << signal << " is going to be executed in " + std::to_string(EXEC_DELAY) + " seconds"
-              << std::endl;
-
-    signalQueue.addEvent(
-            TIME::now() + std::chrono::seconds(EXEC_DELAY),
-            "Signal is executed.",
-            [&apiParams, signal, side, &last_order_id, &last_orig_qty, &monitor_lock]() {
-                bool validConditions = prepareForOrder(apiParams);
-                if (!validConditions) {
+    Log::info(apiParams.name, "/", state.symbol, ": signaling received: ", side);
+    Log::info(apiParams.name, "/", state.symbol, ": signal ", signal, " is going to be executed in ", state.params.execDelay.count(), " seconds");
+
+    state.shard.signalQueue.addEvent(
+            executeAt,
+            "Signal is executed " + state.symbol,
+            [&apiParams, signal, signalTime, side, &state, received, turn = std::make_shared<DispatchTurn>(std::move(turn)), dispatchWait]() {
+                const std::string &symbol = state.symbol;
+
+                // Checks that can skip the signal come first, a skipped signal spends no
+                // request weight on price and balance
+                LiveExchange exchange(apiParams, state.book);
+                auto readiness = Strategy::prepareEntry(exchange, symbol);
+                if (readiness != Strategy::Readiness::Ready) {
+                    Log::warn(apiParams.name, "/", symbol, ": ", Strategy::readinessName(readiness), ", skipping the signal");
                     return;
                 }
 
-                auto price = Margin::getPrice(apiParams, "BTCUSDT");
-                auto balance = Margin::getBalance(apiParams, "USDT");
-
-                double orig_price = price * (1 + (CALC_PRICE_PERCENTAGE * signal));
-                double calculated_price = roundToTickSize(orig_price, TICK_SIZE);
-                double quantity = std::floor((balance / calculated_price) * 1000) / 1000;
-
-                OrderInput order(
-                    "BTCUSDT",
-                    side,
-                    "LIMIT",
-                    "GTC",
-                    quantity,
-                    calculated_price
-                );
-
-                auto order_response = OrderService::createOrder(apiParams, order);
-                std::cout << "Order Response: " << order_response.dump(4) << std::endl;
-
-                if (order_response.contains("orderId")) {
-                    double orig_qty = 0.0;
-                    std::string orderId;
-
-                    if (order_response["origQty"].is_string()) {
-                        orig_qty = std::stod(order_response["origQty"].get<std::string>());
-                    } else if (order_response["origQty"].is_number()) {
-                        orig_qty = order_response["origQty"].get<double>();
-                    }
-
-                    if (order_response["orderId"].is_string()) {
-                        orderId = order_response["orderId"].get<std::string>();
-                    } else if (order_response["orderId"].is_number()) {
-                        orderId = std::to_string(order_response["orderId"].get<long>());
-                    }
-
-                    std::cout << "Order after creation: " << orderId << std::endl;
-                    last_order_id = orderId;
-                    last_orig_qty = orig_qty;
-                    monitor_lock = false;
-
-
-                    auto response = OrderService::getOrderDetails(apiParams, "BTCUSDT", orderId);
-                    std::cout << "------------------\nOrders Details Response:\n" << response.dump(4) << std::endl << std::endl;
+                auto filters = ExchangeInfo::filters(apiParams, symbol);
+                if (!filters) {
+                    Log::error("No exchange filters for ", symbol, ", skipping the signal");
+                    return;
                 }
-            }
-    );
-}
 
-std::pair<std::chrono::system_clock::time_point, std::chrono::system_clock::time_point> fetchDeactivateDateRange() {
-    std::string output = Utils::exec("../run_gsutil_deactivate.sh");
-    std::istringstream iss(output);
-    std::string line;
-    std::unordered_map<std::string, size_t> headerIndex;
-    std::string start_str, end_str;
-
-    // Read headers
-    if (std::getline(iss, line)) {
-        std::istringstream headerStream(line);
-        std::string header;
-        size_t index = 0;
-        while (std::getline(headerStream, header, ',')) {
-            headerIndex[header] = index++;
-        }
-    }
+                // Price and balance do not depend on each other, both are in flight at once
+                auto price_future = Margin::getPriceAsync(apiParams, symbol);
+                auto balance_future = Margin::getBalanceAsync(apiParams, "USDT");
+                auto price = price_future.get();
+                auto balance = balance_future.get();
+                if (!price || !balance) {
+                    Log::error(apiParams.name, "/", symbol, ": ", !price ? "price" : "balance", " unavailable, skipping the signal");
+                    return;
+                }
 
-    // Read the data line
-    if (std::getline(iss, line)) {
-        std::istringstream lineStream(line);
-        std::vector<std::string> columns;
-        std::string column;
-        while (std::getline(lineStream, column, ',')) {
-            columns.push_back(column);
-        }
+                std::string violation;
+                auto order = Strategy::entryOrder(state.params, symbol, signal, *price, *balance * state.allocation, *filters, &violation);
+                if (!order) {
+                    Log::error(apiParams.name, "/", symbol, ": order not sent: ", violation);
+                    return;
+                }
+                // Resends of this signal's entry are recognised by the exchange
+                order->clientOrderId = OrderService::clientOrderId(apiParams.name, symbol, signalTime, "entry");
 
-        if (!columns.empty()) {
-            if (headerIndex.find("start") != headerIndex.end()) {
-                start_str = columns[headerIndex["start"]];
+                turn->dispatch->ready(turn->account, state.shard, dispatchWait, [&apiParams, side, &state, received, turn, order = std::move(*order)]() {
+                    turn->dispatch->sending(turn->account);
+                    sendEntry(apiParams, side, state, received, order);
+                });
             }
-            if (headerIndex.find("end") != headerIndex.end()) {
-                end_str = columns[headerIndex["end"]];
-            }
-        }
-    }
-
-    auto start_time = parseDateTime(start_str);
-    auto end_time = parseDateTime(end_str);
-    return {start_time, end_time};
+    );
 }
 
 namespace Signaling {
-    std::tuple<std::string, int, double, std::chrono::system_clock::time_point> readSignal() {
-        std::string output = Utils::exec("../run_gsutil.sh");
-        std::istringstream iss(output);
-        std::string line;
-        std::unordered_map<std::string, size_t> headerIndex;
-        std::string datetime, signal_str, lag_str;
-        int signal = 0;
-        double lag = 0.0;
-
-        // Read headers
-        if (std::getline(iss, line)) {
-            std::istringstream headerStream(line);
-            std::string header;
-            size_t index = 0;
-            while (std::getline(headerStream, header, ',')) {
-                headerIndex[header] = index++;
-            }
+    [[noreturn]] void init(const std::vector<APIParams> &accountParams, SignalSource &signalSource, const Config &config) {
+        std::vector<std::string> symbols = config.symbols;
+        if (symbols.empty()) {
+            symbols.emplace_back("BTCUSDT");
         }
 
-        // Read the last line
-        std::string lastLine;
-        while (std::getline(iss, line)) {
-            lastLine = line;
+        // Every account gets its own shards, a shard never serves more than one thread
+        // pool's worth of symbols and never sits idle
+        size_t shardCount = std::clamp<size_t>(config.shards, 1, symbols.size());
+        std::deque<Account> accounts;
+        for (const auto &params: accountParams) {
+            accounts.emplace_back(params, symbols, config.strategy, shardCount, config.executorThreads);
         }
-
-        // Process the last line
-        std::istringstream lineStream(lastLine);
-        std::vector<std::string> columns;
-        std::string column;
-        while (std::getline(lineStream, column, ',')) {
-            columns.push_back(column);
+        Log::info("Trading ", symbols.size(), " symbol(s) on ", accounts.size(), " account(s), ", shardCount, " shard(s) each");
+
+        // Fills are pushed by the user data streams, the REST monitor below only runs as a
+        // fallback while a stream is down and as a periodic reconciliation.
+        for (auto &account: accounts) {
+            account.userDataStream.onOrderUpdate([&account](const UserData::OrderUpdate &update) {
+                account.book.onOrderUpdate(update);
+                auto itr = account.stateOf.find(update.symbol);
+                if (itr != account.stateOf.end()) {
+                    handleOrderUpdate(update, account.apiParams, *itr->second);
+                }
+            });
+            account.userDataStream.onAccountUpdate([&account](const UserData::AccountUpdate &update) {
+                account.book.onAccountUpdate(update);
+            });
+            account.userDataStream.onConnected([&account]() {
+                // Whatever happened while the stream was down is only known to the exchange
+                account.book.markStale();
+                for (auto &state: account.states) {
+                    if (!state.tracked.monitorLock) {
+                        monitorOrderAndPlaceTpSl(account.apiParams, state);
+                    }
+                }
+            });
+            account.userDataStream.start();
         }
 
-        // this is used to be check in news range
-        std::chrono::system_clock::time_point signal_time;
-
-        if (!columns.empty()) {
-            if (headerIndex.find("datetime") != headerIndex.end()) {
-                datetime = columns[headerIndex["datetime"]];
-                signal_time = parseDateTime(datetime);
-            }
-            if (headerIndex.find("signal") != headerIndex.end()) {
-                signal_str = columns[headerIndex["signal"]];
-            }
-            if (headerIndex.find("lag") != headerIndex.end()) {
-                lag_str = columns[headerIndex["lag"]];
-            }
-
-            try {
-                signal = std::stoi(signal_str);
-            } catch (const std::invalid_argument &e) {
-                std::cerr << "Invalid signal value: " << signal_str << std::endl;
-            }
-
-            try {
-                lag = std::stod(lag_str);
-            } catch (const std::invalid_argument &e) {
-                std::cerr << "Invalid lag value: " << lag_str << std::endl;
-            }
+        // Parsed state of the CSVs, only rebuilt when the source reports a change
+        BlackoutIndex news_blackout;
+        BlackoutIndex deactivate_windows;
+        SignalReader signalReader(symbols.front());
+        std::unordered_map<std::string, SymbolSignal> signals;
+        for (const auto &symbol: symbols) {
+            signals[symbol];
         }
 
-        return {datetime, signal, lag, signal_time};
-    }
-
-    [[noreturn]] void init(const APIParams &apiParams) {
-        SignalQueue signalQueue;
-        SignalQueue tpSlQueue;
-        std::string prev_datetime;
-
-        std::string last_order_id = "none";
-        double last_orig_qty = 0;
-        bool monitor_lock = true;
-
         while (true) {
-            auto newsDateRange = fetchNewsDateRange();
-            std::time_t newsMinTime = std::chrono::system_clock::to_time_t(newsDateRange.first);
-            std::time_t newsMaxTime = std::chrono::system_clock::to_time_t(newsDateRange.second);
-            // std::cout << "News Date Range: " << std::put_time(std::localtime(&newsMinTime), "%Y-%m-%d %H:%M:%S") << " to " << std::put_time(std::localtime(&newsMaxTime), "%Y-%m-%d %H:%M:%S") << std::endl;
-            
-            if (isCurrentTimeInRange(newsDateRange)) {
-                continue;
+            // Rows still waiting for their turn are not held back by the poll interval
+            bool pending = std::any_of(signals.begin(), signals.end(), [](const auto &entry) {
+                return !entry.second.pending.empty();
+            });
+            for (auto &document: signalSource.poll(pending ? std::chrono::milliseconds(0) : config.pollInterval)) {
+                if (document.name == NEWS_FILE) {
+                    news_blackout = BlackoutIndex::fromNewsCsv(document.content, config.blackoutPaddings);
+                } else if (document.name == DEACTIVATE_FILE) {
+                    deactivate_windows = BlackoutIndex::fromDeactivateCsv(document.content, config.blackoutPaddings);
+                } else if (document.name == SIGNAL_FILE) {
+                    // Every row appended since the last poll is looked at in turn
+                    for (auto &row: signalReader.consume(document.content)) {
+                        auto itr = signals.find(row.symbol);
+                        if (itr == signals.end()) {
+                            Log::debug("Ignoring signal for untraded symbol ", row.symbol);
+                            continue;
+                        }
+                        itr->second.pending.emplace_back(std::move(row), TIME::now());
+                    }
+                }
             }
-            // std::cout << "Current datetime is not within the news date range." << std::endl;
-
-            auto deactivateDateRange = fetchDeactivateDateRange();
-            std::time_t deactivateMinTime = std::chrono::system_clock::to_time_t(deactivateDateRange.first);
-            std::time_t deactivateMaxTime = std::chrono::system_clock::to_time_t(deactivateDateRange.second);
-             // std::cout << "Deactivate Date Range: " << std::put_time(std::localtime(&deactivateMinTime), "%Y-%m-%d %H:%M:%S") << " to " << std::put_time(std::localtime(&deactivateMaxTime), "%Y-%m-%d %H:%M:%S") << std::endl;
 
-            if (isCurrentTimeInRange(deactivateDateRange)) {
+            auto now = std::chrono::system_clock::now();
+            if (news_blackout.contains(now) || deactivate_windows.contains(now)) {
+                // Like before, only the latest signal is still acted on after the blackout
+                for (auto &[symbol, signal]: signals) {
+                    signal.advance(true);
+                }
                 continue;
             }
-            // std::cout << "Current datetime is NOT within the deactivate date range." << std::endl;
 
-            auto [datetime, signal, lag, signal_time] = readSignal();
+            for (const auto &symbol: symbols) {
+                SymbolSignal &signal = signals[symbol];
+                signal.advance(false);
+                const SignalRow &row = signal.latest;
 
-            std::time_t signalTimeT = std::chrono::system_clock::to_time_t(signal_time);
-            // std::cout << "Signal Time: " << std::put_time(std::localtime(&signalTimeT), "%Y-%m-%d %H:%M:%S") << std::endl;
+                if (news_blackout.contains(row.time)) {
+                    continue;
+                }
 
-            if (isTimeInRange(newsDateRange, signal_time)) {
-                continue;
-            }
+                for (auto &account: accounts) {
+                    SymbolState &state = *account.stateOf[symbol];
+                    bool streaming = account.userDataStream.isConnected();
+                    if (!streaming) {
+                        account.book.markStale();
+                    } else if (!account.book.trusted(symbol) && TIME::now() - state.lastResync >= std::chrono::seconds(5)) {
+                        state.lastResync = TIME::now();
+                        state.shard.tpSlQueue.addEvent(TIME::now(), "Resync " + symbol, [&account, &state]() {
+                            state.book.reconcile(account.apiParams, state.symbol, Http::Priority::Poll);
+                        });
+                    }
+                    if (!state.tracked.monitorLock &&
+                        (!streaming || TIME::now() - state.lastReconcile >= std::chrono::seconds(RECONCILE_INTERVAL))) {
+                        state.lastReconcile = TIME::now();
+                        monitorOrderAndPlaceTpSl(account.apiParams, state);
+                    }
+                }
 
-            if (!monitor_lock) {
-                monitorOrderAndPlaceTpSl(tpSlQueue, apiParams, "BTCUSDT", signal == 1 ? "SELL":"BUY", last_order_id, last_orig_qty, monitor_lock);
-            }
+                if (row.signal == 0) {
+                    Log::debug(symbol, ": signaling received: DO NOTHING");
+                    continue;
+                }
 
-            if (signal == 0) {
-                // std::cout << "Signaling received: DO NOTHING" << std::endl;
-                continue;
-            }
+                if (row.datetime.empty()) {
+                    Log::debug(symbol, ": no valid signal received.");
+                    continue;
+                }
 
-            if (datetime.empty()) {
-                // std::cout << "No valid signal received." << std::endl;
-                continue;
-            }
+                if (row.datetime == signal.prevDatetime) {
+                    Log::debug(symbol, ": signal datetime has not changed. Skipping execution.");
+                    continue;
+                }
 
-            if (datetime == prev_datetime) {
-                // std::cout << "Signal datetime has not changed. Skipping execution." << std::endl;
-                continue;
-            }
+                signal.prevDatetime = row.datetime;
 
-            prev_datetime = datetime;
+                if (row.signal != 1 && row.signal != -1) {
+                    continue;
+                }
 
-            if (signal == 1) {
-                processSignal(signal, apiParams, signalQueue, "BUY", last_order_id, last_orig_qty, monitor_lock);
-                cancelWithDelay(signal, apiParams, signalQueue, tpSlQueue, monitor_lock);
-            } else if (signal == -1) {
-                processSignal(signal, apiParams, signalQueue, "SELL", last_order_id, last_orig_qty, monitor_lock);
-                cancelWithDelay(signal, apiParams, signalQueue, tpSlQueue, monitor_lock);
+                // Same target time on every account, each one's own shard runs it
+                std::string side = row.signal == 1 ? "BUY" : "SELL";
+                auto executeAt = TIME::now() + config.strategy.execDelay;
+                auto dispatch = std::make_shared<Dispatch>(symbol, accounts.size());
+                for (size_t i = 0; i < accounts.size(); ++i) {
+                    SymbolState &state = *accounts[i].stateOf[symbol];
+                    processSignal(row.signal, row.datetime, accounts[i].apiParams, side, state, signal.read, executeAt,
+                                  DispatchTurn{dispatch, i}, config.dispatchWait);
+                    cancelWithDelay(row.signal, accounts[i].apiParams, state);
+                }
             }
         }
     }
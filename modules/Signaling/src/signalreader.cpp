@@ -0,0 +1,132 @@
+#include "../headers/signalreader.h"
+#include "../../News/headers/news.h"
+#include "../../Log/headers/log.h"
+
+#include <charconv>
+#include <unordered_map>
+#include <utility>
+
+namespace Signaling {
+    SignalReader::SignalReader(std::string defaultSymbol, bool everyRow) :
+            _defaultSymbol(std::move(defaultSymbol)),
+            _everyRow(everyRow) {
+        _columns.fill(-1);
+    }
+
+    void SignalReader::readHeader(std::string_view header) {
+        static constexpr std::array<std::string_view, COLUMNS> NAMES = {"datetime", "symbol", "signal", "lag"};
+        _header = header;
+        _columns.fill(-1);
+        int index = 0;
+        for (size_t start = 0;; ++index) {
+            size_t comma = header.find(',', start);
+            std::string_view name = header.substr(start, comma - start);
+            for (size_t column = 0; column < NAMES.size(); ++column) {
+                if (name == NAMES[column]) {
+                    _columns[column] = index;
+                }
+            }
+            if (comma == std::string_view::npos) {
+                break;
+            }
+            start = comma + 1;
+        }
+    }
+
+    std::vector<SignalRow> SignalReader::consume(std::string_view csv, bool complete) {
+        auto lineAt = [&csv](size_t offset) {
+            size_t end = csv.find('\n', offset);
+            std::string_view line = csv.substr(offset, end == std::string_view::npos ? std::string_view::npos : end - offset);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            return std::pair{line, end == std::string_view::npos ? csv.size() : end + 1};
+        };
+
+        // Same header and the last row still where it was: only the rest is new
+        auto [header, bodyStart] = lineAt(0);
+        bool grown = _offset > 0 && header == _header && _offset <= csv.size() &&
+                     csv.substr(0, _offset).ends_with(_lastLine);
+        _restarted = !grown;
+        if (_restarted) {
+            readHeader(header);
+            _offset = bodyStart;
+            _lastLine.clear();
+        }
+
+        // Fields of every new row as views into csv, a file read from the top keeps only the
+        // last row of each symbol (in order of first appearance)
+        std::vector<std::array<std::string_view, COLUMNS>> lines;
+        std::unordered_map<std::string_view, size_t> lineOfSymbol;
+        while (_offset < csv.size()) {
+            auto [line, next] = lineAt(_offset);
+            // A last row without '\n' may still be written to, it is read once it is complete
+            if (next == csv.size() && csv.back() != '\n' && !complete) {
+                break;
+            }
+            _lastLine.assign(csv.substr(_offset, next - _offset));
+            _offset = next;
+            if (line.empty()) {
+                continue;
+            }
+
+            std::array<std::string_view, COLUMNS> fields{};
+            int index = 0;
+            for (size_t start = 0;; ++index) {
+                size_t comma = line.find(',', start);
+                for (size_t column = 0; column < COLUMNS; ++column) {
+                    if (_columns[column] == index) {
+                        fields[column] = line.substr(start, comma - start);
+                    }
+                }
+                if (comma == std::string_view::npos) {
+                    break;
+                }
+                start = comma + 1;
+            }
+
+            if (!_restarted || _everyRow) {
+                lines.push_back(fields);
+                continue;
+            }
+            std::string_view symbol = fields[SYMBOL].empty() ? std::string_view(_defaultSymbol) : fields[SYMBOL];
+            auto [itr, inserted] = lineOfSymbol.try_emplace(symbol, lines.size());
+            if (inserted) {
+                lines.push_back(fields);
+            } else {
+                lines[itr->second] = fields;
+            }
+        }
+
+        std::vector<SignalRow> rows(lines.size());
+        for (size_t i = 0; i < lines.size(); ++i) {
+            const auto &fields = lines[i];
+            SignalRow &row = rows[i];
+            row.symbol = fields[SYMBOL].empty() ? _defaultSymbol : std::string(fields[SYMBOL]);
+            row.datetime = fields[DATETIME];
+            if (!row.datetime.empty()) {
+                if (auto time = tryParseDateTime(row.datetime)) {
+                    row.time = *time;
+                } else {
+                    // Treated like a row without a datetime, live and in backtests
+                    Log::error("Invalid datetime value: ", row.datetime);
+                    row.datetime.clear();
+                }
+            }
+
+            std::string_view signal = fields[SIGNAL];
+            if (std::from_chars(signal.data(), signal.data() + signal.size(), row.signal).ec != std::errc()) {
+                Log::error("Invalid signal value: ", signal);
+            }
+            std::string_view lag = fields[LAG];
+            if (!lag.empty() && std::from_chars(lag.data(), lag.data() + lag.size(), row.lag).ec != std::errc()) {
+                Log::error("Invalid lag value: ", lag);
+            }
+        }
+        return rows;
+    }
+
+    std::vector<SignalRow> readSignals(const std::string &csv, const std::string &defaultSymbol) {
+        return SignalReader(defaultSymbol).consume(csv, true);
+    }
+}
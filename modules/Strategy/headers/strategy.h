@@ -0,0 +1,96 @@
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../../Decode/headers/decode.h"
+#include "../../Order/models/OrderInput/OrderInput.h"
+#include "../../Order/models/TriggerOrderInput/TriggerOrderInput.h"
+#include "../../Utils/headers/decimal.h"
+
+// The signal strategy without its plumbing: what to send for a signal, when a symbol is
+// ready for an entry, which brackets protect a fill and what to clean up afterwards.
+// Orders and queries go through Exchange, so the live engine (REST, order book) and the
+// backtest (simulated fills) run the same decisions. Timing is up to the caller: the live
+// engine schedules execDelay/cancelDelay on its event queues, the backtest on virtual time.
+namespace Strategy {
+    struct Params {
+        // Entry limit price relative to the last price, against the signal's direction
+        double entryOffset = -0.002;
+        // Bracket trigger prices relative to the price at fill time, in the position's direction
+        double takeProfit = 0.014;
+        double stopLoss = -0.01;
+        // Signal to entry order
+        std::chrono::seconds execDelay{1};
+        // Signal to canceling an entry that did not fill (and leftovers while flat)
+        std::chrono::seconds cancelDelay{3301};
+        // Entry ack to the first fill check when nothing is pushed
+        std::chrono::seconds monitorDelay{1};
+    };
+
+    struct OpenOrder {
+        long long orderId = 0;
+        std::string type;
+    };
+
+    // What the strategy needs from an exchange. Queries answer nullopt when the answer
+    // is not known (request failed).
+    class Exchange {
+    public:
+        virtual ~Exchange() = default;
+
+        virtual std::optional<double> position(const std::string &symbol) = 0;
+
+        virtual std::optional<std::vector<OpenOrder>> openOrders(const std::string &symbol) = 0;
+
+        virtual void cancelAll(const std::string &symbol) = 0;
+
+        virtual Decode::OrderAck placeOrder(const OrderInput &order) = 0;
+
+        // Legs that were accepted
+        virtual size_t placeBrackets(const std::vector<TriggerOrderInput> &legs) = 0;
+    };
+
+    enum class Readiness {
+        Ready,
+        // Position or open orders could not be read
+        Unknown,
+        InPosition,
+        // An entry (LIMIT) order is still working
+        EntryWorking
+    };
+
+    const char *readinessName(Readiness readiness);
+
+    // Ready when flat and no entry is working. Leftover orders of a closed position
+    // (brackets) are canceled on the way.
+    Readiness prepareEntry(Exchange &exchange, const std::string &symbol);
+
+    // LIMIT entry for `signal` (1 buy, -1 sell) sized to `balance`, on the exchange grid.
+    // nullopt with the reason in `violation` when the filters refuse it.
+    std::optional<OrderInput> entryOrder(const Params &params, const std::string &symbol, int signal,
+                                         double price, double balance, const Decode::SymbolFilters &filters,
+                                         std::string *violation = nullptr);
+
+    // Reduce-only take profit and stop loss closing `quantity` of a position opened by
+    // `entrySide`, priced off `price`
+    std::vector<TriggerOrderInput> brackets(const Params &params, const std::string &symbol, const std::string &entrySide,
+                                            Qty quantity, double price, const Decode::SymbolFilters &filters);
+
+    enum class Cleanup {
+        Canceled,
+        // Position or open orders could not be read
+        Unknown,
+        InPosition,
+        NothingOpen
+    };
+
+    const char *cleanupName(Cleanup cleanup);
+
+    // Once the entry had its time: while flat every open order is canceled
+    Cleanup cancelLeftovers(Exchange &exchange, const std::string &symbol);
+}
+
+#endif // STRATEGY_H
@@ -0,0 +1,98 @@
+#include "../headers/strategy.h"
+#include "../../ExchangeInfo/headers/exchangeinfo.h"
+
+namespace Strategy {
+    const char *readinessName(Readiness readiness) {
+        switch (readiness) {
+            case Readiness::Ready:
+                return "ready";
+            case Readiness::Unknown:
+                return "position or open orders unknown";
+            case Readiness::InPosition:
+                return "position is not 0";
+            case Readiness::EntryWorking:
+            default:
+                return "an entry order is still working";
+        }
+    }
+
+    const char *cleanupName(Cleanup cleanup) {
+        switch (cleanup) {
+            case Cleanup::Canceled:
+                return "open orders canceled";
+            case Cleanup::Unknown:
+                return "position or open orders unknown, not canceling";
+            case Cleanup::InPosition:
+                return "canceling aborted due to open position";
+            case Cleanup::NothingOpen:
+            default:
+                return "no open orders to cancel";
+        }
+    }
+
+    Readiness prepareEntry(Exchange &exchange, const std::string &symbol) {
+        auto position = exchange.position(symbol);
+        auto open_orders = exchange.openOrders(symbol);
+        if (!position || !open_orders) {
+            return Readiness::Unknown;
+        }
+        if (*position != 0) {
+            return Readiness::InPosition;
+        }
+
+        for (const auto &order: *open_orders) {
+            if (order.type == "LIMIT") {
+                return Readiness::EntryWorking;
+            }
+        }
+        if (!open_orders->empty()) {
+            exchange.cancelAll(symbol);
+        }
+        return Readiness::Ready;
+    }
+
+    std::optional<OrderInput> entryOrder(const Params &params, const std::string &symbol, int signal,
+                                         double price, double balance, const Decode::SymbolFilters &filters,
+                                         std::string *violation) {
+        Price limit = ExchangeInfo::roundPrice(filters, price * (1 + (params.entryOffset * signal)));
+        Qty quantity = ExchangeInfo::floorQty(filters, balance / limit.toDouble());
+
+        std::string reason = ExchangeInfo::violation(filters, limit, quantity);
+        if (!reason.empty()) {
+            if (violation) {
+                *violation = std::move(reason);
+            }
+            return std::nullopt;
+        }
+        return OrderInput(symbol, signal == 1 ? "BUY" : "SELL", "LIMIT", "GTC", quantity, limit);
+    }
+
+    std::vector<TriggerOrderInput> brackets(const Params &params, const std::string &symbol, const std::string &entrySide,
+                                            Qty quantity, double price, const Decode::SymbolFilters &filters) {
+        int direction = entrySide == "BUY" ? 1 : -1;
+        std::string side = entrySide == "BUY" ? "SELL" : "BUY";
+        Price takeProfit = ExchangeInfo::roundPrice(filters, price * (1 + (params.takeProfit * direction)));
+        Price stopLoss = ExchangeInfo::roundPrice(filters, price * (1 + (params.stopLoss * direction)));
+
+        std::vector<TriggerOrderInput> legs;
+        legs.emplace_back(symbol, side, "TAKE_PROFIT_MARKET", "GTC", quantity, takeProfit, takeProfit, true);
+        legs.emplace_back(symbol, side, "STOP_MARKET", "GTC", quantity, stopLoss, stopLoss, true);
+        return legs;
+    }
+
+    Cleanup cancelLeftovers(Exchange &exchange, const std::string &symbol) {
+        auto position = exchange.position(symbol);
+        auto open_orders = exchange.openOrders(symbol);
+        if (!position || !open_orders) {
+            return Cleanup::Unknown;
+        }
+        if (*position != 0) {
+            return Cleanup::InPosition;
+        }
+        if (open_orders->empty()) {
+            return Cleanup::NothingOpen;
+        }
+        exchange.cancelAll(symbol);
+        return Cleanup::Canceled;
+    }
+}
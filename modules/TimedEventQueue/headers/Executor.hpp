@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Where TimedEventQueue runs its callbacks. The timer thread only hands due events over,
+// so a slow callback never delays the next timer.
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    virtual void post(std::function<void()> task) = 0;
+};
+
+// Fixed set of workers with one deque each. A worker takes from the front of its own
+// deque and, when that is empty, steals from the back of the others. Tasks posted from
+// a worker stay on that worker's deque, other threads spread them round-robin.
+// Queued tasks are finished before the destructor returns.
+class ThreadPoolExecutor : public Executor {
+public:
+    explicit ThreadPoolExecutor(size_t threads = std::max(2u, std::thread::hardware_concurrency())) {
+        for (size_t i = 0; i < threads; ++i) {
+            _workers.push_back(std::make_unique<Worker>());
+        }
+        for (size_t i = 0; i < threads; ++i) {
+            _threads.emplace_back(&ThreadPoolExecutor::work, this, i);
+        }
+    }
+
+    ~ThreadPoolExecutor() override {
+        {
+            std::scoped_lock lock(_sleepMutex);
+            _exit = true;
+        }
+        _cv.notify_all();
+        for (auto &thread: _threads) {
+            thread.join();
+        }
+    }
+
+    ThreadPoolExecutor(const ThreadPoolExecutor &) = delete;
+
+    ThreadPoolExecutor &operator=(const ThreadPoolExecutor &) = delete;
+
+    void post(std::function<void()> task) override {
+        size_t index = currentPool() == this
+                       ? currentIndex()
+                       : _next.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+        {
+            std::scoped_lock lock(_workers[index]->mutex);
+            _workers[index]->tasks.push_back(std::move(task));
+        }
+        {
+            std::scoped_lock lock(_sleepMutex);
+            ++_pending;
+        }
+        _cv.notify_one();
+    }
+
+    size_t size() const { return _workers.size(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::vector<std::thread> _threads;
+    std::mutex _sleepMutex;
+    std::condition_variable _cv;
+    size_t _pending = 0;
+    bool _exit = false;
+    std::atomic<size_t> _next = 0;
+
+    static ThreadPoolExecutor *&currentPool() {
+        thread_local ThreadPoolExecutor *pool = nullptr;
+        return pool;
+    }
+
+    static size_t &currentIndex() {
+        thread_local size_t index = 0;
+        return index;
+    }
+
+    bool take(size_t index, std::function<void()> &task) {
+        {
+            Worker &own = *_workers[index];
+            std::scoped_lock lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.front());
+                own.tasks.pop_front();
+                return true;
+            }
+        }
+
+        for (size_t offset = 1; offset < _workers.size(); ++offset) {
+            Worker &victim = *_workers[(index + offset) % _workers.size()];
+            std::scoped_lock lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.back());
+                victim.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(size_t index) {
+        currentPool() = this;
+        currentIndex() = index;
+
+        std::function<void()> task;
+        while (true) {
+            {
+                std::unique_lock lock(_sleepMutex);
+                _cv.wait(lock, [this]() { return _pending > 0 || _exit; });
+                if (_pending == 0) {
+                    return;
+                }
+                --_pending;
+            }
+
+            // A pending count was reserved above, so a task is queued somewhere
+            while (!take(index, task)) {
+                std::this_thread::yield();
+            }
+            task();
+            task = nullptr;
+        }
+    }
+};
+
+// Runs the tasks posted to it one at a time and in order, on top of another executor.
+// Used to keep per-queue (or per-symbol) callbacks serial while different strands run
+// in parallel on the same pool. Create it with make_shared, a pending drain keeps it alive.
+class Strand : public Executor, public std::enable_shared_from_this<Strand> {
+public:
+    explicit Strand(std::shared_ptr<Executor> executor) : _executor(std::move(executor)) {}
+
+    void post(std::function<void()> task) override {
+        bool schedule;
+        {
+            std::scoped_lock lock(_mutex);
+            _tasks.push_back(std::move(task));
+            schedule = !_running;
+            _running = true;
+        }
+        if (schedule) {
+            _executor->post([self = shared_from_this()]() { self->drain(); });
+        }
+    }
+
+private:
+    std::shared_ptr<Executor> _executor;
+    std::mutex _mutex;
+    std::deque<std::function<void()>> _tasks;
+    bool _running = false;
+
+    void drain() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::scoped_lock lock(_mutex);
+                if (_tasks.empty()) {
+                    _running = false;
+                    return;
+                }
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
@@ -3,10 +3,15 @@
 #include "./TimedEventQueue.hpp"
 
 class SignalQueue : public TimedEventQueue {
+public:
+    using TimedEventQueue::TimedEventQueue;
+
+    // Callbacks still in flight call onTimestampExpire, finish them while it is ours
+    ~SignalQueue() override { stop(); }
+
 protected:
     void onTimestampExpire(const TIMESTAMP &timestamp, const std::string &label) override {
-        std::cout << "Timestamp expired: "
-                  << std::chrono::duration_cast<std::chrono::seconds>(timestamp.time_since_epoch()).count()
-                  << " with label: " << label << std::endl;
+        Log::debug("Timestamp expired: ", std::chrono::duration_cast<std::chrono::seconds>(timestamp.time_since_epoch()).count(),
+                   " with label: ", label);
     }
 };
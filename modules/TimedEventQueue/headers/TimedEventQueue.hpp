@@ -3,50 +3,139 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <exception>
 #include <functional>
-#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
-#include <iostream>
 #include <string>
+#include <vector>
+
+#include "./Executor.hpp"
+#include "../../Log/headers/log.h"
+#include "./TimerWheel.hpp"
 
 using TIME = std::chrono::steady_clock;
 using TIMESTAMP = std::chrono::time_point<TIME>;
-#define CENTENNIAL (TIME::now() + std::chrono::hours(100 * 365 * 24))
 
 class TimedEventQueue {
+public:
+    using Handle = TimerHandle;
+
+    // Delay between an event's timestamp and the moment its callback started running,
+    // timer wake-up latency plus time spent waiting for an executor thread.
+    struct LagStats {
+        uint64_t count = 0;
+        std::chrono::nanoseconds last{0};
+        std::chrono::nanoseconds max{0};
+        std::chrono::nanoseconds total{0};
+
+        std::chrono::nanoseconds mean() const {
+            return count == 0 ? std::chrono::nanoseconds{0} : total / static_cast<int64_t>(count);
+        }
+    };
+
+    using LagObserver = std::function<void(std::chrono::nanoseconds)>;
+
 private:
     struct Event {
+        TIMESTAMP timestamp;
         std::string label;
         std::function<void()> callback;
     };
 
-    std::map<TIMESTAMP, Event> _ts2Val;
-    std::map<std::string, TIMESTAMP> _val2Ts;
+    using Wheel = TimerWheel<Event>;
+
+    // Wheel ticks are milliseconds since the queue was created
+    const TIMESTAMP _origin = TIME::now();
+    Wheel _wheel{0};
+    std::vector<Wheel::Expired> _due;
     std::mutex _mutex;
     std::condition_variable _cv;
     std::atomic<bool> _exit = false;
     std::thread _thread;
 
+    std::shared_ptr<Executor> _executor;
+    size_t _inFlight = 0;
+    std::condition_variable _idle;
+
+    std::atomic<uint64_t> _lagCount = 0;
+    std::atomic<int64_t> _lagLastNs = 0;
+    std::atomic<int64_t> _lagMaxNs = 0;
+    std::atomic<int64_t> _lagTotalNs = 0;
+    LagObserver _lagObserver;
+
+    Wheel::Tick toTick(const TIMESTAMP &timestamp) const {
+        if (timestamp <= _origin) {
+            return 0;
+        }
+        // Round up so an event never fires before its timestamp
+        auto elapsed = std::chrono::ceil<std::chrono::milliseconds>(timestamp - _origin);
+        return static_cast<Wheel::Tick>(elapsed.count());
+    }
+
+    Wheel::Tick currentTick() const {
+        return static_cast<Wheel::Tick>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(TIME::now() - _origin).count());
+    }
+
+    void recordLag(std::chrono::nanoseconds lag) {
+        int64_t ns = std::max<int64_t>(lag.count(), 0);
+        _lagLastNs.store(ns, std::memory_order_relaxed);
+        _lagTotalNs.fetch_add(ns, std::memory_order_relaxed);
+        int64_t max = _lagMaxNs.load(std::memory_order_relaxed);
+        while (ns > max && !_lagMaxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+        _lagCount.fetch_add(1, std::memory_order_relaxed);
+        if (_lagObserver) {
+            _lagObserver(std::chrono::nanoseconds(ns));
+        }
+    }
+
+    void fire(Event &event) {
+        recordLag(TIME::now() - event.timestamp);
+        try {
+            onTimestampExpire(event.timestamp, event.label);
+            if (event.callback) {
+                event.callback();
+            }
+        } catch (const std::exception &e) {
+            Log::error("Event ", event.label, " failed: ", e.what());
+        }
+    }
+
+    // The lock is only held while touching the wheel; callbacks run on the executor, so
+    // they may add, cancel or reschedule events of this queue freely.
     void run() {
+        std::unique_lock lock(_mutex);
         while (!_exit.load()) {
-            std::unique_lock lock(_mutex);
-            _cv.wait_until(lock, _ts2Val.begin()->first);
+            if (auto deadline = _wheel.nextDeadline()) {
+                _cv.wait_until(lock, _origin + std::chrono::milliseconds(*deadline));
+            } else {
+                _cv.wait(lock);
+            }
 
             if (_exit.load()) {
                 break;
             }
 
-            auto current_time = TIME::now();
-            while (_ts2Val.begin()->first <= current_time) {
-                auto event = _ts2Val.begin()->second;
-                std::invoke(&TimedEventQueue::onTimestampExpire, this, _ts2Val.begin()->first, event.label);
-                if (event.callback) {
-                    event.callback();
-                }
-                _val2Ts.erase(event.label);
-                _ts2Val.erase(_ts2Val.begin());
+            _due.clear();
+            _wheel.advance(currentTick(), _due);
+            if (_due.empty()) {
+                continue;
             }
+            _inFlight += _due.size();
+            lock.unlock();
+
+            for (auto &expired: _due) {
+                _executor->post([this, event = std::move(expired.payload)]() mutable {
+                    fire(event);
+                    std::scoped_lock done(_mutex);
+                    if (--_inFlight == 0) {
+                        _idle.notify_all();
+                    }
+                });
+            }
+            lock.lock();
         }
     }
 
@@ -54,9 +143,10 @@ protected:
     virtual void onTimestampExpire(const TIMESTAMP &timestamp, const std::string &label) = 0;
 
 public:
-    TimedEventQueue() {
-        auto dummy_timestamp = CENTENNIAL;
-        addEvent(dummy_timestamp, "", nullptr);
+    // Callbacks run on `executor`. Without one the queue gets a single worker thread of its
+    // own, which keeps them serial like before but off the timer thread.
+    explicit TimedEventQueue(std::shared_ptr<Executor> executor = nullptr) :
+            _executor(executor ? std::move(executor) : std::make_shared<ThreadPoolExecutor>(1)) {
         _thread = std::thread(&TimedEventQueue::run, this);
     }
 
@@ -66,56 +156,117 @@ public:
 
     TimedEventQueue &operator=(const TimedEventQueue &) = delete;
 
-    void addEvent(const TIMESTAMP &timestamp, const std::string &label, const std::function<void()> &callback) {
+    // Events sharing a timestamp and/or a label are all kept and fire in the order they
+    // were added. The handle cancels or reschedules exactly this event in O(1).
+    Handle addEvent(const TIMESTAMP &timestamp, const std::string &label, const std::function<void()> &callback) {
+        std::scoped_lock lock(_mutex);
+        Handle handle = _wheel.schedule(toTick(timestamp), Event{timestamp, label, callback});
+        _cv.notify_one();
+        return handle;
+    }
+
+    bool cancel(Handle handle) {
         std::scoped_lock lock(_mutex);
-        _ts2Val.emplace(timestamp, Event{label, callback});
-        _val2Ts.emplace(label, timestamp);
+        return _wheel.cancel(handle);
+    }
+
+    bool reschedule(Handle handle, const TIMESTAMP &timestamp) {
+        std::scoped_lock lock(_mutex);
+        Event *event = _wheel.find(handle);
+        if (event == nullptr) {
+            return false;
+        }
+        event->timestamp = timestamp;
+        _wheel.reschedule(handle, toTick(timestamp));
         _cv.notify_one();
+        return true;
     }
 
+    size_t size() {
+        std::scoped_lock lock(_mutex);
+        return _wheel.size();
+    }
+
+    LagStats lagStats() const {
+        LagStats stats;
+        stats.count = _lagCount.load(std::memory_order_relaxed);
+        stats.last = std::chrono::nanoseconds(_lagLastNs.load(std::memory_order_relaxed));
+        stats.max = std::chrono::nanoseconds(_lagMaxNs.load(std::memory_order_relaxed));
+        stats.total = std::chrono::nanoseconds(_lagTotalNs.load(std::memory_order_relaxed));
+        return stats;
+    }
+
+    // Also gets every lag sample, e.g. for a histogram. Set it before adding events, it is
+    // called from the executor threads.
+    void setLagObserver(LagObserver observer) {
+        _lagObserver = std::move(observer);
+    }
+
+    // Label/timestamp based operations apply to every matching event, they scan the
+    // whole queue. Prefer the handle returned by addEvent.
     void removeEvent(const std::string &label) {
         std::scoped_lock lock(_mutex);
-        if (auto itr = _val2Ts.find(label); itr != _val2Ts.end()) {
-            _ts2Val.erase(itr->second);
-            _val2Ts.erase(itr);
+        std::vector<Handle> matches;
+        _wheel.forEach([&](Handle handle, Wheel::Tick, Event &event) {
+            if (event.label == label) {
+                matches.push_back(handle);
+            }
+        });
+        for (auto handle: matches) {
+            _wheel.cancel(handle);
         }
     }
 
     void removeEvent(const TIMESTAMP &timestamp) {
         std::scoped_lock lock(_mutex);
-        if (auto itr = _ts2Val.find(timestamp); itr != _ts2Val.end()) {
-            _val2Ts.erase(itr->second.label);
-            _ts2Val.erase(itr);
+        std::vector<Handle> matches;
+        _wheel.forEach([&](Handle handle, Wheel::Tick, Event &event) {
+            if (event.timestamp == timestamp) {
+                matches.push_back(handle);
+            }
+        });
+        for (auto handle: matches) {
+            _wheel.cancel(handle);
         }
     }
 
     void updateLabel(const TIMESTAMP &timestamp, const std::string &label) {
         std::scoped_lock lock(_mutex);
-        if (auto itr = _ts2Val.find(timestamp); _ts2Val.end() != itr) {
-            auto nodeHandler = _val2Ts.extract(itr->second.label);
-            nodeHandler.key() = label;
-            _val2Ts.insert(std::move(nodeHandler));
-            itr->second.label = label;
-        }
+        _wheel.forEach([&](Handle, Wheel::Tick, Event &event) {
+            if (event.timestamp == timestamp) {
+                event.label = label;
+            }
+        });
         _cv.notify_one();
     }
 
     void updateTimestamp(const TIMESTAMP &timestamp, const std::string &label) {
         std::scoped_lock lock(_mutex);
-        if (auto itr = _val2Ts.find(label); _val2Ts.end() != itr) {
-            auto nodeHandler = _ts2Val.extract(itr->second);
-            nodeHandler.key() = timestamp;
-            _ts2Val.insert(std::move(nodeHandler));
-            itr->second = timestamp;
+        std::vector<Handle> matches;
+        _wheel.forEach([&](Handle handle, Wheel::Tick, Event &event) {
+            if (event.label == label) {
+                event.timestamp = timestamp;
+                matches.push_back(handle);
+            }
+        });
+        for (auto handle: matches) {
+            _wheel.reschedule(handle, toTick(timestamp));
         }
         _cv.notify_one();
     }
 
+    // Stops the timer thread and waits for callbacks already handed to the executor, they
+    // reference this queue. Must not be called from one of those callbacks.
     void stop() {
         if (_thread.joinable()) {
-            _exit.store(true);
+            {
+                std::scoped_lock lock(_mutex);
+                _exit.store(true);
+            }
             _cv.notify_one();
             _thread.join();
         }
+        std::unique_lock lock(_mutex);
+        _idle.wait(lock, [this]() { return _inFlight == 0; });
     }
 };
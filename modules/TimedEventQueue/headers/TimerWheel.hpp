@@ -0,0 +1,301 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+struct TimerHandle {
+    uint32_t slot = std::numeric_limits<uint32_t>::max();
+    uint32_t generation = 0;
+
+    bool valid() const { return slot != std::numeric_limits<uint32_t>::max(); }
+
+    bool operator==(const TimerHandle &) const = default;
+};
+
+// Hierarchical timing wheel (6 wheels x 64 slots of ticks, ~2 years at 1 ms per tick).
+// Timers live in a slab of nodes linked into per-slot intrusive lists, so schedule,
+// cancel and reschedule are O(1) and never touch the allocator once the slab has grown.
+// Any number of timers may share the same expiry. Not thread-safe.
+template<typename Payload>
+class TimerWheel {
+public:
+    using Tick = uint64_t;
+
+    struct Expired {
+        Tick expires;
+        uint64_t sequence;
+        Payload payload;
+    };
+
+    explicit TimerWheel(Tick now = 0) : _now(now) {
+        for (auto &wheel: _lists) {
+            wheel.fill(List{});
+        }
+    }
+
+    Tick now() const { return _now; }
+
+    size_t size() const { return _size; }
+
+    TimerHandle schedule(Tick expires, Payload payload) {
+        uint32_t index;
+        if (_free.empty()) {
+            index = static_cast<uint32_t>(_nodes.size());
+            _nodes.emplace_back();
+        } else {
+            index = _free.back();
+            _free.pop_back();
+        }
+
+        Node &node = _nodes[index];
+        node.payload = std::move(payload);
+        node.sequence = _sequence++;
+        node.live = true;
+        ++_size;
+        place(index, expires);
+        return {index, node.generation};
+    }
+
+    bool cancel(TimerHandle handle) {
+        if (!isLive(handle)) {
+            return false;
+        }
+        release(handle.slot);
+        return true;
+    }
+
+    bool reschedule(TimerHandle handle, Tick expires) {
+        if (!isLive(handle)) {
+            return false;
+        }
+        unlink(handle.slot);
+        place(handle.slot, expires);
+        return true;
+    }
+
+    Payload *find(TimerHandle handle) {
+        return isLive(handle) ? &_nodes[handle.slot].payload : nullptr;
+    }
+
+    std::optional<Tick> expiryOf(TimerHandle handle) const {
+        if (!isLive(handle)) {
+            return std::nullopt;
+        }
+        return _nodes[handle.slot].expires;
+    }
+
+    // Visits every live timer, fn(handle, expires, payload). Used by the label based
+    // lookups which are O(n) by nature.
+    template<typename Fn>
+    void forEach(Fn &&fn) {
+        for (uint32_t i = 0; i < _nodes.size(); ++i) {
+            if (_nodes[i].live) {
+                fn(TimerHandle{i, _nodes[i].generation}, _nodes[i].expires, _nodes[i].payload);
+            }
+        }
+    }
+
+    // Earliest tick at which advance() may have something to return. Timers on the
+    // higher wheels are reported at their slot boundary, so this can be early but never
+    // late; advancing to it cascades them down.
+    std::optional<Tick> nextDeadline() const {
+        if (_expired.head != NIL) {
+            return _now;
+        }
+
+        Tick best = std::numeric_limits<Tick>::max();
+        Tick relmask = 0;
+        for (int wheel = 0; wheel < WHEELS; ++wheel) {
+            if (_pending[wheel] != 0) {
+                int slot = static_cast<int>(MASK & (_now >> (wheel * BITS)));
+                Tick timeout = static_cast<Tick>(std::countr_zero(std::rotr(_pending[wheel], slot)) + (wheel != 0 ? 1 : 0))
+                        << (wheel * BITS);
+                timeout -= relmask & _now;
+                best = std::min(best, timeout);
+            }
+            relmask = (relmask << BITS) | MASK;
+        }
+
+        if (best == std::numeric_limits<Tick>::max()) {
+            return std::nullopt;
+        }
+        return _now + best;
+    }
+
+    // Moves the wheel to `now` and appends every timer with expires <= now to `due`,
+    // ordered by expiry and then by scheduling order.
+    void advance(Tick now, std::vector<Expired> &due) {
+        if (now > _now) {
+            collect(now);
+        }
+
+        size_t first = due.size();
+        for (uint32_t index = _expired.head; index != NIL;) {
+            uint32_t next = _nodes[index].next;
+            due.push_back({_nodes[index].expires, _nodes[index].sequence, std::move(_nodes[index].payload)});
+            release(index);
+            index = next;
+        }
+
+        std::sort(due.begin() + static_cast<long>(first), due.end(), [](const Expired &a, const Expired &b) {
+            return a.expires != b.expires ? a.expires < b.expires : a.sequence < b.sequence;
+        });
+    }
+
+private:
+    static constexpr int BITS = 6;
+    static constexpr int WHEELS = 6;
+    static constexpr Tick MASK = (Tick{1} << BITS) - 1;
+    static constexpr Tick MAX_TIMEOUT = (Tick{1} << (BITS * WHEELS)) - 1;
+    static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+    static constexpr uint16_t NO_LIST = std::numeric_limits<uint16_t>::max();
+    static constexpr uint16_t EXPIRED_LIST = WHEELS * 64;
+
+    struct Node {
+        Payload payload{};
+        Tick expires = 0;
+        uint64_t sequence = 0;
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+        uint32_t generation = 0;
+        uint16_t list = NO_LIST;
+        bool live = false;
+    };
+
+    struct List {
+        uint32_t head = NIL;
+        uint32_t tail = NIL;
+    };
+
+    std::vector<Node> _nodes;
+    std::vector<uint32_t> _free;
+    std::array<std::array<List, 64>, WHEELS> _lists;
+    std::array<uint64_t, WHEELS> _pending{};
+    List _expired;
+    Tick _now;
+    uint64_t _sequence = 0;
+    size_t _size = 0;
+    std::vector<uint32_t> _todo;
+
+    bool isLive(TimerHandle handle) const {
+        return handle.slot < _nodes.size() && _nodes[handle.slot].live &&
+               _nodes[handle.slot].generation == handle.generation;
+    }
+
+    List &listOf(uint16_t id) {
+        return id == EXPIRED_LIST ? _expired : _lists[id / 64][id % 64];
+    }
+
+    void link(uint32_t index, uint16_t id) {
+        List &list = listOf(id);
+        Node &node = _nodes[index];
+        node.list = id;
+        node.prev = list.tail;
+        node.next = NIL;
+        if (list.tail != NIL) {
+            _nodes[list.tail].next = index;
+        } else {
+            list.head = index;
+        }
+        list.tail = index;
+        if (id != EXPIRED_LIST) {
+            _pending[id / 64] |= uint64_t{1} << (id % 64);
+        }
+    }
+
+    void unlink(uint32_t index) {
+        Node &node = _nodes[index];
+        if (node.list == NO_LIST) {
+            return;
+        }
+        List &list = listOf(node.list);
+        if (node.prev != NIL) {
+            _nodes[node.prev].next = node.next;
+        } else {
+            list.head = node.next;
+        }
+        if (node.next != NIL) {
+            _nodes[node.next].prev = node.prev;
+        } else {
+            list.tail = node.prev;
+        }
+        if (list.head == NIL && node.list != EXPIRED_LIST) {
+            _pending[node.list / 64] &= ~(uint64_t{1} << (node.list % 64));
+        }
+        node.prev = node.next = NIL;
+        node.list = NO_LIST;
+    }
+
+    void release(uint32_t index) {
+        unlink(index);
+        Node &node = _nodes[index];
+        node.payload = Payload{};
+        node.live = false;
+        ++node.generation;
+        --_size;
+        _free.push_back(index);
+    }
+
+    void place(uint32_t index, Tick expires) {
+        _nodes[index].expires = expires;
+        if (expires <= _now) {
+            link(index, EXPIRED_LIST);
+            return;
+        }
+
+        Tick remaining = std::min(expires - _now, MAX_TIMEOUT);
+        int wheel = (std::bit_width(remaining) - 1) / BITS;
+        int slot = static_cast<int>(MASK & ((expires >> (wheel * BITS)) - (wheel != 0 ? 1 : 0)));
+        link(index, static_cast<uint16_t>(wheel * 64 + slot));
+    }
+
+    void collect(Tick now) {
+        Tick elapsed = now - _now;
+        std::vector<uint32_t> &todo = _todo;
+        todo.clear();
+
+        for (int wheel = 0; wheel < WHEELS; ++wheel) {
+            uint64_t pending;
+            if ((elapsed >> (wheel * BITS)) > MASK) {
+                pending = ~uint64_t{0};
+            } else {
+                Tick wheelElapsed = MASK & (elapsed >> (wheel * BITS));
+                int oldSlot = static_cast<int>(MASK & (_now >> (wheel * BITS)));
+                int newSlot = static_cast<int>(MASK & (now >> (wheel * BITS)));
+                uint64_t span = (uint64_t{1} << wheelElapsed) - 1;
+                pending = std::rotl(span, oldSlot);
+                pending |= std::rotr(std::rotl(span, newSlot), static_cast<int>(wheelElapsed));
+                pending |= uint64_t{1} << newSlot;
+            }
+
+            while ((pending & _pending[wheel]) != 0) {
+                int slot = std::countr_zero(pending & _pending[wheel]);
+                List &list = _lists[wheel][slot];
+                for (uint32_t index = list.head; index != NIL; index = _nodes[index].next) {
+                    todo.push_back(index);
+                }
+                list = List{};
+                _pending[wheel] &= ~(uint64_t{1} << slot);
+            }
+
+            if ((pending & 1) == 0) {
+                break; // did not wrap around, the higher wheels are untouched
+            }
+            elapsed = std::max(elapsed, Tick{64} << (wheel * BITS));
+        }
+
+        _now = now;
+        for (uint32_t index: todo) {
+            Node &node = _nodes[index];
+            node.prev = node.next = NIL;
+            node.list = NO_LIST;
+            place(index, node.expires);
+        }
+    }
+};
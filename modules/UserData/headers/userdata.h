@@ -0,0 +1,103 @@
+#ifndef USER_DATA_H
+#define USER_DATA_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../Order/models/APIParams/APIParams.h"
+
+namespace UserData {
+    struct OrderUpdate {
+        std::string symbol;
+        std::string clientOrderId;
+        std::string side;
+        std::string orderType;
+        std::string executionType;
+        std::string status;
+        long orderId = 0;
+        double origQty = 0;
+        double filledQty = 0;
+        double lastFilledQty = 0;
+        double averagePrice = 0;
+        long eventTimeMs = 0;
+    };
+
+    struct PositionUpdate {
+        std::string symbol;
+        std::string positionSide;
+        double amount = 0;
+        double entryPrice = 0;
+    };
+
+    struct BalanceUpdate {
+        std::string asset;
+        double walletBalance = 0;
+        double crossWalletBalance = 0;
+    };
+
+    struct AccountUpdate {
+        std::string reason;
+        std::vector<BalanceUpdate> balances;
+        std::vector<PositionUpdate> positions;
+        long eventTimeMs = 0;
+    };
+
+    std::string createListenKey(const APIParams &apiParams);
+
+    void keepAliveListenKey(const APIParams &apiParams);
+
+    void closeListenKey(const APIParams &apiParams);
+
+    std::string defaultStreamUrl(bool useTestnet);
+
+    // Listens to the account's user data stream and pushes ORDER_TRADE_UPDATE and
+    // ACCOUNT_UPDATE events to the registered handlers on the stream thread. The
+    // listenKey is renewed in the background and the stream is reopened with a fresh
+    // key whenever it breaks or expires. Handlers are registered before start().
+    class UserDataStream {
+    public:
+        UserDataStream(const APIParams &apiParams, std::string streamBaseUrl,
+                       std::chrono::minutes keepAliveInterval = std::chrono::minutes(30));
+
+        ~UserDataStream();
+
+        UserDataStream(const UserDataStream &) = delete;
+
+        UserDataStream &operator=(const UserDataStream &) = delete;
+
+        void onOrderUpdate(std::function<void(const OrderUpdate &)> handler);
+
+        void onAccountUpdate(std::function<void(const AccountUpdate &)> handler);
+
+        // Called after every (re)connect. Events may have been missed while the stream
+        // was down, so this is where callers reconcile their state over REST.
+        void onConnected(std::function<void()> handler);
+
+        void start();
+
+        void stop();
+
+        bool isConnected() const { return _connected.load(std::memory_order_acquire); }
+
+    private:
+        const APIParams _apiParams;
+        const std::string _streamBaseUrl;
+        const std::chrono::minutes _keepAliveInterval;
+        std::function<void(const OrderUpdate &)> _orderHandler;
+        std::function<void(const AccountUpdate &)> _accountHandler;
+        std::function<void()> _connectedHandler;
+        std::atomic<bool> _exit = false;
+        std::atomic<bool> _connected = false;
+        std::thread _thread;
+
+        void run();
+
+        // Returns false when the listenKey expired and the stream has to be reopened.
+        bool handleMessage(const std::string &message);
+    };
+}
+
+#endif // USER_DATA_H
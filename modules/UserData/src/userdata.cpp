@@ -0,0 +1,175 @@
+#include "../headers/userdata.h"
+#include "../../Http/headers/http.h"
+#include "../../WebSocket/headers/websocket.h"
+#include "../../Log/headers/log.h"
+
+#include "nlohmann/json.hpp"
+
+namespace UserData {
+    namespace {
+        double toDouble(const nlohmann::json &object, const char *key) {
+            if (!object.contains(key)) {
+                return 0;
+            }
+            const auto &value = object[key];
+            return value.is_string() ? std::stod(value.get<std::string>()) : value.get<double>();
+        }
+
+        std::string toString(const nlohmann::json &object, const char *key) {
+            return object.contains(key) && object[key].is_string() ? object[key].get<std::string>() : "";
+        }
+    }
+
+    std::string createListenKey(const APIParams &apiParams) {
+        cpr::Response r = Http::post(apiParams.baseUrl(), "fapi/v1/listenKey", cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool());
+        auto response = nlohmann::json::parse(r.text, nullptr, false);
+        if (!response.is_object() || !response.contains("listenKey")) {
+            throw std::runtime_error("Could not create listenKey: " + r.text);
+        }
+        return response["listenKey"].get<std::string>();
+    }
+
+    void keepAliveListenKey(const APIParams &apiParams) {
+        Http::put(apiParams.baseUrl(), "fapi/v1/listenKey", cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool());
+    }
+
+    void closeListenKey(const APIParams &apiParams) {
+        Http::del(apiParams.baseUrl(), "fapi/v1/listenKey", cpr::Header{{"X-MBX-APIKEY", apiParams.apiKey}}, apiParams.sessionPool());
+    }
+
+    std::string defaultStreamUrl(bool useTestnet) {
+        return useTestnet ? "wss://stream.binancefuture.com" : "wss://fstream.binance.com";
+    }
+
+    UserDataStream::UserDataStream(const APIParams &apiParams, std::string streamBaseUrl, std::chrono::minutes keepAliveInterval) :
+            _apiParams(apiParams),
+            _streamBaseUrl(std::move(streamBaseUrl)),
+            _keepAliveInterval(keepAliveInterval) {}
+
+    UserDataStream::~UserDataStream() {
+        stop();
+    }
+
+    void UserDataStream::onOrderUpdate(std::function<void(const OrderUpdate &)> handler) {
+        _orderHandler = std::move(handler);
+    }
+
+    void UserDataStream::onAccountUpdate(std::function<void(const AccountUpdate &)> handler) {
+        _accountHandler = std::move(handler);
+    }
+
+    void UserDataStream::onConnected(std::function<void()> handler) {
+        _connectedHandler = std::move(handler);
+    }
+
+    void UserDataStream::start() {
+        if (!_thread.joinable()) {
+            _exit.store(false);
+            _thread = std::thread(&UserDataStream::run, this);
+        }
+    }
+
+    void UserDataStream::stop() {
+        if (_thread.joinable()) {
+            _exit.store(true);
+            _thread.join();
+        }
+    }
+
+    void UserDataStream::run() {
+        WebSocketClient client;
+        std::string message;
+        auto backoff = std::chrono::milliseconds(250);
+
+        while (!_exit.load()) {
+            try {
+                std::string listenKey = createListenKey(_apiParams);
+                client.connect(_streamBaseUrl + "/ws/" + listenKey);
+                backoff = std::chrono::milliseconds(250);
+                _connected.store(true, std::memory_order_release);
+                if (_connectedHandler) {
+                    _connectedHandler();
+                }
+
+                auto lastKeepAlive = std::chrono::steady_clock::now();
+                bool alive = true;
+                while (alive && !_exit.load()) {
+                    if (client.receive(message, std::chrono::milliseconds(500))) {
+                        alive = handleMessage(message);
+                    }
+
+                    if (std::chrono::steady_clock::now() - lastKeepAlive >= _keepAliveInterval) {
+                        keepAliveListenKey(_apiParams);
+                        lastKeepAlive = std::chrono::steady_clock::now();
+                    }
+                }
+            } catch (const std::exception &e) {
+                Log::error("User data stream error: ", e.what());
+            }
+
+            _connected.store(false, std::memory_order_release);
+            client.close();
+            if (_exit.load()) {
+                break;
+            }
+
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min(backoff * 2, std::chrono::milliseconds(10000));
+        }
+
+        try {
+            closeListenKey(_apiParams);
+        } catch (const std::exception &) {
+            // the key expires on its own
+        }
+    }
+
+    bool UserDataStream::handleMessage(const std::string &message) {
+        auto event = nlohmann::json::parse(message, nullptr, false);
+        if (event.is_discarded() || !event.contains("e")) {
+            return true;
+        }
+
+        const std::string type = event["e"].get<std::string>();
+        if (type == "listenKeyExpired") {
+            return false;
+        }
+
+        if (type == "ORDER_TRADE_UPDATE" && _orderHandler && event.contains("o")) {
+            const auto &o = event["o"];
+            OrderUpdate update;
+            update.symbol = toString(o, "s");
+            update.clientOrderId = toString(o, "c");
+            update.side = toString(o, "S");
+            update.orderType = toString(o, "o");
+            update.executionType = toString(o, "x");
+            update.status = toString(o, "X");
+            update.orderId = o.contains("i") ? o["i"].get<long>() : 0;
+            update.origQty = toDouble(o, "q");
+            update.filledQty = toDouble(o, "z");
+            update.lastFilledQty = toDouble(o, "l");
+            update.averagePrice = toDouble(o, "ap");
+            update.eventTimeMs = event.contains("E") ? event["E"].get<long>() : 0;
+            _orderHandler(update);
+        } else if (type == "ACCOUNT_UPDATE" && _accountHandler && event.contains("a")) {
+            const auto &a = event["a"];
+            AccountUpdate update;
+            update.reason = toString(a, "m");
+            update.eventTimeMs = event.contains("E") ? event["E"].get<long>() : 0;
+            if (a.contains("B")) {
+                for (const auto &balance: a["B"]) {
+                    update.balances.push_back({toString(balance, "a"), toDouble(balance, "wb"), toDouble(balance, "cw")});
+                }
+            }
+            if (a.contains("P")) {
+                for (const auto &position: a["P"]) {
+                    update.positions.push_back({toString(position, "s"), toString(position, "ps"),
+                                                toDouble(position, "pa"), toDouble(position, "ep")});
+                }
+            }
+            _accountHandler(update);
+        }
+
+        return true;
+    }
+}
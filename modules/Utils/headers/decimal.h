@@ -0,0 +1,168 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include <charconv>
+#include <cmath>
+#include <compare>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Fixed-point decimal with 8 fractional digits, the precision Binance uses for every price
+// and quantity. Values are exact multiples of 1e-8, so a price floored to a 0.1 tick is
+// sent as "64072.7" instead of "64072.700000" or "64072.699999". The tag keeps prices and
+// quantities from being mixed up.
+template<typename Tag>
+class Decimal {
+public:
+    static constexpr int DIGITS = 8;
+    static constexpr int64_t SCALE = 100000000;
+    // Longest formatted value: sign, 11 integer digits, point, 8 fraction digits
+    static constexpr size_t MAX_CHARS = 24;
+
+    constexpr Decimal() = default;
+
+    static constexpr Decimal fromUnits(int64_t units) {
+        Decimal value;
+        value._units = units;
+        return value;
+    }
+
+    // Nearest multiple of 1e-8
+    static Decimal fromDouble(double value) {
+        return fromUnits(static_cast<int64_t>(std::llround(value * static_cast<double>(SCALE))));
+    }
+
+    // Exact parse of "-123.456"; digits past the 8th decimal are truncated. Exponents and
+    // anything else fall back to fromDouble, nullopt if it is not a number at all.
+    static std::optional<Decimal> parse(std::string_view text) {
+        const char *ptr = text.data();
+        const char *end = ptr + text.size();
+        bool negative = ptr != end && *ptr == '-';
+        if (negative) {
+            ++ptr;
+        }
+
+        int64_t units = 0;
+        int fraction = -1;
+        bool digits = false;
+        for (; ptr != end; ++ptr) {
+            if (*ptr >= '0' && *ptr <= '9') {
+                digits = true;
+                if (fraction < DIGITS) {
+                    units = units * 10 + (*ptr - '0');
+                    if (fraction >= 0) {
+                        ++fraction;
+                    }
+                }
+            } else if (*ptr == '.' && fraction < 0) {
+                fraction = 0;
+            } else {
+                break;
+            }
+        }
+
+        if (ptr != end || !digits) {
+            double value;
+            auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+            if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+                return std::nullopt;
+            }
+            return fromDouble(value);
+        }
+
+        for (int i = fraction < 0 ? 0 : fraction; i < DIGITS; ++i) {
+            units *= 10;
+        }
+        return fromUnits(negative ? -units : units);
+    }
+
+    constexpr int64_t units() const { return _units; }
+
+    constexpr double toDouble() const { return static_cast<double>(_units) / static_cast<double>(SCALE); }
+
+    constexpr bool isZero() const { return _units == 0; }
+
+    // Multiples of `step`, a zero step leaves the value untouched
+    constexpr Decimal floorTo(Decimal step) const {
+        if (step._units <= 0) {
+            return *this;
+        }
+        int64_t remainder = _units % step._units;
+        if (remainder < 0) {
+            remainder += step._units;
+        }
+        return fromUnits(_units - remainder);
+    }
+
+    constexpr Decimal ceilTo(Decimal step) const {
+        Decimal floor = floorTo(step);
+        return floor == *this ? floor : fromUnits(floor._units + step._units);
+    }
+
+    constexpr Decimal roundTo(Decimal step) const {
+        Decimal floor = floorTo(step);
+        return (_units - floor._units) * 2 >= step._units ? fromUnits(floor._units + step._units) : floor;
+    }
+
+    // Writes the shortest exact representation ("0.001", "64072.7", "5") and returns its
+    // length, at most MAX_CHARS. Not null terminated.
+    size_t format(char *out) const {
+        char *ptr = out;
+        uint64_t magnitude = _units < 0 ? static_cast<uint64_t>(-(_units + 1)) + 1 : static_cast<uint64_t>(_units);
+        if (_units < 0) {
+            *ptr++ = '-';
+        }
+
+        ptr = std::to_chars(ptr, out + MAX_CHARS, magnitude / SCALE).ptr;
+        uint64_t fraction = magnitude % SCALE;
+        if (fraction != 0) {
+            char digits[DIGITS];
+            for (int i = DIGITS - 1; i >= 0; --i) {
+                digits[i] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            int length = DIGITS;
+            while (digits[length - 1] == '0') {
+                --length;
+            }
+            *ptr++ = '.';
+            for (int i = 0; i < length; ++i) {
+                *ptr++ = digits[i];
+            }
+        }
+        return static_cast<size_t>(ptr - out);
+    }
+
+    std::string toString() const {
+        char buffer[MAX_CHARS];
+        return {buffer, format(buffer)};
+    }
+
+    constexpr auto operator<=>(const Decimal &) const = default;
+
+    constexpr Decimal operator+(Decimal other) const { return fromUnits(_units + other._units); }
+
+    constexpr Decimal operator-(Decimal other) const { return fromUnits(_units - other._units); }
+
+    friend std::ostream &operator<<(std::ostream &os, const Decimal &value) {
+        char buffer[MAX_CHARS];
+        return os.write(buffer, static_cast<std::streamsize>(value.format(buffer)));
+    }
+
+private:
+    int64_t _units = 0;
+};
+
+using Price = Decimal<struct PriceTag>;
+using Qty = Decimal<struct QtyTag>;
+
+// price * quantity, in quote currency
+inline Price notional(Price price, Qty quantity) {
+    __int128 units = static_cast<__int128>(price.units()) * quantity.units() / Qty::SCALE;
+    return Price::fromUnits(static_cast<int64_t>(units));
+}
+
+#endif // DECIMAL_H
@@ -0,0 +1,36 @@
+#ifndef HMAC_H
+#define HMAC_H
+
+#include <cstddef>
+#include <string_view>
+#include <openssl/sha.h>
+
+namespace Utils {
+    // HMAC-SHA256 with the key schedule done once: the key-xor-ipad and key-xor-opad blocks
+    // are hashed in the constructor, signing only copies those two states and hashes the
+    // message. No allocation and no shared state, a const instance is safe from any thread.
+    class HmacSha256 {
+    public:
+        static constexpr size_t DIGEST_SIZE = SHA256_DIGEST_LENGTH;
+        static constexpr size_t HEX_SIZE = DIGEST_SIZE * 2;
+
+        explicit HmacSha256(std::string_view key);
+
+        void sign(std::string_view data, unsigned char *digest) const;
+
+        // Writes HEX_SIZE lowercase hex characters, not null terminated
+        void signHex(std::string_view data, char *out) const;
+
+        // Context for `key` owned by the calling thread, only rebuilt when the thread signs
+        // with a key it has not seen recently.
+        static const HmacSha256 &forThread(std::string_view key);
+
+    private:
+        SHA256_CTX _inner{};
+        SHA256_CTX _outer{};
+    };
+
+    void toHex(const unsigned char *data, size_t size, char *out);
+}
+
+#endif // HMAC_H
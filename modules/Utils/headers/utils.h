@@ -2,21 +2,30 @@
 #define UTILS_H
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <vector>
 
 namespace Utils {
     void printMapElements(const std::map<std::string, std::string> &env);
 
-    std::string exec(const char* cmd);
+    // Output of cmd, `status` receives its exit status (-1 when it did not exit normally)
+    std::string exec(const char* cmd, int *status = nullptr);
 
     std::string trimQuotes(const std::string &str);
 
     std::map<std::string, std::string> loadEnvFile(const std::string &filePath);
 
+    // "A, B,,C" -> {"A", "B", "C"}, surrounding spaces and empty items are dropped
+    std::vector<std::string> splitList(const std::string &value, char delimiter = ',');
+
     std::string getExecutablePath();
 
     std::string urlEncode(const std::string &value);
 
+    void appendUrlEncoded(std::string &out, std::string_view value);
+
+    // Lowercase hex HMAC-SHA256, safe to call from any thread (see HmacSha256)
     std::string HMAC_SHA256(const std::string &key, const std::string &data);
 }
 
@@ -0,0 +1,97 @@
+// SHA256_Init/Update/Final are deprecated in OpenSSL 3 but remain the only way to keep a
+// precomputed hash state on the stack, EVP_MD_CTX copies allocate.
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include "../headers/hmac.h"
+
+#include <array>
+#include <cstring>
+#include <string>
+
+namespace {
+    constexpr size_t BLOCK_SIZE = 64;
+    constexpr size_t CACHED_KEYS = 4;
+
+    constexpr std::array<char[2], 256> HEX_TABLE = []() {
+        constexpr char digits[] = "0123456789abcdef";
+        std::array<char[2], 256> table{};
+        for (size_t i = 0; i < 256; ++i) {
+            table[i][0] = digits[i >> 4];
+            table[i][1] = digits[i & 0x0F];
+        }
+        return table;
+    }();
+
+    struct CachedKey {
+        std::string key;
+        Utils::HmacSha256 context{""};
+        bool used = false;
+    };
+}
+
+namespace Utils {
+    HmacSha256::HmacSha256(std::string_view key) {
+        unsigned char block[BLOCK_SIZE] = {};
+        if (key.size() > BLOCK_SIZE) {
+            SHA256(reinterpret_cast<const unsigned char *>(key.data()), key.size(), block);
+        } else {
+            std::memcpy(block, key.data(), key.size());
+        }
+
+        unsigned char pad[BLOCK_SIZE];
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            pad[i] = block[i] ^ 0x36;
+        }
+        SHA256_Init(&_inner);
+        SHA256_Update(&_inner, pad, BLOCK_SIZE);
+
+        for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+            pad[i] = block[i] ^ 0x5c;
+        }
+        SHA256_Init(&_outer);
+        SHA256_Update(&_outer, pad, BLOCK_SIZE);
+    }
+
+    void HmacSha256::sign(std::string_view data, unsigned char *digest) const {
+        unsigned char innerDigest[DIGEST_SIZE];
+        SHA256_CTX ctx = _inner;
+        SHA256_Update(&ctx, data.data(), data.size());
+        SHA256_Final(innerDigest, &ctx);
+
+        ctx = _outer;
+        SHA256_Update(&ctx, innerDigest, DIGEST_SIZE);
+        SHA256_Final(digest, &ctx);
+    }
+
+    void HmacSha256::signHex(std::string_view data, char *out) const {
+        unsigned char digest[DIGEST_SIZE];
+        sign(data, digest);
+        toHex(digest, DIGEST_SIZE, out);
+    }
+
+    const HmacSha256 &HmacSha256::forThread(std::string_view key) {
+        // A handful of slots covers one secret per account without rebuilding on every switch
+        thread_local std::array<CachedKey, CACHED_KEYS> cache;
+        thread_local size_t next = 0;
+
+        for (auto &entry: cache) {
+            if (entry.used && entry.key == key) {
+                return entry.context;
+            }
+        }
+
+        CachedKey &entry = cache[next];
+        next = (next + 1) % CACHED_KEYS;
+        entry.key.assign(key);
+        entry.context = HmacSha256(key);
+        entry.used = true;
+        return entry.context;
+    }
+
+    void toHex(const unsigned char *data, size_t size, char *out) {
+        for (size_t i = 0; i < size; ++i) {
+            out[i * 2] = HEX_TABLE[data[i]][0];
+            out[i * 2 + 1] = HEX_TABLE[data[i]][1];
+        }
+    }
+}
@@ -1,11 +1,11 @@
 #include "../headers/utils.h"
+#include "../headers/hmac.h"
 #include <fstream>
 #include <sstream>
 #include <unistd.h>
+#include <sys/wait.h>
 #include <climits>
-#include <openssl/hmac.h>
-#include <openssl/sha.h>
-#include <iomanip>
+#include <array>
 #include <iostream>
 
 #include <vector>
@@ -20,18 +20,22 @@ namespace Utils {
         }
     }
 
-    std::string exec(const char* cmd) {
+    std::string exec(const char* cmd, int *status) {
         std::vector<char> buffer(128);
         std::string result;
-        std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(cmd, "r"), pclose);
+        FILE *pipe = popen(cmd, "r");
         if (!pipe) {
             throw std::runtime_error("popen() failed!");
         }
 
-        while (fgets(buffer.data(), static_cast<int>(std::min(buffer.size(), static_cast<std::size_t>(INT_MAX))), pipe.get()) != nullptr) {
+        while (fgets(buffer.data(), static_cast<int>(std::min(buffer.size(), static_cast<std::size_t>(INT_MAX))), pipe) != nullptr) {
             result += buffer.data();
         }
 
+        int raw = pclose(pipe);
+        if (status) {
+            *status = raw != -1 && WIFEXITED(raw) ? WEXITSTATUS(raw) : -1;
+        }
         return result;
     }
 
@@ -64,6 +68,21 @@ namespace Utils {
         return env;
     }
 
+    std::vector<std::string> splitList(const std::string &value, char delimiter) {
+        std::vector<std::string> items;
+        std::istringstream stream(value);
+        std::string item;
+        while (std::getline(stream, item, delimiter)) {
+            size_t first = item.find_first_not_of(" \t");
+            if (first == std::string::npos) {
+                continue;
+            }
+            size_t last = item.find_last_not_of(" \t");
+            items.push_back(item.substr(first, last - first + 1));
+        }
+        return items;
+    }
+
     std::string getExecutablePath() {
         char result[PATH_MAX];
         ssize_t count = readlink("/proc/self/exe", result, PATH_MAX);
@@ -72,35 +91,41 @@ namespace Utils {
 
     // HTTP Request Utils
 
-    std::string urlEncode(const std::string &value) {
-        std::ostringstream escaped;
-        escaped.fill('0');
-        escaped << std::hex;
+    namespace {
+        // Unreserved characters (RFC 3986) pass through, everything else is %XX
+        constexpr std::array<bool, 256> UNRESERVED = []() {
+            std::array<bool, 256> table{};
+            for (int c = 0; c < 256; ++c) {
+                table[c] = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+                           c == '-' || c == '_' || c == '.' || c == '~';
+            }
+            return table;
+        }();
+    }
 
+    void appendUrlEncoded(std::string &out, std::string_view value) {
+        constexpr char digits[] = "0123456789ABCDEF";
         for (char c: value) {
-            if (isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.' || c == '~') {
-                escaped << c;
+            auto byte = static_cast<unsigned char>(c);
+            if (UNRESERVED[byte]) {
+                out.push_back(c);
             } else {
-                escaped << '%' << std::setw(2) << std::uppercase << static_cast<int>(static_cast<unsigned char>(c));
+                char escaped[3] = {'%', digits[byte >> 4], digits[byte & 0x0F]};
+                out.append(escaped, 3);
             }
         }
+    }
 
-        return escaped.str();
+    std::string urlEncode(const std::string &value) {
+        std::string escaped;
+        escaped.reserve(value.size() * 3);
+        appendUrlEncoded(escaped, value);
+        return escaped;
     }
 
     std::string HMAC_SHA256(const std::string &key, const std::string &data) {
-        unsigned char *digest;
-        unsigned int len = SHA256_DIGEST_LENGTH;
-
-        digest = HMAC(EVP_sha256(), key.c_str(), static_cast<int>(key.length()),
-                      reinterpret_cast<const unsigned char *>(data.c_str()), static_cast<int>(data.length()), nullptr,
-                      nullptr);
-
-        char mdString[SHA256_DIGEST_LENGTH * 2 + 1];
-        for (unsigned int i = 0; i < len; i++) {
-            sprintf(&mdString[i * 2], "%02x", digest[i]);
-        }
-
-        return {mdString};
+        std::string signature(HmacSha256::HEX_SIZE, '\0');
+        HmacSha256::forThread(key).signHex(data, signature.data());
+        return signature;
     }
 }
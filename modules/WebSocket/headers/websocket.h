@@ -0,0 +1,61 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <openssl/ssl.h>
+
+// Minimal RFC 6455 client over a plain or TLS socket, enough for the exchange streams:
+// text frames in both directions, fragmented messages, ping/pong and close.
+// Not thread-safe, one thread owns the connection.
+class WebSocketClient {
+public:
+    WebSocketClient() = default;
+
+    ~WebSocketClient();
+
+    WebSocketClient(const WebSocketClient &) = delete;
+
+    WebSocketClient &operator=(const WebSocketClient &) = delete;
+
+    // Accepts ws:// and wss:// URLs, throws std::runtime_error when the connection or
+    // the opening handshake fails.
+    void connect(const std::string &url, std::chrono::milliseconds timeout = std::chrono::seconds(10));
+
+    void close();
+
+    bool isOpen() const { return _fd >= 0; }
+
+    void sendText(std::string_view message);
+
+    // Waits for the next complete text/binary message. Control frames are handled on
+    // the way. Returns false when nothing arrived within timeout, throws
+    // std::runtime_error when the peer closed or the connection broke.
+    bool receive(std::string &message, std::chrono::milliseconds timeout);
+
+private:
+    int _fd = -1;
+    SSL_CTX *_ctx = nullptr;
+    SSL *_ssl = nullptr;
+    std::string _buffer;
+    std::string _fragments;
+    size_t _offset = 0;
+
+    void openSocket(const std::string &host, const std::string &port, std::chrono::milliseconds timeout);
+
+    void startTls(const std::string &host);
+
+    void handshake(const std::string &host, const std::string &path);
+
+    bool waitReadable(std::chrono::milliseconds timeout);
+
+    bool fill(std::chrono::steady_clock::time_point deadline);
+
+    void writeAll(const char *data, size_t length);
+
+    void sendFrame(uint8_t opcode, std::string_view payload);
+};
+
+#endif // WEBSOCKET_H
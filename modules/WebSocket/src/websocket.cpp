@@ -0,0 +1,366 @@
+#include "../headers/websocket.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+#include <openssl/x509v3.h>
+
+namespace {
+    constexpr uint8_t OPCODE_CONTINUATION = 0x0;
+    constexpr uint8_t OPCODE_TEXT = 0x1;
+    constexpr uint8_t OPCODE_BINARY = 0x2;
+    constexpr uint8_t OPCODE_CLOSE = 0x8;
+    constexpr uint8_t OPCODE_PING = 0x9;
+    constexpr uint8_t OPCODE_PONG = 0xA;
+
+    constexpr const char *HANDSHAKE_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+    std::string base64(const unsigned char *data, size_t length) {
+        std::string out(4 * ((length + 2) / 3), '\0');
+        int written = EVP_EncodeBlock(reinterpret_cast<unsigned char *>(out.data()), data, static_cast<int>(length));
+        out.resize(static_cast<size_t>(written));
+        return out;
+    }
+
+    struct Url {
+        bool secure;
+        std::string host;
+        std::string port;
+        std::string path;
+    };
+
+    Url parseUrl(const std::string &url) {
+        Url result;
+        size_t hostStart;
+        if (url.rfind("wss://", 0) == 0) {
+            result.secure = true;
+            hostStart = 6;
+        } else if (url.rfind("ws://", 0) == 0) {
+            result.secure = false;
+            hostStart = 5;
+        } else {
+            throw std::runtime_error("Unsupported WebSocket URL: " + url);
+        }
+
+        size_t pathStart = url.find('/', hostStart);
+        std::string authority = url.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+        result.path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+
+        size_t colon = authority.rfind(':');
+        if (colon != std::string::npos) {
+            result.host = authority.substr(0, colon);
+            result.port = authority.substr(colon + 1);
+        } else {
+            result.host = authority;
+            result.port = result.secure ? "443" : "80";
+        }
+        return result;
+    }
+}
+
+WebSocketClient::~WebSocketClient() {
+    close();
+    if (_ctx != nullptr) {
+        SSL_CTX_free(_ctx);
+    }
+}
+
+void WebSocketClient::connect(const std::string &url, std::chrono::milliseconds timeout) {
+    close();
+    Url target = parseUrl(url);
+
+    openSocket(target.host, target.port, timeout);
+    try {
+        if (target.secure) {
+            startTls(target.host);
+        }
+        handshake(target.host, target.path);
+    } catch (...) {
+        close();
+        throw;
+    }
+}
+
+void WebSocketClient::openSocket(const std::string &host, const std::string &port, std::chrono::milliseconds timeout) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses) != 0 || addresses == nullptr) {
+        throw std::runtime_error("Could not resolve " + host);
+    }
+
+    for (addrinfo *address = addresses; address != nullptr; address = address->ai_next) {
+        int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+
+        // Non-blocking connect so the timeout applies, then back to blocking mode.
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int rc = ::connect(fd, address->ai_addr, address->ai_addrlen);
+        if (rc != 0 && errno == EINPROGRESS) {
+            pollfd pfd{fd, POLLOUT, 0};
+            if (poll(&pfd, 1, static_cast<int>(timeout.count())) == 1) {
+                int error = 0;
+                socklen_t length = sizeof(error);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+                rc = error == 0 ? 0 : -1;
+            }
+        }
+
+        if (rc == 0) {
+            fcntl(fd, F_SETFL, flags);
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+            _fd = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(addresses);
+
+    if (_fd < 0) {
+        throw std::runtime_error("Could not connect to " + host + ":" + port);
+    }
+}
+
+void WebSocketClient::startTls(const std::string &host) {
+    if (_ctx == nullptr) {
+        _ctx = SSL_CTX_new(TLS_client_method());
+        if (_ctx == nullptr) {
+            throw std::runtime_error("SSL_CTX_new failed");
+        }
+        SSL_CTX_set_default_verify_paths(_ctx);
+        SSL_CTX_set_verify(_ctx, SSL_VERIFY_PEER, nullptr);
+    }
+
+    _ssl = SSL_new(_ctx);
+    SSL_set_fd(_ssl, _fd);
+    SSL_set_tlsext_host_name(_ssl, host.c_str());
+    SSL_set1_host(_ssl, host.c_str());
+    if (SSL_connect(_ssl) != 1) {
+        throw std::runtime_error("TLS handshake with " + host + " failed");
+    }
+}
+
+void WebSocketClient::handshake(const std::string &host, const std::string &path) {
+    unsigned char nonce[16];
+    RAND_bytes(nonce, sizeof(nonce));
+    std::string key = base64(nonce, sizeof(nonce));
+
+    std::string request = "GET " + path + " HTTP/1.1\r\n"
+                          "Host: " + host + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + key + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n";
+    writeAll(request.data(), request.size());
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    size_t headerEnd;
+    while ((headerEnd = _buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!fill(deadline)) {
+            throw std::runtime_error("WebSocket handshake timed out");
+        }
+    }
+
+    std::string response = _buffer.substr(0, headerEnd);
+    _offset = headerEnd + 4;
+    if (response.rfind("HTTP/1.1 101", 0) != 0) {
+        throw std::runtime_error("WebSocket upgrade rejected: " + response.substr(0, response.find("\r\n")));
+    }
+
+    std::string accepted = key + HANDSHAKE_GUID;
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    SHA1(reinterpret_cast<const unsigned char *>(accepted.data()), accepted.size(), digest);
+    if (response.find(base64(digest, sizeof(digest))) == std::string::npos) {
+        throw std::runtime_error("WebSocket handshake returned an invalid accept key");
+    }
+}
+
+void WebSocketClient::close() {
+    if (_fd >= 0) {
+        try {
+            sendFrame(OPCODE_CLOSE, {});
+        } catch (const std::exception &) {
+            // the peer is gone already
+        }
+    }
+    if (_ssl != nullptr) {
+        SSL_free(_ssl);
+        _ssl = nullptr;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _buffer.clear();
+    _fragments.clear();
+    _offset = 0;
+}
+
+bool WebSocketClient::waitReadable(std::chrono::milliseconds timeout) {
+    if (_ssl != nullptr && SSL_pending(_ssl) > 0) {
+        return true;
+    }
+    pollfd pfd{_fd, POLLIN, 0};
+    int rc = poll(&pfd, 1, static_cast<int>(std::max<long>(0, timeout.count())));
+    return rc > 0;
+}
+
+bool WebSocketClient::fill(std::chrono::steady_clock::time_point deadline) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    if (!waitReadable(remaining)) {
+        return false;
+    }
+
+    if (_offset > 0 && _offset == _buffer.size()) {
+        _buffer.clear();
+        _offset = 0;
+    } else if (_offset > 64 * 1024) {
+        _buffer.erase(0, _offset);
+        _offset = 0;
+    }
+
+    char chunk[16 * 1024];
+    long received = _ssl != nullptr
+                    ? SSL_read(_ssl, chunk, sizeof(chunk))
+                    : ::recv(_fd, chunk, sizeof(chunk), 0);
+    if (received <= 0) {
+        throw std::runtime_error("WebSocket connection closed by peer");
+    }
+    _buffer.append(chunk, static_cast<size_t>(received));
+    return true;
+}
+
+void WebSocketClient::writeAll(const char *data, size_t length) {
+    while (length > 0) {
+        long sent = _ssl != nullptr
+                    ? SSL_write(_ssl, data, static_cast<int>(length))
+                    : ::send(_fd, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            throw std::runtime_error("WebSocket write failed");
+        }
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+}
+
+void WebSocketClient::sendFrame(uint8_t opcode, std::string_view payload) {
+    // Client to server frames are always masked.
+    std::string frame;
+    frame.reserve(payload.size() + 14);
+    frame.push_back(static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+        frame.push_back(static_cast<char>(0x80 | payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+        frame.push_back(static_cast<char>(0x80 | 126));
+        frame.push_back(static_cast<char>((payload.size() >> 8) & 0xFF));
+        frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    } else {
+        frame.push_back(static_cast<char>(0x80 | 127));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame.push_back(static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF));
+        }
+    }
+
+    unsigned char mask[4];
+    RAND_bytes(mask, sizeof(mask));
+    frame.append(reinterpret_cast<const char *>(mask), sizeof(mask));
+    for (size_t i = 0; i < payload.size(); ++i) {
+        frame.push_back(static_cast<char>(payload[i] ^ mask[i % 4]));
+    }
+    writeAll(frame.data(), frame.size());
+}
+
+void WebSocketClient::sendText(std::string_view message) {
+    sendFrame(OPCODE_TEXT, message);
+}
+
+bool WebSocketClient::receive(std::string &message, std::chrono::milliseconds timeout) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (true) {
+        size_t available = _buffer.size() - _offset;
+        const auto *data = reinterpret_cast<const unsigned char *>(_buffer.data() + _offset);
+
+        if (available >= 2) {
+            bool fin = (data[0] & 0x80) != 0;
+            uint8_t opcode = data[0] & 0x0F;
+            bool masked = (data[1] & 0x80) != 0;
+            uint64_t length = data[1] & 0x7F;
+            size_t header = 2;
+            if (length == 126 && available >= 4) {
+                length = (static_cast<uint64_t>(data[2]) << 8) | data[3];
+                header = 4;
+            } else if (length == 127 && available >= 10) {
+                length = 0;
+                for (int i = 0; i < 8; ++i) {
+                    length = (length << 8) | data[2 + i];
+                }
+                header = 10;
+            } else if (length >= 126) {
+                header = 0;
+            }
+            size_t maskOffset = header;
+            if (header != 0 && masked) {
+                header += 4;
+            }
+
+            if (header != 0 && available >= header + length) {
+                std::string_view payload(_buffer.data() + _offset + header, length);
+                std::string unmasked;
+                if (masked) {
+                    unmasked.assign(payload);
+                    for (size_t i = 0; i < unmasked.size(); ++i) {
+                        unmasked[i] = static_cast<char>(unmasked[i] ^ data[maskOffset + i % 4]);
+                    }
+                    payload = unmasked;
+                }
+
+                switch (opcode) {
+                    case OPCODE_PING:
+                        sendFrame(OPCODE_PONG, payload);
+                        break;
+                    case OPCODE_PONG:
+                        break;
+                    case OPCODE_CLOSE:
+                        _offset += header + length;
+                        close();
+                        throw std::runtime_error("WebSocket closed by peer");
+                    case OPCODE_TEXT:
+                    case OPCODE_BINARY:
+                    case OPCODE_CONTINUATION:
+                        _fragments.append(payload);
+                        if (fin) {
+                            _offset += header + length;
+                            message.swap(_fragments);
+                            _fragments.clear();
+                            return true;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                _offset += header + length;
+                continue;
+            }
+        }
+
+        if (!fill(deadline)) {
+            return false;
+        }
+    }
+}
@@ -4,7 +4,7 @@
 if /usr/bin/gsutil ls gs://caps-signal-bucket/signal.csv > /dev/null 2>&1; then
     lines=$(/usr/bin/gsutil cat gs://caps-signal-bucket/signal.csv | wc -l)
     if [ "$lines" -gt 1 ]; then
-        /usr/bin/gsutil cat gs://caps-signal-bucket/signal.csv | head -n 2
+        /usr/bin/gsutil cat gs://caps-signal-bucket/signal.csv
     else
         echo "No signals found"
     fi
@@ -0,0 +1,185 @@
+// Replays a signal.csv against a recorded price series and sweeps strategy parameters:
+//
+//   backtest --signals signal.csv --prices prices.csv [--symbol BTCUSDT] [--balance 1000]
+//            [--tick 0.1] [--step 0.001] [--min-notional 100]
+//            [--entry-offset -0.002,-0.001] [--take-profit 0.01,0.014] [--stop-loss -0.01]
+//            [--cancel-delay 600,3301] [--threads N] [--top 20]
+//            [--news news.csv] [--deactivate deactivate.csv] [--env .env]
+//
+// Every combination of the listed values is one run, runs are spread over all cores.
+// prices.csv is `time,price` (epoch ms or "YYYY-mm-dd HH:MM:SS"). Datetimes are read in the
+// local time zone, like the live engine reads signal.csv. News and deactivate windows are
+// padded like live, BLACKOUT_PADDING_* is taken from the --env file.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "backtest.h"
+#include "log.h"
+#include "utils.h"
+
+namespace {
+    struct Options {
+        std::string signalsPath;
+        std::string pricesPath;
+        std::string newsPath;
+        std::string deactivatePath;
+        std::string envPath;
+        Backtest::Config config;
+        std::vector<double> entryOffsets;
+        std::vector<double> takeProfits;
+        std::vector<double> stopLosses;
+        std::vector<long> cancelDelays;
+        size_t threads = 0;
+        size_t top = 20;
+    };
+
+    std::string readFile(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        std::ostringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    template<typename T>
+    std::vector<T> values(const std::string &list) {
+        std::vector<T> parsed;
+        for (const auto &item: Utils::splitList(list)) {
+            if constexpr (std::is_same_v<T, long>) {
+                parsed.push_back(std::stol(item));
+            } else {
+                parsed.push_back(std::stod(item));
+            }
+        }
+        return parsed;
+    }
+
+    std::vector<Strategy::Params> grid(const Options &options) {
+        Strategy::Params defaults;
+        auto or_default = []<typename T>(std::vector<T> list, T value) {
+            return list.empty() ? std::vector<T>{value} : list;
+        };
+
+        std::vector<Strategy::Params> grid;
+        for (double entryOffset: or_default(options.entryOffsets, defaults.entryOffset)) {
+            for (double takeProfit: or_default(options.takeProfits, defaults.takeProfit)) {
+                for (double stopLoss: or_default(options.stopLosses, defaults.stopLoss)) {
+                    for (long cancelDelay: or_default(options.cancelDelays, static_cast<long>(defaults.cancelDelay.count()))) {
+                        Strategy::Params params = defaults;
+                        params.entryOffset = entryOffset;
+                        params.takeProfit = takeProfit;
+                        params.stopLoss = stopLoss;
+                        params.cancelDelay = std::chrono::seconds(cancelDelay);
+                        grid.push_back(params);
+                    }
+                }
+            }
+        }
+        return grid;
+    }
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+        if (arg == "--signals") {
+            options.signalsPath = next();
+        } else if (arg == "--prices") {
+            options.pricesPath = next();
+        } else if (arg == "--symbol") {
+            options.config.symbol = next();
+        } else if (arg == "--balance") {
+            options.config.balance = std::stod(next());
+        } else if (arg == "--tick") {
+            options.config.filters.tickSize = Price::parse(next()).value_or(Price{});
+        } else if (arg == "--step") {
+            options.config.filters.stepSize = Qty::parse(next()).value_or(Qty{});
+        } else if (arg == "--min-notional") {
+            options.config.filters.minNotional = Price::parse(next()).value_or(Price{});
+        } else if (arg == "--entry-offset") {
+            options.entryOffsets = values<double>(next());
+        } else if (arg == "--take-profit") {
+            options.takeProfits = values<double>(next());
+        } else if (arg == "--stop-loss") {
+            options.stopLosses = values<double>(next());
+        } else if (arg == "--cancel-delay") {
+            options.cancelDelays = values<long>(next());
+        } else if (arg == "--news") {
+            options.newsPath = next();
+        } else if (arg == "--deactivate") {
+            options.deactivatePath = next();
+        } else if (arg == "--env") {
+            options.envPath = next();
+        } else if (arg == "--threads") {
+            options.threads = std::stoul(next());
+        } else if (arg == "--top") {
+            options.top = std::stoul(next());
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (options.signalsPath.empty() || options.pricesPath.empty()) {
+        std::cerr << "Usage: backtest --signals signal.csv --prices prices.csv [options]" << std::endl;
+        return 1;
+    }
+
+    BlackoutPaddings paddings;
+    if (!options.envPath.empty()) {
+        paddings = BlackoutPaddings::fromEnv(Utils::loadEnvFile(options.envPath));
+    }
+    if (!options.newsPath.empty()) {
+        options.config.newsBlackout = BlackoutIndex::fromNewsCsv(readFile(options.newsPath), paddings);
+    }
+    if (!options.deactivatePath.empty()) {
+        options.config.deactivateWindows = BlackoutIndex::fromDeactivateCsv(readFile(options.deactivatePath), paddings);
+    }
+
+    auto signals = Backtest::readSignals(readFile(options.signalsPath), options.config.symbol);
+    auto prices = Backtest::readPrices(readFile(options.pricesPath));
+    if (prices.empty()) {
+        std::cerr << "No prices in " << options.pricesPath << std::endl;
+        return 1;
+    }
+    auto runs = grid(options);
+    // Rows SignalReader could not parse are reported through the log
+    Log::flush();
+    std::cout << signals.size() << " signal rows, " << prices.size() << " prices, "
+              << options.config.newsBlackout.windows().size() + options.config.deactivateWindows.windows().size()
+              << " blackout window(s), " << runs.size() << " run(s)" << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+    auto results = Backtest::sweep(runs, signals, prices, options.config, options.threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::chrono::duration<double> replayed = prices.back().time - prices.front().time;
+    std::cout << "Replayed " << replayed.count() / 3600 << "h " << results.size() << " times in " << elapsed.count() << "s ("
+              << (elapsed.count() > 0 ? replayed.count() * static_cast<double>(results.size()) / elapsed.count() : 0) << "x real time)" << std::endl;
+
+    std::sort(results.begin(), results.end(), [](const Backtest::Result &a, const Backtest::Result &b) {
+        return a.pnl > b.pnl;
+    });
+    results.resize(std::min(results.size(), options.top));
+
+    std::cout << std::left << std::setw(10) << "entry" << std::setw(8) << "tp" << std::setw(8) << "sl" << std::setw(8) << "cancel"
+              << std::right << std::setw(8) << "signals" << std::setw(8) << "entries" << std::setw(7) << "fills"
+              << std::setw(5) << "tp" << std::setw(5) << "sl" << std::setw(7) << "cancel"
+              << std::setw(12) << "pnl" << std::setw(10) << "fees" << std::setw(10) << "max dd" << std::endl;
+    for (const auto &result: results) {
+        const auto &params = result.params;
+        std::cout << std::left << std::setw(10) << params.entryOffset << std::setw(8) << params.takeProfit << std::setw(8) << params.stopLoss
+                  << std::setw(8) << params.cancelDelay.count()
+                  << std::right << std::setw(8) << result.signals << std::setw(8) << result.entries << std::setw(7) << result.fills
+                  << std::setw(5) << result.takeProfits << std::setw(5) << result.stopLosses << std::setw(7) << result.canceled
+                  << std::fixed << std::setprecision(2) << std::setw(12) << result.pnl << std::setw(10) << result.fees
+                  << std::setw(10) << result.maxDrawdown << std::defaultfloat << std::endl;
+    }
+}
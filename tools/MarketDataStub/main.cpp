@@ -0,0 +1,226 @@
+// Local stand-in for the Binance futures market data WebSocket.
+//
+// Serves ws://127.0.0.1:<port>/stream?streams=<symbol>@bookTicker/<symbol>@markPrice@1s
+// with a random-walk book and mark price so MarketData can be exercised offline:
+//
+//   market_data_stub [port] [--price 65000] [--interval-ms 100] [--stall-after-s N] [--drop-after N]
+//
+// --stall-after-s stops sending (without closing) after N seconds to trigger stale detection,
+// --drop-after closes every connection after N messages to trigger reconnects.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+namespace {
+    struct Options {
+        int port = 9443;
+        double price = 65000;
+        int intervalMs = 100;
+        int stallAfterSeconds = 0;
+        int dropAfter = 0;
+    };
+
+    std::string base64(const unsigned char *data, size_t length) {
+        std::string out(4 * ((length + 2) / 3), '\0');
+        out.resize(static_cast<size_t>(EVP_EncodeBlock(reinterpret_cast<unsigned char *>(out.data()), data, static_cast<int>(length))));
+        return out;
+    }
+
+    bool sendAll(int fd, const std::string &data) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+            if (sent <= 0) {
+                return false;
+            }
+            offset += static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    bool sendText(int fd, const std::string &payload) {
+        std::string frame;
+        frame.push_back(static_cast<char>(0x81));
+        if (payload.size() < 126) {
+            frame.push_back(static_cast<char>(payload.size()));
+        } else {
+            frame.push_back(static_cast<char>(126));
+            frame.push_back(static_cast<char>((payload.size() >> 8) & 0xFF));
+            frame.push_back(static_cast<char>(payload.size() & 0xFF));
+        }
+        frame += payload;
+        return sendAll(fd, frame);
+    }
+
+    std::vector<std::string> requestedSymbols(const std::string &request) {
+        // streams=btcusdt@bookTicker/btcusdt@markPrice@1s -> BTCUSDT
+        std::vector<std::string> symbols;
+        size_t start = request.find("streams=");
+        if (start == std::string::npos) {
+            return {"BTCUSDT"};
+        }
+        start += 8;
+        size_t end = request.find_first_of(" \r\n", start);
+        std::string streams = request.substr(start, end - start);
+
+        size_t position = 0;
+        while (position < streams.size()) {
+            size_t next = streams.find('/', position);
+            std::string stream = streams.substr(position, next == std::string::npos ? std::string::npos : next - position);
+            std::string symbol = stream.substr(0, stream.find('@'));
+            for (auto &c: symbol) {
+                c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            }
+            if (!symbol.empty() && std::find(symbols.begin(), symbols.end(), symbol) == symbols.end()) {
+                symbols.push_back(symbol);
+            }
+            if (next == std::string::npos) {
+                break;
+            }
+            position = next + 1;
+        }
+        return symbols;
+    }
+
+    void serve(int fd, Options options) {
+        std::string request;
+        char chunk[4096];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                close(fd);
+                return;
+            }
+            request.append(chunk, static_cast<size_t>(received));
+        }
+
+        size_t keyStart = request.find("Sec-WebSocket-Key: ");
+        if (keyStart == std::string::npos) {
+            sendAll(fd, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
+            close(fd);
+            return;
+        }
+        keyStart += 19;
+        std::string key = request.substr(keyStart, request.find("\r\n", keyStart) - keyStart) +
+                          "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+        unsigned char digest[SHA_DIGEST_LENGTH];
+        SHA1(reinterpret_cast<const unsigned char *>(key.data()), key.size(), digest);
+
+        sendAll(fd, "HTTP/1.1 101 Switching Protocols\r\n"
+                    "Upgrade: websocket\r\n"
+                    "Connection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: " + base64(digest, sizeof(digest)) + "\r\n\r\n");
+
+        auto symbols = requestedSymbols(request);
+        std::vector<double> prices(symbols.size(), options.price);
+        std::mt19937_64 random(std::random_device{}());
+        std::normal_distribution<double> step(0.0, 0.0002);
+
+        auto connected = std::chrono::steady_clock::now();
+        auto lastMark = connected;
+        int sent = 0;
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            bool stalled = options.stallAfterSeconds > 0 && now - connected > std::chrono::seconds(options.stallAfterSeconds);
+            if (!stalled) {
+                long long eventTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::system_clock::now().time_since_epoch()).count();
+                bool sendMark = now - lastMark >= std::chrono::seconds(1);
+                for (size_t i = 0; i < symbols.size(); ++i) {
+                    prices[i] *= 1 + step(random);
+                    std::string name = symbols[i];
+                    for (auto &c: name) {
+                        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                    }
+
+                    std::string book = R"({"stream":")" + name + R"(@bookTicker","data":{"e":"bookTicker","E":)" +
+                                       std::to_string(eventTime) + R"(,"T":)" + std::to_string(eventTime) +
+                                       R"(,"s":")" + symbols[i] + R"(","b":")" + std::to_string(prices[i] - 0.05) +
+                                       R"(","B":"1.500","a":")" + std::to_string(prices[i] + 0.05) + R"(","A":"2.000"}})";
+                    if (!sendText(fd, book)) {
+                        close(fd);
+                        return;
+                    }
+                    ++sent;
+
+                    if (sendMark) {
+                        std::string mark = R"({"stream":")" + name + R"(@markPrice@1s","data":{"e":"markPriceUpdate","E":)" +
+                                           std::to_string(eventTime) + R"(,"s":")" + symbols[i] + R"(","p":")" +
+                                           std::to_string(prices[i]) + R"(","r":"0.00010000","T":)" +
+                                           std::to_string(eventTime) + "}}";
+                        if (!sendText(fd, mark)) {
+                            close(fd);
+                            return;
+                        }
+                        ++sent;
+                    }
+                }
+                if (sendMark) {
+                    lastMark = now;
+                }
+            }
+
+            if (options.dropAfter > 0 && sent >= options.dropAfter) {
+                // Abrupt close without a close frame, like a dropped connection
+                close(fd);
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.intervalMs));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string("0"); };
+        if (arg == "--price") {
+            options.price = std::stod(next());
+        } else if (arg == "--interval-ms") {
+            options.intervalMs = std::stoi(next());
+        } else if (arg == "--stall-after-s") {
+            options.stallAfterSeconds = std::stoi(next());
+        } else if (arg == "--drop-after") {
+            options.dropAfter = std::stoi(next());
+        } else {
+            options.port = std::stoi(arg);
+        }
+    }
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(server, 16) != 0) {
+        std::cerr << "Could not listen on 127.0.0.1:" << options.port << std::endl;
+        return 1;
+    }
+    std::cout << "Market data stub listening on ws://127.0.0.1:" << options.port << std::endl;
+
+    while (true) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        std::thread(serve, client, options).detach();
+    }
+}
@@ -0,0 +1,908 @@
+// Local stand-in for the Binance futures REST API, for integration runs and load tests
+// without the exchange's rate limits and network:
+//
+//   mock_exchange [port] [--account key:secret]... [--symbols BTCUSDT:65000,ETHUSDT:3500]
+//                 [--balance 10000] [--latency-ms 0] [--jitter-ms 0] [--error-rate 0] [--lost-rate 0]
+//                 [--weight-limit 2400] [--order-limit-10s 300] [--order-limit-1m 1200]
+//
+// Point the executor at it with REST_BASE_URL=http://127.0.0.1:<port> and the keys of --account
+// (mock:mock when none is given). Serves ping, time, exchangeInfo, ticker/price, leverageBracket,
+// leverage, account, positionRisk, openOrders, order (new and query), allOpenOrders, batchOrders
+// and listenKey.
+//
+// Signatures and recvWindow are checked like the exchange does (-1022, -1021). Requests count
+// against the weight and per-account order limits, reported in the X-MBX-* headers and answered
+// with 429 and Retry-After once over. Prices random-walk every 100ms: resting limits fill when the
+// price trades through them, stop and take profit orders trigger at market.
+// --latency-ms/--jitter-ms delay every response, --error-rate answers 503 without doing anything,
+// --lost-rate does the work and then answers 503 as if the response got lost.
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "nlohmann/json.hpp"
+#include "hmac.h"
+
+namespace {
+    using json = nlohmann::json;
+
+    struct Options {
+        int port = 8480;
+        std::map<std::string, std::string> accounts;
+        std::vector<std::pair<std::string, double>> symbols{{"BTCUSDT", 65000}};
+        double balance = 10000;
+        int latencyMs = 0;
+        int jitterMs = 0;
+        double errorRate = 0;
+        double lostRate = 0;
+        long weightLimit = 2400;
+        long orderLimit10s = 300;
+        long orderLimit1m = 1200;
+    };
+
+    constexpr double MAKER_FEE = 0.0002;
+    constexpr double TAKER_FEE = 0.0004;
+
+    long long nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    std::string fixed(double value, int decimals) {
+        char digits[64];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, decimals);
+        return std::string(digits, result.ptr);
+    }
+
+    std::string urlDecode(std::string_view value) {
+        std::string out;
+        out.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '%' && i + 2 < value.size()) {
+                int byte = 0;
+                std::from_chars(value.data() + i + 1, value.data() + i + 3, byte, 16);
+                out.push_back(static_cast<char>(byte));
+                i += 2;
+            } else {
+                out.push_back(value[i] == '+' ? ' ' : value[i]);
+            }
+        }
+        return out;
+    }
+
+    std::map<std::string, std::string> parseParams(std::string_view query) {
+        std::map<std::string, std::string> params;
+        while (!query.empty()) {
+            size_t end = query.find('&');
+            std::string_view pair = query.substr(0, end);
+            size_t equals = pair.find('=');
+            if (equals != std::string_view::npos) {
+                params[std::string(pair.substr(0, equals))] = urlDecode(pair.substr(equals + 1));
+            }
+            if (end == std::string_view::npos) {
+                break;
+            }
+            query.remove_prefix(end + 1);
+        }
+        return params;
+    }
+
+    // The whole text as an integer, nullopt for anything else
+    template<typename T>
+    std::optional<T> parseInteger(std::string_view text) {
+        T value{};
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (text.empty() || ec != std::errc() || end != text.data() + text.size()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    struct Request {
+        std::string method;
+        std::string path;
+        // Query string and form body as sent, the signature covers both
+        std::string query;
+        std::string body;
+        std::map<std::string, std::string> headers;
+        std::map<std::string, std::string> params;
+        bool keepAlive = true;
+        // Why the request could not be read, answered with 400 and the connection closed
+        std::string invalid;
+    };
+
+    struct Response {
+        int status = 200;
+        json body = json::object();
+        std::vector<std::pair<std::string, std::string>> headers;
+    };
+
+    Response error(int status, int code, const std::string &msg) {
+        return {status, {{"code", code}, {"msg", msg}}, {}};
+    }
+
+    struct Order {
+        long long orderId = 0;
+        std::string clientOrderId;
+        std::string symbol;
+        std::string side;
+        std::string type;
+        std::string timeInForce;
+        std::string status = "NEW";
+        double price = 0;
+        double stopPrice = 0;
+        double origQty = 0;
+        double executedQty = 0;
+        double avgPrice = 0;
+        bool reduceOnly = false;
+        long long time = 0;
+        long long updateTime = 0;
+    };
+
+    struct Position {
+        double amount = 0;
+        double entryPrice = 0;
+        int leverage = 20;
+    };
+
+    struct Market {
+        double price = 0;
+        double tickSize = 0.01;
+    };
+
+    // Fixed one minute / ten second windows like the exchange's counters
+    struct Window {
+        long long start = 0;
+        long count = 0;
+
+        long add(long long now, long long length, long amount) {
+            if (now - start >= length) {
+                start = now - now % length;
+                count = 0;
+            }
+            count += amount;
+            return count;
+        }
+
+        long long retryAfterMs(long long now, long long length) const {
+            return std::max<long long>(0, start + length - now);
+        }
+    };
+
+    struct Account {
+        std::string secret;
+        double wallet = 0;
+        std::map<std::string, Position> positions;
+        std::vector<Order> open;
+        // Every order ever placed, for GET fapi/v1/order
+        std::unordered_map<long long, Order> history;
+        std::unordered_map<std::string, long long> byClientId;
+        Window orders10s;
+        Window orders1m;
+    };
+
+    struct Exchange {
+        std::mutex mutex;
+        std::map<std::string, Market> markets;
+        std::unordered_map<std::string, Account> accounts;
+        Window weight;
+        long long lastOrderId = 1000000;
+        std::atomic<unsigned long> requests{0};
+    };
+
+    Exchange exchange;
+    Options options;
+
+    json orderJson(const Order &order) {
+        int decimals = exchange.markets[order.symbol].tickSize < 0.1 ? 2 : 1;
+        return {
+                {"orderId", order.orderId},
+                {"symbol", order.symbol},
+                {"status", order.status},
+                {"clientOrderId", order.clientOrderId},
+                {"price", fixed(order.price, decimals)},
+                {"avgPrice", fixed(order.avgPrice, decimals)},
+                {"origQty", fixed(order.origQty, 3)},
+                {"executedQty", fixed(order.executedQty, 3)},
+                {"cumQuote", fixed(order.executedQty * order.avgPrice, 5)},
+                {"timeInForce", order.timeInForce},
+                {"type", order.type},
+                {"origType", order.type},
+                {"reduceOnly", order.reduceOnly},
+                {"side", order.side},
+                {"positionSide", "BOTH"},
+                {"stopPrice", fixed(order.stopPrice, decimals)},
+                {"time", order.time},
+                {"updateTime", order.updateTime}
+        };
+    }
+
+    // False when a reduce-only order has nothing left to reduce
+    bool fill(Account &account, Order &order, double price, double fee) {
+        Position &position = account.positions[order.symbol];
+        double quantity = order.side == "BUY" ? order.origQty : -order.origQty;
+        if (order.reduceOnly) {
+            if (position.amount == 0 || (quantity > 0) == (position.amount > 0)) {
+                return false;
+            }
+            quantity = std::copysign(std::min(std::abs(quantity), std::abs(position.amount)), quantity);
+        }
+
+        account.wallet -= std::abs(quantity) * price * fee;
+        if (position.amount == 0 || (quantity > 0) == (position.amount > 0)) {
+            position.entryPrice = (position.entryPrice * std::abs(position.amount) + price * std::abs(quantity)) /
+                                  (std::abs(position.amount) + std::abs(quantity));
+        } else {
+            double closed = std::min(std::abs(quantity), std::abs(position.amount));
+            account.wallet += closed * (price - position.entryPrice) * (position.amount > 0 ? 1 : -1);
+            if (std::abs(quantity) > std::abs(position.amount)) {
+                position.entryPrice = price;
+            }
+        }
+        position.amount += quantity;
+        if (std::abs(position.amount) < 1e-9) {
+            position.amount = 0;
+            position.entryPrice = 0;
+        }
+
+        order.status = "FILLED";
+        order.executedQty = std::abs(quantity);
+        order.avgPrice = price;
+        order.updateTime = nowMs();
+        account.history[order.orderId] = order;
+        return true;
+    }
+
+    // Limits that the price traded through fill at their price, triggers at market
+    void match(Account &account, const std::string &symbol, double price) {
+        for (size_t i = 0; i < account.open.size();) {
+            Order &order = account.open[i];
+            if (order.symbol != symbol) {
+                ++i;
+                continue;
+            }
+
+            bool buy = order.side == "BUY";
+            bool done = false;
+            if (order.type == "LIMIT") {
+                done = buy ? price <= order.price : price >= order.price;
+                if (done) {
+                    fill(account, order, order.price, MAKER_FEE);
+                }
+            } else {
+                bool takeProfit = order.type.starts_with("TAKE_PROFIT");
+                done = (buy != takeProfit) ? price >= order.stopPrice : price <= order.stopPrice;
+                if (done && !fill(account, order, price, TAKER_FEE)) {
+                    order.status = "EXPIRED";
+                    order.updateTime = nowMs();
+                    account.history[order.orderId] = order;
+                }
+            }
+
+            if (done) {
+                account.open.erase(account.open.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    // Validates and places one order, the error object when it was rejected
+    json placeOrder(Account &account, const std::map<std::string, std::string> &params) {
+        auto param = [&params](const std::string &name) {
+            auto itr = params.find(name);
+            return itr == params.end() ? std::string() : itr->second;
+        };
+        auto number = [&param](const std::string &name) {
+            std::string text = param(name);
+            double value = 0;
+            std::from_chars(text.data(), text.data() + text.size(), value);
+            return value;
+        };
+        auto reject = [](int code, const std::string &msg) {
+            return json{{"code", code}, {"msg", msg}};
+        };
+
+        auto market = exchange.markets.find(param("symbol"));
+        if (market == exchange.markets.end()) {
+            return reject(-1121, "Invalid symbol.");
+        }
+        for (const char *name: {"side", "type", "quantity"}) {
+            if (param(name).empty()) {
+                return reject(-1102, std::string("Mandatory parameter '") + name + "' was not sent, was empty/null, or malformed.");
+            }
+        }
+
+        Order order;
+        order.symbol = market->first;
+        order.side = param("side");
+        order.type = param("type");
+        order.timeInForce = param("timeInForce").empty() ? "GTC" : param("timeInForce");
+        order.origQty = number("quantity");
+        order.price = number("price");
+        order.stopPrice = number("stopPrice");
+        order.reduceOnly = param("reduceOnly") == "true";
+        order.clientOrderId = param("newClientOrderId");
+        if (order.side != "BUY" && order.side != "SELL") {
+            return reject(-1117, "Invalid side.");
+        }
+        if (order.origQty <= 0) {
+            return reject(-4003, "Quantity less than or equal to zero.");
+        }
+
+        double price = market->second.price;
+        bool buy = order.side == "BUY";
+        if (order.type == "LIMIT") {
+            if (order.price <= 0) {
+                return reject(-4001, "Price less than 0.");
+            }
+        } else if (order.type == "STOP_MARKET" || order.type == "TAKE_PROFIT_MARKET") {
+            bool takeProfit = order.type == "TAKE_PROFIT_MARKET";
+            bool triggered = (buy != takeProfit) ? price >= order.stopPrice : price <= order.stopPrice;
+            if (order.stopPrice <= 0 || triggered) {
+                return reject(-2021, "Order would immediately trigger.");
+            }
+        } else if (order.type != "MARKET") {
+            return reject(-1116, "Invalid orderType.");
+        }
+
+        const Position &position = account.positions[order.symbol];
+        if (order.reduceOnly && (position.amount == 0 || (position.amount > 0) == buy)) {
+            return reject(-2022, "ReduceOnly Order is rejected.");
+        }
+        if (!order.clientOrderId.empty() && account.byClientId.contains(order.clientOrderId)) {
+            auto existing = account.history.find(account.byClientId[order.clientOrderId]);
+            if (existing != account.history.end() && (existing->second.status == "NEW" || existing->second.status == "PARTIALLY_FILLED")) {
+                return reject(-4116, "ClientOrderId is duplicated.");
+            }
+        }
+        if (order.clientOrderId.empty()) {
+            order.clientOrderId = "mock-" + std::to_string(exchange.lastOrderId + 1);
+        }
+
+        order.orderId = ++exchange.lastOrderId;
+        order.time = order.updateTime = nowMs();
+        account.byClientId[order.clientOrderId] = order.orderId;
+        account.history[order.orderId] = order;
+
+        bool marketable = order.type == "MARKET" || (order.type == "LIMIT" && (buy ? order.price >= price : order.price <= price));
+        if (marketable) {
+            if (!fill(account, order, price, TAKER_FEE)) {
+                order.status = "EXPIRED";
+                account.history[order.orderId] = order;
+            }
+        } else {
+            account.open.push_back(order);
+        }
+        return orderJson(order);
+    }
+
+    int weightOf(const Request &request) {
+        bool perSymbol = request.params.contains("symbol");
+        if (request.path == "fapi/v1/order") {
+            return request.method == "POST" ? 0 : 1;
+        }
+        if (request.path == "fapi/v1/batchOrders") {
+            return 5;
+        }
+        if (request.path == "fapi/v1/openOrders") {
+            return perSymbol ? 1 : 40;
+        }
+        if (request.path == "fapi/v1/ticker/price") {
+            return perSymbol ? 1 : 2;
+        }
+        if (request.path == "fapi/v2/positionRisk" || request.path == "fapi/v2/account") {
+            return 5;
+        }
+        if (request.path == "fapi/v1/leverageBracket") {
+            return perSymbol ? 1 : 40;
+        }
+        return 1;
+    }
+
+    // The signature covers query and body up to "&signature=", the timestamp has to be within recvWindow
+    std::optional<Response> authenticate(const Request &request, bool signedEndpoint, Account *&account) {
+        auto key = request.headers.find("x-mbx-apikey");
+        auto itr = key == request.headers.end() ? exchange.accounts.end() : exchange.accounts.find(key->second);
+        if (itr == exchange.accounts.end()) {
+            return error(401, -2015, "Invalid API-key, IP, or permissions for action.");
+        }
+        account = &itr->second;
+        if (!signedEndpoint) {
+            return std::nullopt;
+        }
+
+        std::string payload = request.query + request.body;
+        size_t signatureAt = payload.find("signature=");
+        if (signatureAt == std::string::npos) {
+            return error(400, -1102, "Mandatory parameter 'signature' was not sent, was empty/null, or malformed.");
+        }
+        std::string signature = payload.substr(signatureAt + 10, payload.find('&', signatureAt) - signatureAt - 10);
+        payload.erase(signatureAt == 0 ? 0 : signatureAt - 1);
+
+        char expected[Utils::HmacSha256::HEX_SIZE];
+        Utils::HmacSha256::forThread(account->secret).signHex(payload, expected);
+        if (signature != std::string_view(expected, sizeof(expected))) {
+            return error(400, -1022, "Signature for this request is not valid.");
+        }
+
+        auto timestamp = request.params.find("timestamp");
+        if (timestamp == request.params.end()) {
+            return error(400, -1102, "Mandatory parameter 'timestamp' was not sent, was empty/null, or malformed.");
+        }
+        auto recvWindow = request.params.find("recvWindow");
+        auto sent = parseInteger<long long>(timestamp->second);
+        if (!sent) {
+            return error(400, -1100, "Illegal characters found in parameter 'timestamp'.");
+        }
+        auto window = recvWindow == request.params.end() ? std::optional<long long>(5000) : parseInteger<long long>(recvWindow->second);
+        if (!window) {
+            return error(400, -1100, "Illegal characters found in parameter 'recvWindow'.");
+        }
+        long long now = nowMs();
+        if (*sent > now + 1000 || now - *sent > *window) {
+            return error(400, -1021, "Timestamp for this request is outside of the recvWindow.");
+        }
+        return std::nullopt;
+    }
+
+    Response route(Request &request, bool &lost) {
+        const std::string &path = request.path;
+        const std::string &method = request.method;
+        long long now = nowMs();
+
+        if (path == "fapi/v1/ping") {
+            return {};
+        }
+        if (path == "fapi/v1/time") {
+            return {200, {{"serverTime", now}}, {}};
+        }
+
+        static thread_local std::mt19937_64 random(std::random_device{}());
+        std::uniform_real_distribution<double> chance(0, 1);
+        if (chance(random) < options.errorRate) {
+            return error(503, -1001, "Internal error; unable to process your request. Please try again.");
+        }
+
+        std::lock_guard<std::mutex> lock(exchange.mutex);
+        long used = exchange.weight.add(now, 60000, weightOf(request));
+        Response response;
+        if (used > options.weightLimit) {
+            response = error(429, -1003, "Too many requests; current limit is " + std::to_string(options.weightLimit) + " request weight per 1 MINUTE.");
+            response.headers.emplace_back("Retry-After", std::to_string((exchange.weight.retryAfterMs(now, 60000) + 999) / 1000));
+            response.headers.emplace_back("X-MBX-USED-WEIGHT-1M", std::to_string(used));
+            return response;
+        }
+
+        if (path == "fapi/v1/exchangeInfo") {
+            json symbols = json::array();
+            for (const auto &[symbol, market]: exchange.markets) {
+                int decimals = market.tickSize < 0.1 ? 2 : 1;
+                symbols.push_back({
+                        {"symbol", symbol},
+                        {"status", "TRADING"},
+                        {"filters", {
+                                {{"filterType", "PRICE_FILTER"}, {"tickSize", fixed(market.tickSize, decimals)},
+                                        {"minPrice", fixed(market.tickSize, decimals)}, {"maxPrice", "4529764"}},
+                                {{"filterType", "LOT_SIZE"}, {"stepSize", "0.001"}, {"minQty", "0.001"}, {"maxQty", "1000"}},
+                                {{"filterType", "MARKET_LOT_SIZE"}, {"stepSize", "0.001"}, {"minQty", "0.001"}, {"maxQty", "120"}},
+                                {{"filterType", "MIN_NOTIONAL"}, {"notional", "5"}}
+                        }}
+                });
+            }
+            response.body = {{"timezone", "UTC"}, {"serverTime", now}, {"symbols", symbols}};
+        } else if (path == "fapi/v1/ticker/price") {
+            auto symbol = request.params.find("symbol");
+            if (symbol == request.params.end()) {
+                response.body = json::array();
+                for (const auto &[name, market]: exchange.markets) {
+                    response.body.push_back({{"symbol", name}, {"price", fixed(market.price, 2)}, {"time", now}});
+                }
+            } else if (exchange.markets.contains(symbol->second)) {
+                response.body = {{"symbol", symbol->second}, {"price", fixed(exchange.markets[symbol->second].price, 2)}, {"time", now}};
+            } else {
+                response = error(400, -1121, "Invalid symbol.");
+            }
+        } else {
+            bool signedEndpoint = path != "fapi/v1/listenKey";
+            Account *account = nullptr;
+            if (auto rejected = authenticate(request, signedEndpoint, account)) {
+                response = std::move(*rejected);
+            } else if (path == "fapi/v1/listenKey") {
+                response.body = method == "DELETE" ? json::object() : json{{"listenKey", "mock-" + request.headers["x-mbx-apikey"]}};
+            } else if (path == "fapi/v2/account") {
+                double unrealized = 0;
+                for (const auto &[symbol, position]: account->positions) {
+                    unrealized += position.amount * (exchange.markets[symbol].price - position.entryPrice);
+                }
+                response.body = {
+                        {"assets", {{{"asset", "USDT"}, {"walletBalance", fixed(account->wallet, 8)},
+                                            {"availableBalance", fixed(account->wallet + std::min(0.0, unrealized), 8)},
+                                            {"marginBalance", fixed(account->wallet + unrealized, 8)}}}},
+                        {"positions", json::array()}
+                };
+            } else if (path == "fapi/v2/positionRisk") {
+                response.body = json::array();
+                for (const auto &[symbol, market]: exchange.markets) {
+                    if (request.params.contains("symbol") && request.params["symbol"] != symbol) {
+                        continue;
+                    }
+                    const Position &position = account->positions[symbol];
+                    response.body.push_back({
+                            {"symbol", symbol}, {"positionSide", "BOTH"},
+                            {"positionAmt", fixed(position.amount, 3)}, {"entryPrice", fixed(position.entryPrice, 2)},
+                            {"markPrice", fixed(market.price, 2)}, {"notional", fixed(position.amount * market.price, 8)},
+                            {"unRealizedProfit", fixed(position.amount * (market.price - position.entryPrice), 8)},
+                            {"leverage", std::to_string(position.leverage)}
+                    });
+                }
+            } else if (path == "fapi/v1/openOrders") {
+                response.body = json::array();
+                for (const auto &order: account->open) {
+                    if (!request.params.contains("symbol") || request.params["symbol"] == order.symbol) {
+                        response.body.push_back(orderJson(order));
+                    }
+                }
+            } else if (path == "fapi/v1/leverageBracket") {
+                response.body = json::array();
+                for (const auto &[symbol, market]: exchange.markets) {
+                    if (!request.params.contains("symbol") || request.params["symbol"] == symbol) {
+                        response.body.push_back({{"symbol", symbol}, {"brackets", {{
+                                {"bracket", 1}, {"initialLeverage", 125}, {"notionalCap", 50000},
+                                {"notionalFloor", 0}, {"maintMarginRatio", 0.004}, {"cum", 0}
+                        }}}});
+                    }
+                }
+            } else if (path == "fapi/v1/leverage" && method == "POST") {
+                auto parsed = parseInteger<int>(request.params["leverage"]);
+                int leverage = parsed.value_or(0);
+                if (!request.params.contains("leverage")) {
+                    response = error(400, -1102, "Mandatory parameter 'leverage' was not sent, was empty/null, or malformed.");
+                } else if (!parsed) {
+                    response = error(400, -1100, "Illegal characters found in parameter 'leverage'.");
+                } else if (!exchange.markets.contains(request.params["symbol"])) {
+                    response = error(400, -1121, "Invalid symbol.");
+                } else if (leverage < 1 || leverage > 125) {
+                    response = error(400, -4028, "Leverage " + std::to_string(leverage) + " is not valid");
+                } else {
+                    account->positions[request.params["symbol"]].leverage = leverage;
+                    response.body = {{"leverage", leverage}, {"maxNotionalValue", "50000"}, {"symbol", request.params["symbol"]}};
+                }
+            } else if (path == "fapi/v1/allOpenOrders" && method == "DELETE") {
+                std::erase_if(account->open, [&](Order &order) {
+                    if (order.symbol != request.params["symbol"]) {
+                        return false;
+                    }
+                    order.status = "CANCELED";
+                    order.updateTime = now;
+                    account->history[order.orderId] = order;
+                    return true;
+                });
+                response.body = {{"code", 200}, {"msg", "The operation of cancel all open order is done."}};
+            } else if (path == "fapi/v1/order" && method == "GET") {
+                long long orderId = 0;
+                bool malformed = false;
+                if (request.params.contains("orderId")) {
+                    auto parsed = parseInteger<long long>(request.params["orderId"]);
+                    malformed = !parsed;
+                    orderId = parsed.value_or(0);
+                } else if (account->byClientId.contains(request.params["origClientOrderId"])) {
+                    orderId = account->byClientId[request.params["origClientOrderId"]];
+                }
+                auto order = account->history.find(orderId);
+                if (malformed) {
+                    response = error(400, -1100, "Illegal characters found in parameter 'orderId'.");
+                } else if (order == account->history.end()) {
+                    response = error(400, -2013, "Order does not exist.");
+                } else {
+                    response.body = orderJson(order->second);
+                }
+            } else if ((path == "fapi/v1/order" || path == "fapi/v1/batchOrders") && method == "POST") {
+                json legs = path == "fapi/v1/batchOrders" ? json::parse(request.params["batchOrders"], nullptr, false) : json();
+                size_t count = legs.is_array() ? legs.size() : 1;
+                long count10s = account->orders10s.add(now, 10000, static_cast<long>(count));
+                long count1m = account->orders1m.add(now, 60000, static_cast<long>(count));
+                response.headers.emplace_back("X-MBX-ORDER-COUNT-10S", std::to_string(count10s));
+                response.headers.emplace_back("X-MBX-ORDER-COUNT-1M", std::to_string(count1m));
+
+                if (path == "fapi/v1/batchOrders" && (!legs.is_array() || legs.empty() || legs.size() > 5)) {
+                    response = error(400, -1102, "Mandatory parameter 'batchOrders' was not sent, was empty/null, or malformed.");
+                } else if (count10s > options.orderLimit10s || count1m > options.orderLimit1m) {
+                    auto headers = response.headers;
+                    response = error(429, -1015, "Too many new orders.");
+                    response.headers = headers;
+                    long long wait = count10s > options.orderLimit10s ? account->orders10s.retryAfterMs(now, 10000)
+                                                                      : account->orders1m.retryAfterMs(now, 60000);
+                    response.headers.emplace_back("Retry-After", std::to_string((wait + 999) / 1000));
+                } else if (path == "fapi/v1/order") {
+                    response.body = placeOrder(*account, request.params);
+                    if (response.body.contains("code")) {
+                        response.status = 400;
+                    }
+                } else {
+                    response.body = json::array();
+                    for (const auto &leg: legs) {
+                        std::map<std::string, std::string> params;
+                        for (const auto &[name, value]: leg.items()) {
+                            params[name] = value.is_string() ? value.get<std::string>() : value.dump();
+                        }
+                        response.body.push_back(placeOrder(*account, params));
+                    }
+                }
+                lost = response.status == 200 && chance(random) < options.lostRate;
+            } else {
+                response = error(404, -1000, "Unknown endpoint " + method + " /" + path);
+            }
+        }
+
+        response.headers.emplace_back("X-MBX-USED-WEIGHT-1M", std::to_string(used));
+        return response;
+    }
+
+    bool sendAll(int fd, const std::string &data) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+            if (sent <= 0) {
+                return false;
+            }
+            offset += static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    // Next request off a keep-alive connection, false once the client is gone
+    bool readRequest(int fd, std::string &buffer, Request &request) {
+        char chunk[8192];
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+
+        std::string_view head(buffer.data(), headerEnd);
+        size_t lineEnd = head.find("\r\n");
+        std::string_view line = head.substr(0, lineEnd);
+        size_t methodEnd = line.find(' ');
+        size_t targetEnd = line.find(' ', methodEnd + 1);
+        if (methodEnd == std::string_view::npos || targetEnd == std::string_view::npos) {
+            return false;
+        }
+        request = Request{};
+        request.method = line.substr(0, methodEnd);
+        std::string_view target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+        if (target.starts_with('/')) {
+            target.remove_prefix(1);
+        }
+        size_t question = target.find('?');
+        request.path = target.substr(0, question);
+        if (question != std::string_view::npos) {
+            request.query = target.substr(question + 1);
+        }
+
+        while (lineEnd != std::string_view::npos && lineEnd < head.size()) {
+            size_t next = head.find("\r\n", lineEnd + 2);
+            std::string_view header = head.substr(lineEnd + 2, next == std::string_view::npos ? head.npos : next - lineEnd - 2);
+            size_t colon = header.find(':');
+            if (colon != std::string_view::npos) {
+                std::string name(header.substr(0, colon));
+                std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+                std::string_view value = header.substr(colon + 1);
+                value.remove_prefix(std::min(value.find_first_not_of(' '), value.size()));
+                request.headers[name] = value;
+            }
+            lineEnd = next;
+        }
+
+        auto length = request.headers.contains("content-length") ? parseInteger<size_t>(request.headers["content-length"]) : std::optional<size_t>(0);
+        if (!length) {
+            // Where the body ends is unknown, nothing after the head can be read
+            buffer.clear();
+            request.invalid = "Malformed Content-Length header.";
+            request.keepAlive = false;
+            return true;
+        }
+        while (buffer.size() < headerEnd + 4 + *length) {
+            ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+        request.body = buffer.substr(headerEnd + 4, *length);
+        buffer.erase(0, headerEnd + 4 + *length);
+
+        request.params = parseParams(request.query);
+        for (auto &[name, value]: parseParams(request.body)) {
+            request.params[name] = std::move(value);
+        }
+        request.keepAlive = request.headers["connection"] != "close";
+        return true;
+    }
+
+    const char *reason(int status) {
+        switch (status) {
+            case 200:
+                return "OK";
+            case 400:
+                return "Bad Request";
+            case 401:
+                return "Unauthorized";
+            case 404:
+                return "Not Found";
+            case 429:
+                return "Too Many Requests";
+            default:
+                return "Service Unavailable";
+        }
+    }
+
+    void serve(int fd) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        static thread_local std::mt19937_64 random(std::random_device{}());
+        std::uniform_int_distribution<int> jitter(0, std::max(0, options.jitterMs));
+
+        std::string buffer;
+        Request request;
+        while (readRequest(fd, buffer, request)) {
+            ++exchange.requests;
+            bool lost = false;
+            Response response = request.invalid.empty() ? route(request, lost) : error(400, -1100, request.invalid);
+            if (lost) {
+                response = error(503, -1007, "Timeout waiting for response from backend server. Send status unknown; execution status unknown.");
+            }
+
+            int delay = options.latencyMs + (options.jitterMs > 0 ? jitter(random) : 0);
+            if (delay > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+            }
+
+            std::string body = response.body.dump();
+            std::string out = "HTTP/1.1 " + std::to_string(response.status) + " " + reason(response.status) + "\r\n"
+                              "Content-Type: application/json\r\n"
+                              "Content-Length: " + std::to_string(body.size()) + "\r\n";
+            for (const auto &[name, value]: response.headers) {
+                out += name + ": " + value + "\r\n";
+            }
+            out += request.keepAlive ? "\r\n" : "Connection: close\r\n\r\n";
+            out += body;
+            if (!sendAll(fd, out) || !request.keepAlive) {
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    // Random walk of every symbol, resting orders are matched against each step
+    void walkPrices() {
+        std::mt19937_64 random(std::random_device{}());
+        std::normal_distribution<double> step(0.0, 0.0002);
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::lock_guard<std::mutex> lock(exchange.mutex);
+            for (auto &[symbol, market]: exchange.markets) {
+                market.price = std::max(market.tickSize, std::round(market.price * (1 + step(random)) / market.tickSize) * market.tickSize);
+                for (auto &[key, account]: exchange.accounts) {
+                    match(account, symbol, market.price);
+                }
+            }
+        }
+    }
+
+    void reportRate() {
+        unsigned long last = 0;
+        while (true) {
+            std::this_thread::sleep_for(std::chrono::seconds(10));
+            unsigned long total = exchange.requests.load();
+            if (total != last) {
+                std::cout << (total - last) / 10 << " requests/s, " << total << " total" << std::endl;
+            }
+            last = total;
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string("0"); };
+        if (arg == "--account") {
+            std::string account = next();
+            size_t colon = account.find(':');
+            options.accounts[account.substr(0, colon)] = colon == std::string::npos ? "" : account.substr(colon + 1);
+        } else if (arg == "--symbols") {
+            options.symbols.clear();
+            std::string list = next();
+            size_t position = 0;
+            while (position <= list.size()) {
+                size_t end = std::min(list.find(',', position), list.size());
+                std::string item = list.substr(position, end - position);
+                size_t colon = item.find(':');
+                if (!item.empty()) {
+                    options.symbols.emplace_back(item.substr(0, colon), colon == std::string::npos ? 100 : std::stod(item.substr(colon + 1)));
+                }
+                position = end + 1;
+            }
+        } else if (arg == "--balance") {
+            options.balance = std::stod(next());
+        } else if (arg == "--latency-ms") {
+            options.latencyMs = std::stoi(next());
+        } else if (arg == "--jitter-ms") {
+            options.jitterMs = std::stoi(next());
+        } else if (arg == "--error-rate") {
+            options.errorRate = std::stod(next());
+        } else if (arg == "--lost-rate") {
+            options.lostRate = std::stod(next());
+        } else if (arg == "--weight-limit") {
+            options.weightLimit = std::stol(next());
+        } else if (arg == "--order-limit-10s") {
+            options.orderLimit10s = std::stol(next());
+        } else if (arg == "--order-limit-1m") {
+            options.orderLimit1m = std::stol(next());
+        } else if (!arg.empty() && std::all_of(arg.begin(), arg.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            options.port = std::stoi(arg);
+        } else {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            std::cerr << "Usage: mock_exchange [port] [--account key:secret]... [--symbols SYM:price,...] [options]" << std::endl;
+            return 1;
+        }
+    }
+    if (options.accounts.empty()) {
+        options.accounts["mock"] = "mock";
+    }
+    for (const auto &[key, secret]: options.accounts) {
+        exchange.accounts[key].secret = secret;
+        exchange.accounts[key].wallet = options.balance;
+    }
+    // Ticks like the exchange's: 0.1 from 1000 up, 0.01 below
+    for (const auto &[symbol, price]: options.symbols) {
+        exchange.markets[symbol] = {price, price >= 1000 ? 0.1 : 0.01};
+    }
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(server, 512) != 0) {
+        std::cerr << "Could not listen on 127.0.0.1:" << options.port << std::endl;
+        return 1;
+    }
+    std::cout << "Mock exchange listening on http://127.0.0.1:" << options.port << " with " << options.accounts.size()
+              << " account(s) and " << options.symbols.size() << " symbol(s)" << std::endl;
+
+    std::thread(walkPrices).detach();
+    std::thread(reportRate).detach();
+    while (true) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        std::thread(serve, client).detach();
+    }
+}